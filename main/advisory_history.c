@@ -0,0 +1,539 @@
+#include "advisory_history.h"
+#include "app_config.h"
+#include "image_rle.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "esp_rom_crc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <ctype.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+static const char TAG[] = "history";
+
+#define HISTORY_MAGIC 0x54534948  // "HIST"
+#define HISTORY_KEYFRAME 0
+#define HISTORY_DELTA 1
+#define HISTORY_BLK 2             // RLE block = one RGB565 pixel
+#define HISTORY_MAX_RECORDS 32    // Upper bound of CONFIG_ADVISORY_HISTORY_DEPTH
+
+// On-flash record header, followed by payload_size bytes of RLE data
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint8_t type;
+    uint8_t reserved;
+    uint16_t width;
+    uint16_t height;
+    uint16_t reserved2;
+    uint32_t frame_crc;     // CRC32 of the decoded frame, used to skip repeated advisories
+    uint32_t payload_size;
+    int64_t timestamp;
+} history_record_t;
+
+typedef struct {
+    size_t payload_offset;
+    history_record_t hdr;
+} record_ref_t;
+
+struct history_player {
+    uint8_t *file;
+    size_t file_size;
+    record_ref_t records[HISTORY_MAX_RECORDS];
+    int count;
+    int current;
+    uint8_t *frame;
+    size_t frame_size;
+    lv_image_dsc_t dsc;
+};
+
+// s_lock is held only while a history file is read, appended to or replaced,
+// so readers never wait for a frame being encoded. s_write_lock keeps
+// history_record() calls apart for the whole of the encode.
+static SemaphoreHandle_t s_lock = NULL;
+static SemaphoreHandle_t s_write_lock = NULL;
+
+static void history_path(const char *storm_id, char *path, size_t len)
+{
+    snprintf(path, len, HISTORY_DIR "/%s.bin", storm_id);
+}
+
+// Read a whole history file into PSRAM
+static esp_err_t load_file(const char *path, uint8_t **data, size_t *size)
+{
+    *data = NULL;
+    *size = 0;
+
+    struct stat st;
+    if (stat(path, &st) != 0 || st.st_size == 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    uint8_t *buf = heap_caps_malloc(st.st_size, MALLOC_CAP_SPIRAM);
+    if (buf == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate %ld bytes for %s", st.st_size, path);
+        return ESP_ERR_NO_MEM;
+    }
+
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        free(buf);
+        return ESP_FAIL;
+    }
+    size_t n = fread(buf, 1, st.st_size, f);
+    fclose(f);
+    if (n != (size_t)st.st_size) {
+        free(buf);
+        return ESP_FAIL;
+    }
+
+    *data = buf;
+    *size = n;
+    return ESP_OK;
+}
+
+// Index the records in a file image. A truncated tail (e.g. power loss mid-append) is ignored.
+static int index_records(const uint8_t *data, size_t size, record_ref_t *refs, int max)
+{
+    size_t off = 0;
+    int count = 0;
+
+    while (count < max && off + sizeof(history_record_t) <= size) {
+        history_record_t hdr;
+        memcpy(&hdr, data + off, sizeof(hdr));
+        if (hdr.magic != HISTORY_MAGIC || off + sizeof(hdr) + hdr.payload_size > size) {
+            break;
+        }
+        if (count == 0 && hdr.type != HISTORY_KEYFRAME) {
+            break;
+        }
+        refs[count].hdr = hdr;
+        refs[count].payload_offset = off + sizeof(hdr);
+        off += sizeof(hdr) + hdr.payload_size;
+        count++;
+    }
+
+    return count;
+}
+
+// Rebuild the frame of record 'upto' by decoding the keyframe and applying deltas
+static esp_err_t decode_frame(const uint8_t *data, const record_ref_t *refs, int upto,
+                              uint8_t *frame, size_t frame_size)
+{
+    if (rle_decode(data + refs[0].payload_offset, refs[0].hdr.payload_size,
+                   frame, frame_size, HISTORY_BLK) != frame_size) {
+        return ESP_ERR_INVALID_CRC;
+    }
+    for (int i = 1; i <= upto; i++) {
+        if (rle_decode_xor(data + refs[i].payload_offset, refs[i].hdr.payload_size,
+                           frame, frame_size, HISTORY_BLK) != frame_size) {
+            return ESP_ERR_INVALID_CRC;
+        }
+    }
+    return ESP_OK;
+}
+
+static esp_err_t write_record(FILE *f, uint8_t type, uint16_t w, uint16_t h, uint32_t crc,
+                              int64_t timestamp, const uint8_t *payload, size_t payload_size)
+{
+    const history_record_t hdr = {
+        .magic = HISTORY_MAGIC,
+        .type = type,
+        .width = w,
+        .height = h,
+        .frame_crc = crc,
+        .payload_size = payload_size,
+        .timestamp = timestamp,
+    };
+    if (fwrite(&hdr, 1, sizeof(hdr), f) != sizeof(hdr) ||
+        fwrite(payload, 1, payload_size, f) != payload_size) {
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+// Move a fully written temporary file over path; readers only wait for the rename
+static esp_err_t replace_file(const char *tmp_path, const char *path)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    int ret = rename(tmp_path, path);
+    xSemaphoreGive(s_lock);
+    if (ret != 0) {
+        remove(tmp_path);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+// Drop the oldest advisories so at most 'depth' remain. The new first record is
+// re-encoded as a keyframe; the deltas after it are copied unchanged.
+static esp_err_t trim_history(const char *path, int depth)
+{
+    uint8_t *data = NULL;
+    size_t size = 0;
+    record_ref_t refs[HISTORY_MAX_RECORDS];
+    uint8_t *frame = NULL;
+    uint8_t *enc = NULL;
+    FILE *f = NULL;
+    char tmp_path[64];
+    esp_err_t err = load_file(path, &data, &size);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    int count = index_records(data, size, refs, HISTORY_MAX_RECORDS);
+    int drop = count - depth;
+    if (drop <= 0) {
+        free(data);
+        return ESP_OK;
+    }
+
+    const history_record_t *head = &refs[drop].hdr;
+    size_t frame_size = (size_t)head->width * head->height * HISTORY_BLK;
+    size_t enc_cap = RLE_MAX_ENCODED_SIZE(frame_size, HISTORY_BLK);
+    frame = heap_caps_malloc(frame_size, MALLOC_CAP_SPIRAM);
+    enc = heap_caps_malloc(enc_cap, MALLOC_CAP_SPIRAM);
+    if (frame == NULL || enc == NULL) {
+        err = ESP_ERR_NO_MEM;
+        goto cleanup;
+    }
+
+    err = decode_frame(data, refs, drop, frame, frame_size);
+    if (err != ESP_OK) {
+        goto cleanup;
+    }
+    size_t enc_len = rle_encode(frame, frame_size, enc, enc_cap, HISTORY_BLK);
+
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    f = fopen(tmp_path, "wb");
+    if (f == NULL) {
+        err = ESP_FAIL;
+        goto cleanup;
+    }
+    err = write_record(f, HISTORY_KEYFRAME, head->width, head->height, head->frame_crc,
+                       head->timestamp, enc, enc_len);
+    for (int i = drop + 1; i < count && err == ESP_OK; i++) {
+        size_t rec_size = sizeof(history_record_t) + refs[i].hdr.payload_size;
+        if (fwrite(data + refs[i].payload_offset - sizeof(history_record_t), 1, rec_size, f) != rec_size) {
+            err = ESP_FAIL;
+        }
+    }
+    fclose(f);
+
+    if (err != ESP_OK) {
+        remove(tmp_path);
+    } else {
+        err = replace_file(tmp_path, path);
+    }
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG, "Trimmed %d old advisories from %s", drop, path);
+    }
+
+cleanup:
+    free(enc);
+    free(frame);
+    free(data);
+    return err;
+}
+
+esp_err_t history_init(void)
+{
+    if (s_lock == NULL) {
+        s_lock = xSemaphoreCreateMutex();
+        s_write_lock = xSemaphoreCreateMutex();
+        if (s_lock == NULL || s_write_lock == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    if (mkdir(HISTORY_DIR, 0755) != 0 && errno != EEXIST) {
+        ESP_LOGE(TAG, "Failed to create %s", HISTORY_DIR);
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "Advisory history enabled, keeping %d advisories per storm", HISTORY_DEPTH);
+    return ESP_OK;
+}
+
+bool history_storm_id_from_url(const char *url, char *id, size_t len)
+{
+    if (url == NULL || len < HISTORY_STORM_ID_LEN) {
+        return false;
+    }
+
+    // Cone graphics are named like .../AL052024_5day_cone_with_line_and_wind_sm2.png
+    const char *base = strrchr(url, '/');
+    base = base ? base + 1 : url;
+
+    size_t n = 0;
+    while (base[n] != '\0' && base[n] != '_' && base[n] != '.' && n < len - 1) {
+        n++;
+    }
+    if (n != 8 || !isalpha((unsigned char)base[0]) || !isalpha((unsigned char)base[1])) {
+        return false;
+    }
+    for (size_t i = 2; i < n; i++) {
+        if (!isdigit((unsigned char)base[i])) {
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        id[i] = (char)toupper((unsigned char)base[i]);
+    }
+    id[n] = '\0';
+    return true;
+}
+
+esp_err_t history_record(const char *storm_id, const lv_image_dsc_t *img, time_t timestamp)
+{
+    if (s_lock == NULL || storm_id == NULL || img == NULL || img->data == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (img->header.cf != LV_COLOR_FORMAT_RGB565) {
+        ESP_LOGD(TAG, "Skipping non-RGB565 frame for %s", storm_id);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    const uint16_t w = img->header.w;
+    const uint16_t h = img->header.h;
+    const size_t frame_size = (size_t)w * h * HISTORY_BLK;
+    if (img->data_size < frame_size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    char path[64];
+    history_path(storm_id, path, sizeof(path));
+    uint32_t crc = esp_rom_crc32_le(0, img->data, frame_size);
+
+    uint8_t *data = NULL;
+    size_t size = 0;
+    uint8_t *frame = NULL;
+    uint8_t *enc = NULL;
+    record_ref_t refs[HISTORY_MAX_RECORDS];
+    int count = 0;
+    esp_err_t err = ESP_OK;
+
+    // Only history_record() changes the files, so it reads this one without s_lock
+    xSemaphoreTake(s_write_lock, portMAX_DELAY);
+
+    if (load_file(path, &data, &size) == ESP_OK) {
+        count = index_records(data, size, refs, HISTORY_MAX_RECORDS);
+    }
+
+    if (count > 0 && refs[count - 1].hdr.frame_crc == crc) {
+        ESP_LOGD(TAG, "%s unchanged since last advisory", storm_id);
+        goto cleanup;
+    }
+    if (count > 0 && (refs[0].hdr.width != w || refs[0].hdr.height != h)) {
+        ESP_LOGW(TAG, "%s frame size changed, restarting history", storm_id);
+        count = 0;
+    }
+
+    size_t enc_cap = RLE_MAX_ENCODED_SIZE(frame_size, HISTORY_BLK);
+    enc = heap_caps_malloc(enc_cap, MALLOC_CAP_SPIRAM);
+    if (enc == NULL) {
+        err = ESP_ERR_NO_MEM;
+        goto cleanup;
+    }
+
+    if (count == 0) {
+        // First advisory (or reset): full keyframe replaces the file
+        size_t enc_len = rle_encode(img->data, frame_size, enc, enc_cap, HISTORY_BLK);
+        char tmp_path[64];
+        snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+        FILE *f = fopen(tmp_path, "wb");
+        if (f == NULL) {
+            err = ESP_FAIL;
+            goto cleanup;
+        }
+        err = write_record(f, HISTORY_KEYFRAME, w, h, crc, timestamp, enc, enc_len);
+        fclose(f);
+        if (err != ESP_OK) {
+            remove(tmp_path);
+            goto cleanup;
+        }
+        err = replace_file(tmp_path, path);
+        ESP_LOGI(TAG, "%s: keyframe %zu -> %zu bytes", storm_id, frame_size, enc_len);
+        goto cleanup;
+    }
+
+    // Delta = previous frame XOR current frame; unchanged pixels become zero runs
+    frame = heap_caps_malloc(frame_size, MALLOC_CAP_SPIRAM);
+    if (frame == NULL) {
+        err = ESP_ERR_NO_MEM;
+        goto cleanup;
+    }
+    err = decode_frame(data, refs, count - 1, frame, frame_size);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "%s history corrupt, restarting", storm_id);
+        xSemaphoreTake(s_lock, portMAX_DELAY);
+        remove(path);
+        xSemaphoreGive(s_lock);
+        goto cleanup;
+    }
+    const uint32_t *cur = (const uint32_t *)img->data;
+    uint32_t *prev = (uint32_t *)frame;
+    for (size_t i = 0; i < frame_size / sizeof(uint32_t); i++) {
+        prev[i] ^= cur[i];
+    }
+    for (size_t i = frame_size & ~(sizeof(uint32_t) - 1); i < frame_size; i++) {
+        frame[i] ^= img->data[i];
+    }
+
+    size_t enc_len = rle_encode(frame, frame_size, enc, enc_cap, HISTORY_BLK);
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    FILE *f = fopen(path, "ab");
+    if (f != NULL) {
+        err = write_record(f, HISTORY_DELTA, w, h, crc, timestamp, enc, enc_len);
+        fclose(f);
+    }
+    xSemaphoreGive(s_lock);
+    if (f == NULL) {
+        err = ESP_FAIL;
+        goto cleanup;
+    }
+    count++;
+    ESP_LOGI(TAG, "%s: advisory %d stored as %zu byte delta", storm_id, count, enc_len);
+
+    if (err == ESP_OK && count > HISTORY_DEPTH) {
+        free(data);
+        data = NULL;
+        err = trim_history(path, HISTORY_DEPTH);
+    }
+
+cleanup:
+    xSemaphoreGive(s_write_lock);
+    free(enc);
+    free(frame);
+    free(data);
+    return err;
+}
+
+int history_count(const char *storm_id)
+{
+    if (s_lock == NULL || storm_id == NULL) {
+        return 0;
+    }
+
+    char path[64];
+    history_path(storm_id, path, sizeof(path));
+    int count = 0;
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    FILE *f = fopen(path, "rb");
+    if (f != NULL) {
+        history_record_t hdr;
+        while (count < HISTORY_MAX_RECORDS && fread(&hdr, 1, sizeof(hdr), f) == sizeof(hdr) &&
+               hdr.magic == HISTORY_MAGIC && fseek(f, hdr.payload_size, SEEK_CUR) == 0) {
+            count++;
+        }
+        fclose(f);
+    }
+    xSemaphoreGive(s_lock);
+
+    return count;
+}
+
+history_player_t *history_player_open(const char *storm_id)
+{
+    if (s_lock == NULL || storm_id == NULL) {
+        return NULL;
+    }
+
+    history_player_t *p = heap_caps_calloc(1, sizeof(history_player_t), MALLOC_CAP_SPIRAM);
+    if (p == NULL) {
+        return NULL;
+    }
+
+    char path[64];
+    history_path(storm_id, path, sizeof(path));
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    esp_err_t err = load_file(path, &p->file, &p->file_size);
+    xSemaphoreGive(s_lock);
+    if (err != ESP_OK) {
+        free(p);
+        return NULL;
+    }
+
+    p->count = index_records(p->file, p->file_size, p->records, HISTORY_MAX_RECORDS);
+    if (p->count == 0) {
+        history_player_close(p);
+        return NULL;
+    }
+
+    const history_record_t *key = &p->records[0].hdr;
+    p->frame_size = (size_t)key->width * key->height * HISTORY_BLK;
+    p->frame = heap_caps_malloc(p->frame_size, MALLOC_CAP_SPIRAM);
+    if (p->frame == NULL) {
+        history_player_close(p);
+        return NULL;
+    }
+
+    p->current = -1;
+    p->dsc.header.magic = LV_IMAGE_HEADER_MAGIC;
+    p->dsc.header.cf = LV_COLOR_FORMAT_RGB565;
+    p->dsc.header.w = key->width;
+    p->dsc.header.h = key->height;
+    p->dsc.header.stride = key->width * HISTORY_BLK;
+    p->dsc.data = p->frame;
+    p->dsc.data_size = p->frame_size;
+
+    ESP_LOGI(TAG, "Loaded %d advisories for %s (%zu bytes compressed, %zu per frame)",
+             p->count, storm_id, p->file_size, p->frame_size);
+    return p;
+}
+
+int history_player_count(const history_player_t *player)
+{
+    return player ? player->count : 0;
+}
+
+const lv_image_dsc_t *history_player_seek(history_player_t *player, int index)
+{
+    if (player == NULL || index < 0 || index >= player->count) {
+        return NULL;
+    }
+
+    if (player->current < 0) {
+        const record_ref_t *key = &player->records[0];
+        if (rle_decode(player->file + key->payload_offset, key->hdr.payload_size,
+                       player->frame, player->frame_size, HISTORY_BLK) != player->frame_size) {
+            return NULL;
+        }
+        player->current = 0;
+    }
+
+    // XOR deltas are their own inverse, so stepping backwards applies the same record
+    while (player->current < index) {
+        const record_ref_t *rec = &player->records[++player->current];
+        rle_decode_xor(player->file + rec->payload_offset, rec->hdr.payload_size,
+                       player->frame, player->frame_size, HISTORY_BLK);
+    }
+    while (player->current > index) {
+        const record_ref_t *rec = &player->records[player->current--];
+        rle_decode_xor(player->file + rec->payload_offset, rec->hdr.payload_size,
+                       player->frame, player->frame_size, HISTORY_BLK);
+    }
+
+    return &player->dsc;
+}
+
+time_t history_player_timestamp(const history_player_t *player, int index)
+{
+    if (player == NULL || index < 0 || index >= player->count) {
+        return 0;
+    }
+    return (time_t)player->records[index].hdr.timestamp;
+}
+
+void history_player_close(history_player_t *player)
+{
+    if (player == NULL) {
+        return;
+    }
+    free(player->frame);
+    free(player->file);
+    free(player);
+}
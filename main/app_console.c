@@ -0,0 +1,250 @@
+#include "app_console.h"
+#include "app_config.h"
+#include "http_client.h"
+#include "perf_bench.h"
+#include "perf_probe.h"
+#include "boot_profile.h"
+#include "freshness.h"
+#include "stage_budget.h"
+#include "retry_policy.h"
+#include "net_timing.h"
+#include "trace.h"
+#include "esp_console.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "sdkconfig.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char TAG[] = "console";
+
+// Pipeline control (implemented in main.c)
+void app_request_update(bool refresh_feed);
+esp_err_t app_set_dwell_ms(uint32_t dwell_ms);
+uint32_t app_get_dwell_ms(void);
+esp_err_t app_rotation_bench(int rounds);
+
+// Optional positive count argument; returns -1 if it is not a number
+static int count_arg(int argc, char **argv, int fallback)
+{
+    if (argc < 2) {
+        return fallback;
+    }
+    char *end;
+    long n = strtol(argv[1], &end, 10);
+    return (*end == '\0' && n > 0 && n <= 100000) ? (int)n : -1;
+}
+
+static int cmd_update(int argc, char **argv)
+{
+    bool feed = true;
+    if (argc >= 2) {
+        if (strcmp(argv[1], "images") == 0) {
+            feed = false;
+        } else if (strcmp(argv[1], "feed") != 0) {
+            printf("usage: update [feed|images]\n");
+            return 1;
+        }
+    }
+    app_request_update(feed);
+    printf("Update queued (%s)\n", feed ? "feed and images" : "images only");
+    return 0;
+}
+
+static int cmd_bench_parse(int argc, char **argv)
+{
+    int runs = count_arg(argc, argv, CONSOLE_BENCH_DEFAULT_RUNS);
+    if (runs < 0) {
+        printf("usage: bench_parse [runs]\n");
+        return 1;
+    }
+
+    http_download_t feed;
+    esp_err_t err = http_copy_cached_feed(&feed);
+    if (err != ESP_OK) {
+        printf("No cached feed: %s\n", err == ESP_ERR_NOT_FOUND ? "none fetched yet" : esp_err_to_name(err));
+        return 1;
+    }
+    perf_bench_parse(&feed, runs);
+    http_download_free(&feed);
+    return 0;
+}
+
+static int cmd_bench_sinks(int argc, char **argv)
+{
+    int runs = count_arg(argc, argv, 1);
+    if (runs < 0) {
+        printf("usage: bench_sinks [runs]\n");
+        return 1;
+    }
+    return perf_bench_sinks(runs) == ESP_OK ? 0 : 1;
+}
+
+static int cmd_bench_rotation(int argc, char **argv)
+{
+    int rounds = count_arg(argc, argv, 1);
+    if (rounds < 0 || rounds > CONSOLE_ROTATION_MAX_ROUNDS) {
+        printf("usage: bench_rotation [rounds], at most %d rounds\n", CONSOLE_ROTATION_MAX_ROUNDS);
+        return 1;
+    }
+
+    esp_err_t err = app_rotation_bench(rounds);
+    if (err == ESP_ERR_NOT_FOUND) {
+        printf("No images to rotate through yet\n");
+    } else if (err == ESP_ERR_INVALID_STATE) {
+        printf("Screen busy (history view or download in progress), try again later\n");
+    }
+    return err == ESP_OK ? 0 : 1;
+}
+
+static int cmd_metrics(int argc, char **argv)
+{
+    boot_profile_print();
+    freshness_report();
+    budget_report();
+    retry_report();
+    net_timing_report();
+#if ENABLE_PERF_PROBES
+    perf_probe_report();
+#endif
+    return 0;
+}
+
+static void print_heap_totals(const char *name, uint32_t caps)
+{
+    size_t total = heap_caps_get_total_size(caps);
+    if (total == 0) {
+        return;
+    }
+    printf("%-9s total %7zu  free %7zu  min free %7zu  largest block %7zu\n", name, total,
+           heap_caps_get_free_size(caps), heap_caps_get_minimum_free_size(caps),
+           heap_caps_get_largest_free_block(caps));
+}
+
+static int cmd_heap(int argc, char **argv)
+{
+    if (argc < 2) {
+        print_heap_totals("internal", MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        print_heap_totals("dma", MALLOC_CAP_DMA);
+        print_heap_totals("psram", MALLOC_CAP_SPIRAM);
+        return 0;
+    }
+
+    // Per-region map of one capability
+    uint32_t caps;
+    if (strcmp(argv[1], "internal") == 0) {
+        caps = MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+    } else if (strcmp(argv[1], "psram") == 0) {
+        caps = MALLOC_CAP_SPIRAM;
+    } else if (strcmp(argv[1], "dma") == 0) {
+        caps = MALLOC_CAP_DMA;
+    } else {
+        printf("usage: heap [internal|psram|dma]\n");
+        return 1;
+    }
+    heap_caps_print_heap_info(caps);
+    return 0;
+}
+
+static int cmd_trace(int argc, char **argv)
+{
+#if ENABLE_TRACE
+    trace_dump_serial();
+    return 0;
+#else
+    printf("Tracing is not built in (CONFIG_TRACE)\n");
+    return 1;
+#endif
+}
+
+static int cmd_dwell(int argc, char **argv)
+{
+    if (argc >= 2) {
+        int ms = count_arg(argc, argv, 0);
+        if (ms < 0 || app_set_dwell_ms(ms) != ESP_OK) {
+            printf("usage: dwell [ms], at least %d\n", IMAGE_DISPLAY_MIN_INTERVAL_MS);
+            return 1;
+        }
+    }
+    printf("Dwell %lu ms\n", app_get_dwell_ms());
+    return 0;
+}
+
+static int cmd_concurrency(int argc, char **argv)
+{
+    if (argc >= 2) {
+        int n = count_arg(argc, argv, 0);
+        if (n < 0 || http_set_download_concurrency(n) != ESP_OK) {
+            printf("usage: concurrency [1-%d]\n", DOWNLOAD_CONCURRENCY_MAX);
+            return 1;
+        }
+    }
+    printf("%d concurrent downloads\n", http_get_download_concurrency());
+    return 0;
+}
+
+static const esp_console_cmd_t s_commands[] = {
+    { .command = "update", .help = "Run an update cycle now: feed and images (default), or images only",
+      .hint = "[feed|images]", .func = cmd_update },
+    { .command = "bench_parse", .help = "Time the feed parse over the last fetched feed",
+      .hint = "[runs]", .func = cmd_bench_parse },
+    { .command = "bench_sinks", .help = "Time a feed download into each response sink (memory, file, XML, hash)",
+      .hint = "[runs]", .func = cmd_bench_sinks },
+    { .command = "bench_rotation", .help = "Time switching to each valid image (screen rebuild + full render)",
+      .hint = "[rounds]", .func = cmd_bench_rotation },
+    { .command = "metrics", .help = "Print the boot timeline, data freshness, stage budget overruns, retries, network phase timing and hot-path probes",
+      .hint = NULL, .func = cmd_metrics },
+    { .command = "heap", .help = "Print heap totals, or the region map for one capability",
+      .hint = "[internal|psram|dma]", .func = cmd_heap },
+    { .command = "trace", .help = "Print and clear the timeline trace as Chrome trace JSON",
+      .hint = NULL, .func = cmd_trace },
+    { .command = "dwell", .help = "Show or set how long each image stays on screen",
+      .hint = "[ms]", .func = cmd_dwell },
+    { .command = "concurrency", .help = "Show or set how many images are downloaded at once",
+      .hint = "[n]", .func = cmd_concurrency },
+};
+
+esp_err_t app_console_start(void)
+{
+    esp_console_repl_t *repl = NULL;
+    esp_console_repl_config_t repl_config = ESP_CONSOLE_REPL_CONFIG_DEFAULT();
+    repl_config.prompt = CONSOLE_PROMPT;
+    repl_config.task_stack_size = CONSOLE_TASK_STACK_SIZE;
+    repl_config.task_priority = CONSOLE_TASK_PRIORITY;
+
+    esp_err_t err;
+#if defined(CONFIG_ESP_CONSOLE_UART_DEFAULT) || defined(CONFIG_ESP_CONSOLE_UART_CUSTOM)
+    esp_console_dev_uart_config_t hw_config = ESP_CONSOLE_DEV_UART_CONFIG_DEFAULT();
+    err = esp_console_new_repl_uart(&hw_config, &repl_config, &repl);
+#elif defined(CONFIG_ESP_CONSOLE_USB_CDC)
+    esp_console_dev_usb_cdc_config_t hw_config = ESP_CONSOLE_DEV_CDC_CONFIG_DEFAULT();
+    err = esp_console_new_repl_usb_cdc(&hw_config, &repl_config, &repl);
+#elif defined(CONFIG_ESP_CONSOLE_USB_SERIAL_JTAG)
+    esp_console_dev_usb_serial_jtag_config_t hw_config = ESP_CONSOLE_DEV_USB_SERIAL_JTAG_CONFIG_DEFAULT();
+    err = esp_console_new_repl_usb_serial_jtag(&hw_config, &repl_config, &repl);
+#else
+    err = ESP_ERR_NOT_SUPPORTED;
+#endif
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create console REPL: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    esp_console_register_help_command();
+    for (size_t i = 0; i < sizeof(s_commands) / sizeof(s_commands[0]); i++) {
+        err = esp_console_cmd_register(&s_commands[i]);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to register '%s': %s", s_commands[i].command, esp_err_to_name(err));
+            return err;
+        }
+    }
+
+    err = esp_console_start_repl(repl);
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG, "Serial console ready, type 'help' for commands");
+    }
+    return err;
+}
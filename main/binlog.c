@@ -0,0 +1,192 @@
+#include "binlog.h"
+#include "esp_log.h"
+#include "esp_cpu.h"
+#include "esp_timer.h"
+#include "esp_rom_sys.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "sdkconfig.h"
+#include <stdio.h>
+
+static const char TAG[] = "binlog";
+
+typedef struct {
+    esp_log_level_t level;
+    const char *tag;
+    const char *fmt;
+} binlog_msg_info_t;
+
+static const binlog_msg_info_t s_msgs[BINLOG_MSG_COUNT] = {
+#define BINLOG_INFO(id, lvl, tag, fmt) [id] = { ESP_LOG_##lvl, tag, fmt },
+    BINLOG_MESSAGES(BINLOG_INFO)
+#undef BINLOG_INFO
+};
+
+typedef struct {
+    uint32_t timestamp_ms;      // Since boot, like the ESP_LOG timestamp; wraps after 49 days
+    uint16_t msg;
+    uint16_t reserved;
+    uint32_t args[BINLOG_MAX_ARGS];
+} binlog_record_t;
+
+#if ENABLE_DEFERRED_LOG
+// Ring of records; head and tail count records ever written and read
+static binlog_record_t s_ring[BINLOG_RING_RECORDS];
+static uint32_t s_head = 0;
+static uint32_t s_tail = 0;
+#endif
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Per-cycle counters, reset by binlog_cycle_report()
+static uint32_t s_written = 0;
+static uint32_t s_dropped = 0;
+static uint64_t s_record_cycles = 0;    // Spent in binlog_write() on the calling tasks
+static uint64_t s_format_cycles = 0;    // Spent formatting and printing
+
+static TaskHandle_t s_task = NULL;
+static SemaphoreHandle_t s_drained = NULL;
+
+static void print_record(const binlog_record_t *r)
+{
+#if CONFIG_DEFERRED_LOG_RAW
+    // Formatted on the host by tools/binlog/binlog_decode.py
+    printf("BL %08lx %u %lx %lx %lx %lx\n", r->timestamp_ms, r->msg,
+           r->args[0], r->args[1], r->args[2], r->args[3]);
+#else
+    const binlog_msg_info_t *m = &s_msgs[r->msg];
+    static const char letters[] = { 'N', 'E', 'W', 'I', 'D', 'V' };
+    char text[BINLOG_LINE_MAX];
+    snprintf(text, sizeof(text), m->fmt, r->args[0], r->args[1], r->args[2], r->args[3]);
+    esp_log_write(m->level, m->tag, "%c (%lu) %s: %s\n", letters[m->level],
+                  r->timestamp_ms, m->tag, text);
+#endif
+}
+
+void binlog_write(binlog_msg_t msg, uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3)
+{
+    if (msg >= BINLOG_MSG_COUNT || s_msgs[msg].level > CONFIG_LOG_DEFAULT_LEVEL) {
+        return;
+    }
+
+    uint32_t start = esp_cpu_get_cycle_count();
+    binlog_record_t rec = {
+        .timestamp_ms = (uint32_t)(esp_timer_get_time() / 1000),
+        .msg = msg,
+        .args = { a0, a1, a2, a3 },
+    };
+
+#if ENABLE_DEFERRED_LOG
+    portENTER_CRITICAL_SAFE(&s_lock);
+    if (s_head - s_tail < BINLOG_RING_RECORDS) {
+        s_ring[s_head % BINLOG_RING_RECORDS] = rec;
+        s_head++;
+        s_written++;
+    } else {
+        s_dropped++;
+    }
+    s_record_cycles += esp_cpu_get_cycle_count() - start;
+    portEXIT_CRITICAL_SAFE(&s_lock);
+#else
+    print_record(&rec);
+    uint32_t cycles = esp_cpu_get_cycle_count() - start;
+    portENTER_CRITICAL_SAFE(&s_lock);
+    s_written++;
+    s_record_cycles += cycles;
+    s_format_cycles += cycles;
+    portEXIT_CRITICAL_SAFE(&s_lock);
+#endif
+}
+
+#if ENABLE_DEFERRED_LOG
+static void drain(void)
+{
+    while (1) {
+        binlog_record_t rec;
+        portENTER_CRITICAL(&s_lock);
+        if (s_tail == s_head) {
+            portEXIT_CRITICAL(&s_lock);
+            return;
+        }
+        rec = s_ring[s_tail % BINLOG_RING_RECORDS];
+        s_tail++;
+        portEXIT_CRITICAL(&s_lock);
+
+        uint32_t start = esp_cpu_get_cycle_count();
+        print_record(&rec);
+        uint32_t cycles = esp_cpu_get_cycle_count() - start;
+        portENTER_CRITICAL(&s_lock);
+        s_format_cycles += cycles;
+        portEXIT_CRITICAL(&s_lock);
+    }
+}
+
+static void binlog_task(void *pvParameters)
+{
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(BINLOG_DRAIN_PERIOD_MS));
+        drain();
+        xSemaphoreGive(s_drained);
+    }
+}
+#endif
+
+esp_err_t binlog_init(void)
+{
+#if ENABLE_DEFERRED_LOG
+    if (s_task != NULL) {
+        return ESP_OK;
+    }
+    s_drained = xSemaphoreCreateBinary();
+    if (s_drained == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (xTaskCreate(binlog_task, "binlog", BINLOG_TASK_STACK_SIZE, NULL, BINLOG_TASK_PRIORITY, &s_task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create log formatting task");
+        vSemaphoreDelete(s_drained);
+        s_drained = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    ESP_LOGI(TAG, "Deferred logging started, %d record ring (%u bytes)", BINLOG_RING_RECORDS,
+             sizeof(s_ring));
+#endif
+    return ESP_OK;
+}
+
+void binlog_flush(uint32_t timeout_ms)
+{
+    if (s_task == NULL) {
+        return;
+    }
+    xSemaphoreTake(s_drained, 0);
+    xTaskNotifyGive(s_task);
+    xSemaphoreTake(s_drained, pdMS_TO_TICKS(timeout_ms));
+}
+
+void binlog_cycle_report(void)
+{
+    binlog_flush(BINLOG_DRAIN_PERIOD_MS * 5);
+
+    portENTER_CRITICAL(&s_lock);
+    uint32_t written = s_written;
+    uint32_t dropped = s_dropped;
+    uint64_t record_cycles = s_record_cycles;
+    uint64_t format_cycles = s_format_cycles;
+    s_written = 0;
+    s_dropped = 0;
+    s_record_cycles = 0;
+    s_format_cycles = 0;
+    portEXIT_CRITICAL(&s_lock);
+
+    const uint32_t per_us = esp_rom_get_cpu_ticks_per_us();
+    uint32_t record_us = record_cycles / per_us;
+    uint32_t format_us = format_cycles / per_us;
+    if (ENABLE_DEFERRED_LOG) {
+        ESP_LOGI(TAG, "Cycle log: %lu records (%lu dropped), %lu us recording on the calling tasks, "
+                 "%lu us formatting deferred (%lu us saved)", written, dropped, record_us, format_us,
+                 format_us > record_us ? format_us - record_us : 0);
+    } else {
+        ESP_LOGI(TAG, "Cycle log: %lu records, %lu us formatting inline on the calling tasks",
+                 written, format_us);
+    }
+}
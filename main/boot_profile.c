@@ -0,0 +1,190 @@
+#include "boot_profile.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "esp_attr.h"
+#include "esp_rom_crc.h"
+#include "freertos/FreeRTOS.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char TAG[] = "boot_profile";
+
+#define BOOT_RECORD_MAGIC 0x42545046    // "BTPF"
+
+typedef struct {
+    uint32_t magic;
+    uint32_t boot_count;
+    int32_t reset_reason;               // esp_reset_reason_t that started this boot
+    uint32_t marks_ms[BOOT_PHASE_COUNT]; // 0 if not reached
+    uint32_t crc;
+} boot_record_t;
+
+// [0] is this boot, [1] the one before it
+static RTC_NOINIT_ATTR boot_record_t s_records[2];
+
+static const char *const s_phase_names[BOOT_PHASE_COUNT] = {
+    [BOOT_PHASE_NVS] = "nvs",
+    [BOOT_PHASE_LCD] = "lcd",
+    [BOOT_PHASE_TOUCH] = "touch",
+    [BOOT_PHASE_LVGL] = "lvgl",
+    [BOOT_PHASE_WIFI] = "wifi",
+    [BOOT_PHASE_TIME_SYNC] = "time_sync",
+    [BOOT_PHASE_FEED] = "feed",
+    [BOOT_PHASE_FIRST_VALID] = "first_valid",
+    [BOOT_PHASE_FIRST_PIXEL] = "first_pixel",
+    [BOOT_PHASE_FIRST_SHOWN] = "first_shown",
+};
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static volatile uint32_t s_pending = 0; // Phases stamped by the next rendered frame
+static bool s_reported = false;
+
+static uint32_t record_crc(const boot_record_t *r)
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)r, offsetof(boot_record_t, crc));
+}
+
+static bool record_valid(const boot_record_t *r)
+{
+    return r->magic == BOOT_RECORD_MAGIC && r->crc == record_crc(r);
+}
+
+// Last phase reached, or -1
+static int last_phase(const boot_record_t *r)
+{
+    int last = -1;
+    for (int i = 0; i < BOOT_PHASE_COUNT; i++) {
+        if (r->marks_ms[i] != 0 && (last < 0 || r->marks_ms[i] >= r->marks_ms[last])) {
+            last = i;
+        }
+    }
+    return last;
+}
+
+void boot_profile_init(void)
+{
+    uint32_t boot_count = 1;
+    if (record_valid(&s_records[0])) {
+        s_records[1] = s_records[0];
+        boot_count = s_records[0].boot_count + 1;
+    } else {
+        // Power-on, or RTC memory lost
+        memset(&s_records[1], 0, sizeof(s_records[1]));
+    }
+
+    boot_record_t *cur = &s_records[0];
+    memset(cur, 0, sizeof(*cur));
+    cur->magic = BOOT_RECORD_MAGIC;
+    cur->boot_count = boot_count;
+    cur->reset_reason = esp_reset_reason();
+    cur->crc = record_crc(cur);
+
+    const boot_record_t *prev = &s_records[1];
+    if (prev->magic == BOOT_RECORD_MAGIC) {
+        int last = last_phase(prev);
+        if (last >= 0) {
+            ESP_LOGI(TAG, "Boot %lu (reset reason %ld); previous boot reached %s at %lu ms",
+                     boot_count, cur->reset_reason, s_phase_names[last], prev->marks_ms[last]);
+        } else {
+            ESP_LOGI(TAG, "Boot %lu (reset reason %ld); previous boot reset before its first phase",
+                     boot_count, cur->reset_reason);
+        }
+    } else {
+        ESP_LOGI(TAG, "Boot %lu (reset reason %ld), no previous boot record", boot_count, cur->reset_reason);
+    }
+}
+
+void boot_profile_mark(boot_phase_t phase)
+{
+    if (phase >= BOOT_PHASE_COUNT) {
+        return;
+    }
+    uint32_t ms = (uint32_t)(esp_timer_get_time() / 1000);
+    if (ms == 0) {
+        ms = 1;     // 0 means not reached
+    }
+
+    portENTER_CRITICAL_SAFE(&s_lock);
+    boot_record_t *cur = &s_records[0];
+    if (cur->marks_ms[phase] == 0) {
+        cur->marks_ms[phase] = ms;
+        cur->crc = record_crc(cur);
+    }
+    portEXIT_CRITICAL_SAFE(&s_lock);
+}
+
+static void render_ready_cb(lv_event_t *e)
+{
+    uint32_t pending = s_pending;
+    s_pending = 0;
+    for (int i = 0; pending != 0; i++, pending >>= 1) {
+        if (pending & 1) {
+            boot_profile_mark((boot_phase_t)i);
+        }
+    }
+}
+
+void boot_profile_mark_next_frame(boot_phase_t phase)
+{
+    if (phase < BOOT_PHASE_COUNT && s_records[0].marks_ms[phase] == 0) {
+        s_pending |= 1u << phase;
+    }
+}
+
+void boot_profile_watch_display(lv_display_t *disp)
+{
+    if (disp != NULL) {
+        lv_display_add_event_cb(disp, render_ready_cb, LV_EVENT_RENDER_READY, NULL);
+    }
+}
+
+static void print_timeline(const boot_record_t *cur, bool metrics_line)
+{
+    ESP_LOGI(TAG, "Boot %lu timeline (ms since app start):", cur->boot_count);
+    char metrics[256];
+    int len = snprintf(metrics, sizeof(metrics), "BOOT_METRICS boot=%lu reason=%ld",
+                       cur->boot_count, cur->reset_reason);
+    uint32_t prev_ms = 0;
+    for (int i = 0; i < BOOT_PHASE_COUNT; i++) {
+        uint32_t ms = cur->marks_ms[i];
+        if (ms == 0) {
+            ESP_LOGI(TAG, "  %-12s %8s", s_phase_names[i], "-");
+            continue;
+        }
+        ESP_LOGI(TAG, "  %-12s %8lu  (+%lu)", s_phase_names[i], ms, ms >= prev_ms ? ms - prev_ms : 0);
+        prev_ms = ms;
+        if (len < (int)sizeof(metrics)) {
+            len += snprintf(metrics + len, sizeof(metrics) - len, " %s=%lu", s_phase_names[i], ms);
+        }
+    }
+    if (metrics_line) {
+        ESP_LOGI(TAG, "%s", metrics);
+    }
+}
+
+void boot_profile_report(bool force)
+{
+    boot_record_t cur;
+    portENTER_CRITICAL(&s_lock);
+    cur = s_records[0];
+    portEXIT_CRITICAL(&s_lock);
+
+    if (s_reported || (!force && cur.marks_ms[BOOT_PHASE_FIRST_SHOWN] == 0)) {
+        return;
+    }
+    s_reported = true;
+    print_timeline(&cur, true);
+}
+
+void boot_profile_print(void)
+{
+    boot_record_t cur;
+    portENTER_CRITICAL(&s_lock);
+    cur = s_records[0];
+    portEXIT_CRITICAL(&s_lock);
+
+    // No BOOT_METRICS line, so a console dump does not count as another boot
+    print_timeline(&cur, false);
+}
@@ -0,0 +1,231 @@
+#include "codec_bench.h"
+#include "app_config.h"
+#include "http_client.h"
+#include "image_codec.h"
+#include "image_rle.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_app_desc.h"
+#include "esp_lvgl_port.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char TAG[] = "codec_bench";
+
+// Defined in main.c
+extern char* image_urls[MAX_IMAGES];
+extern int active_image_count;
+
+#define BENCH_SCRATCH_PIXELS (800 * 480)
+
+// One candidate format, as requested from the conversion API
+typedef struct {
+    const char *name;
+    const char *encoding;   // NULL for formats derived on the device
+} bench_format_t;
+
+static const bench_format_t s_formats[] = {
+    { "RGB565",        "\"cf\": \"RGB565\", \"output\": \"bin\", \"bigEndian\": false" },
+    { "RGB565 dither", "\"cf\": \"RGB565\", \"dither\": \"true\", \"output\": \"bin\", \"bigEndian\": false" },
+    { "I8",            "\"cf\": \"I8\", \"dither\": \"true\", \"output\": \"bin\"" },
+    { "I4",            "\"cf\": \"I4\", \"dither\": \"true\", \"output\": \"bin\"" },
+    { "RLE (history)", NULL },
+    { "LVGL RLE",      "\"cf\": \"RGB565\", \"dither\": \"true\", \"output\": \"bin\", \"compress\": \"RLE\"" },
+    { "LVGL LZ4",      "\"cf\": \"RGB565\", \"dither\": \"true\", \"output\": \"bin\", \"compress\": \"LZ4\"" },
+    { "JPEG q50",      "\"output\": \"jpg\", \"quality\": 50" },
+    { "JPEG q75",      "\"output\": \"jpg\", \"quality\": 75" },
+    { "JPEG q90",      "\"output\": \"jpg\", \"quality\": 90" },
+};
+
+#define FORMAT_COUNT ((int)(sizeof(s_formats) / sizeof(s_formats[0])))
+#define FORMAT_DITHERED_RGB565 1
+#define FORMAT_HISTORY_RLE 4
+
+// Accumulated over the corpus for one format
+typedef struct {
+    uint32_t images;
+    uint64_t encoded_bytes;
+    uint64_t decoded_bytes;
+    uint64_t total_us;
+    uint32_t max_us;
+    uint64_t touched_bytes;
+} bench_row_t;
+
+static bench_row_t s_rows[FORMAT_COUNT];
+static uint16_t *s_scratch = NULL;
+
+static void add_sample(bench_row_t *row, size_t encoded, size_t decoded, uint32_t us, size_t touched)
+{
+    row->images++;
+    row->encoded_bytes += encoded;
+    row->decoded_bytes += decoded;
+    row->total_us += us;
+    if (us > row->max_us) {
+        row->max_us = us;
+    }
+    row->touched_bytes += touched;
+}
+
+// Decode one API response to RGB565 and time it. Plain RGB565 is shown in
+// place, so it costs nothing at load time.
+static esp_err_t decode_sample(const uint8_t *data, size_t len, size_t *decoded, uint32_t *us, size_t *touched)
+{
+    if (image_codec_is_jpeg(data, len)) {
+        uint8_t *out = NULL;
+        size_t out_size = 0;
+        esp_err_t err = image_codec_decode_jpeg(data, len, &out, &out_size, us);
+        if (err == ESP_OK) {
+            *decoded = out_size - IMAGE_HEADER_SIZE;
+            *touched = len + *decoded;
+            free(out);
+        }
+        return err;
+    }
+
+    if (len < IMAGE_HEADER_SIZE || data[0] != LVGL_MAGIC_NUMBER) {
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    lv_image_dsc_t dsc = {0};
+    memcpy(&dsc.header, data, sizeof(dsc.header));
+    dsc.data = data + IMAGE_HEADER_SIZE;
+    dsc.data_size = len - IMAGE_HEADER_SIZE;
+    *decoded = (size_t)dsc.header.w * dsc.header.h * sizeof(uint16_t);
+    if (*decoded > BENCH_SCRATCH_PIXELS * sizeof(uint16_t)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    int64_t t0 = esp_timer_get_time();
+    if (dsc.header.flags & LV_IMAGE_FLAGS_COMPRESSED) {
+        // LVGL decompresses into its own buffer; needs LV_USE_RLE / LV_USE_LZ4_INTERNAL
+        lv_image_decoder_dsc_t dec;
+        lvgl_port_lock(0);
+        lv_result_t res = lv_image_decoder_open(&dec, &dsc, NULL);
+        if (res == LV_RESULT_OK) {
+            lv_image_decoder_close(&dec);
+        }
+        lvgl_port_unlock();
+        if (res != LV_RESULT_OK) {
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+        *touched = len + *decoded;
+    } else if (image_codec_is_indexed(dsc.header.cf)) {
+        uint16_t lut[256];
+        image_codec_build_palette_lut(dsc.data, image_codec_palette_entries(dsc.header.cf), lut);
+        image_codec_expand_indexed(&dsc, lut, s_scratch);
+        *touched = len + *decoded;
+    } else {
+        *touched = 0;
+    }
+    *us = (uint32_t)(esp_timer_get_time() - t0);
+    return ESP_OK;
+}
+
+// The history store's RLE, encoded on the device from the dithered RGB565 variant
+static void bench_history_rle(const uint8_t *data, size_t len)
+{
+    const uint8_t *pixels = data + IMAGE_HEADER_SIZE;
+    size_t pixel_bytes = len - IMAGE_HEADER_SIZE;
+    if (pixel_bytes > BENCH_SCRATCH_PIXELS * sizeof(uint16_t)) {
+        return;
+    }
+
+    size_t cap = RLE_MAX_ENCODED_SIZE(pixel_bytes, 2);
+    uint8_t *encoded = heap_caps_malloc(cap, MALLOC_CAP_SPIRAM);
+    if (encoded == NULL) {
+        return;
+    }
+    size_t encoded_len = rle_encode(pixels, pixel_bytes, encoded, cap, 2);
+    if (encoded_len > 0) {
+        int64_t t0 = esp_timer_get_time();
+        size_t out = rle_decode(encoded, encoded_len, (uint8_t *)s_scratch, pixel_bytes, 2);
+        uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+        if (out == pixel_bytes) {
+            add_sample(&s_rows[FORMAT_HISTORY_RLE], encoded_len + IMAGE_HEADER_SIZE, out, us,
+                       encoded_len + out);
+        }
+    }
+    free(encoded);
+}
+
+static void print_results(int images)
+{
+    const esp_app_desc_t *app = esp_app_get_description();
+    ESP_LOGI(TAG, "Codec benchmark, firmware %s (%s %s), %d images, max size " IMAGE_MAX_SIZE,
+             app->version, app->date, app->time, images);
+    ESP_LOGI(TAG, "| %-13s | %10s | %6s | %9s | %9s | %12s |",
+             "format", "avg bytes", "ratio", "avg ms", "max ms", "PSRAM B/dec");
+    for (int f = 0; f < FORMAT_COUNT; f++) {
+        const bench_row_t *r = &s_rows[f];
+        if (r->images == 0) {
+            ESP_LOGI(TAG, "| %-13s | %10s | %6s | %9s | %9s | %12s |", s_formats[f].name,
+                     "n/a", "", "", "", "");
+            continue;
+        }
+        ESP_LOGI(TAG, "| %-13s | %10llu | %6.2f | %9.2f | %9.2f | %12llu |", s_formats[f].name,
+                 r->encoded_bytes / r->images,
+                 r->encoded_bytes ? (double)r->decoded_bytes / r->encoded_bytes : 0.0,
+                 r->total_us / 1000.0 / r->images, r->max_us / 1000.0,
+                 r->touched_bytes / r->images);
+    }
+}
+
+esp_err_t codec_bench_run(void)
+{
+    s_scratch = heap_caps_malloc(BENCH_SCRATCH_PIXELS * sizeof(uint16_t), MALLOC_CAP_SPIRAM);
+    if (s_scratch == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate decode scratch buffer");
+        return ESP_ERR_NO_MEM;
+    }
+    memset(s_rows, 0, sizeof(s_rows));
+
+    int images = 0;
+    for (int i = 0; i < active_image_count && i < MAX_IMAGES; i++) {
+        if (image_urls[i] == NULL) {
+            continue;
+        }
+        ESP_LOGI(TAG, "Image %d: %s", i, image_urls[i]);
+        bool any = false;
+
+        for (int f = 0; f < FORMAT_COUNT; f++) {
+            if (s_formats[f].encoding == NULL) {
+                continue;
+            }
+
+            http_download_t resp;
+            if (http_convert_image(image_urls[i], s_formats[f].encoding, &resp) != ESP_OK) {
+                ESP_LOGW(TAG, "%s not available for image %d", s_formats[f].name, i);
+                continue;
+            }
+
+            size_t decoded = 0;
+            size_t touched = 0;
+            uint32_t us = 0;
+            esp_err_t err = decode_sample((const uint8_t *)resp.buffer, resp.buffer_size, &decoded, &us, &touched);
+            if (err == ESP_OK) {
+                add_sample(&s_rows[f], resp.buffer_size, decoded, us, touched);
+                any = true;
+                if (f == FORMAT_DITHERED_RGB565) {
+                    bench_history_rle((const uint8_t *)resp.buffer, resp.buffer_size);
+                }
+            } else {
+                ESP_LOGW(TAG, "%s decode failed for image %d: %s", s_formats[f].name, i, esp_err_to_name(err));
+            }
+            http_download_free(&resp);
+        }
+        if (any) {
+            images++;
+        }
+    }
+
+    free(s_scratch);
+    s_scratch = NULL;
+
+    if (images == 0) {
+        ESP_LOGW(TAG, "No images could be benchmarked");
+        return ESP_FAIL;
+    }
+    print_results(images);
+    return ESP_OK;
+}
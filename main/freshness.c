@@ -0,0 +1,109 @@
+#include "freshness.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char TAG[] = "freshness";
+
+typedef struct {
+    int32_t delay_s[FRESHNESS_SAMPLES];     // Ring of the most recent delays
+    uint32_t count;                         // Samples ever recorded
+} product_window_t;
+
+typedef struct {
+    time_t published;                       // Publication time last recorded for the slot
+    int32_t delay_s;
+} slot_state_t;
+
+static const char *const s_product_names[FRESHNESS_PRODUCT_COUNT] = {
+    [FRESHNESS_PRODUCT_OUTLOOK] = "outlook",
+    [FRESHNESS_PRODUCT_CONE] = "cone",
+};
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static product_window_t s_products[FRESHNESS_PRODUCT_COUNT];
+static slot_state_t s_slots[MAX_IMAGES];
+
+bool freshness_slot_shown(freshness_product_t product, int slot, time_t published, int32_t *delay_s)
+{
+    if (delay_s) {
+        *delay_s = -1;
+    }
+    if (product >= FRESHNESS_PRODUCT_COUNT || slot < 0 || slot >= MAX_IMAGES || published <= 0) {
+        return false;
+    }
+
+    time_t now = time(NULL);
+    slot_state_t *st = &s_slots[slot];
+    bool recorded = false;
+    int32_t delay;
+
+    portENTER_CRITICAL(&s_lock);
+    if (st->published != published && now >= CLOCK_VALID_EPOCH) {
+        // A slightly fast NHC clock must not produce a negative delay
+        st->published = published;
+        st->delay_s = now > published ? (int32_t)(now - published) : 0;
+        product_window_t *w = &s_products[product];
+        w->delay_s[w->count % FRESHNESS_SAMPLES] = st->delay_s;
+        w->count++;
+        recorded = true;
+    }
+    delay = st->published == published ? st->delay_s : -1;
+    portEXIT_CRITICAL(&s_lock);
+
+    bool stale = delay > FRESHNESS_STALE_MINUTES * 60;
+    if (recorded) {
+        if (stale) {
+            ESP_LOGW(TAG, "Slot %d (%s) reached the screen %ld min after publication", slot,
+                     s_product_names[product], delay / 60);
+        } else {
+            ESP_LOGI(TAG, "Slot %d (%s) reached the screen %ld s after publication", slot,
+                     s_product_names[product], delay);
+        }
+    }
+    if (delay_s) {
+        *delay_s = delay;
+    }
+    return stale;
+}
+
+static int compare_int32(const void *a, const void *b)
+{
+    int32_t x = *(const int32_t *)a;
+    int32_t y = *(const int32_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of n sorted samples
+static int32_t percentile(const int32_t *sorted, uint32_t n, uint32_t pct)
+{
+    uint32_t rank = (pct * n + 99) / 100;
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+void freshness_report(void)
+{
+    int32_t sorted[FRESHNESS_SAMPLES];
+
+    for (int p = 0; p < FRESHNESS_PRODUCT_COUNT; p++) {
+        portENTER_CRITICAL(&s_lock);
+        uint32_t total = s_products[p].count;
+        uint32_t n = total < FRESHNESS_SAMPLES ? total : FRESHNESS_SAMPLES;
+        memcpy(sorted, s_products[p].delay_s, n * sizeof(sorted[0]));
+        portEXIT_CRITICAL(&s_lock);
+
+        if (n == 0) {
+            continue;
+        }
+        qsort(sorted, n, sizeof(sorted[0]), compare_int32);
+        int32_t p50 = percentile(sorted, n, 50);
+        int32_t p95 = percentile(sorted, n, 95);
+        int32_t max = sorted[n - 1];
+
+        ESP_LOGI(TAG, "%-7s publication to screen over last %lu: p50 %ld min, p95 %ld min, max %ld min (%lu total)",
+                 s_product_names[p], n, p50 / 60, p95 / 60, max / 60, total);
+        ESP_LOGI(TAG, "FRESHNESS product=%s n=%lu p50=%ld p95=%ld max=%ld",
+                 s_product_names[p], n, p50, p95, max);
+    }
+}
@@ -1,11 +1,23 @@
 #include "http_client.h"
 #include "xml_parse.h"
 #include "app_config.h"
+#include "perf_probe.h"
+#include "binlog.h"
+#include "trace.h"
+#include "stage_budget.h"
+#include "retry_policy.h"
+#include "http_engine.h"
+#include "http_transfer.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "esp_http_client.h"
 #include "esp_crt_bundle.h"
+#include "esp_rom_crc.h"
 #include "cJSON.h"
 #include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
 #include <string.h>
 #include <stdlib.h>
 
@@ -16,8 +28,18 @@ static const char* conversion_api_url= CONFIG_CONVERSION_API_URL;
 // Forward declarations for external globals (defined in main.c)
 extern char* image_urls[MAX_IMAGES];
 extern char* image_names[MAX_IMAGES];
+extern time_t image_pub_dates[MAX_IMAGES];
 extern int active_image_count;
 
+// Downloads run at once; changeable at runtime from the console
+static int s_download_concurrency = DOWNLOAD_CONCURRENCY;
+
+// Last feed parsed, kept for the console's parse benchmark
+static http_download_t s_cached_feed = {0};
+static StaticSemaphore_t s_feed_lock_buf;
+static SemaphoreHandle_t s_feed_lock = NULL;
+static portMUX_TYPE s_feed_lock_init = portMUX_INITIALIZER_UNLOCKED;
+
 // Local static arrays initialized from macros
 static const char* static_image_urls[STATIC_IMAGE_COUNT] = STATIC_IMAGE_URLS_INIT;
 static const char* static_image_names[STATIC_IMAGE_COUNT] = STATIC_IMAGE_NAMES_INIT;
@@ -40,133 +62,104 @@ static bool is_outlook_image(const char* url) {
 // Forward declarations for image management (implemented in main.c)
 esp_err_t get_image_buffer_info(int image_index, char **buffer, size_t *buffer_size, size_t *buffer_allocated);
 void set_image_buffer_info(int image_index, char *buffer, size_t buffer_size, size_t buffer_allocated, bool is_valid);
-void reset_image_buffer(int image_index);
 
-// Generic HTTP event handler that can be used for both XML and image downloads
-static esp_err_t generic_http_event_handler(esp_http_client_event_t *evt)
+// The feed download, into a growable buffer
+typedef struct {
+    http_transfer_t transfer;   // First, so an engine job is its request
+    http_mem_sink_t sink;
+    const char *url;
+} feed_request_t;
+
+// A conversion request into a standalone buffer
+typedef struct {
+    http_transfer_t transfer;
+    http_mem_sink_t sink;
+    const char *post_data;
+} convert_request_t;
+
+// An image download into its slot
+typedef struct {
+    http_transfer_t transfer;
+    http_slot_sink_t sink;
+    int image_index;
+    char *post_data;            // Conversion request body, set once the download has begun
+    uint32_t request_crc;       // CRC32 of post_data
+    bool resumable;             // Ended on a failure the next pass can resume
+    http_image_done_cb_t on_done;
+    void *arg;
+    int *successful;            // Counts the images downloaded, may be NULL
+} image_request_t;
+
+// Where an image download that failed part way stopped, so the slot retry pass
+// can resume it. Valid while the slot still holds exactly those bytes.
+typedef struct {
+    uint32_t request_crc;       // CRC32 of the conversion request body
+    http_resume_t resume;
+} slot_resume_t;
+
+static slot_resume_t s_slot_resume[MAX_IMAGES];
+
+static esp_err_t feed_attempt_start(http_job_t *job)
 {
-    http_download_t *download = (http_download_t*)evt->user_data;
+    feed_request_t *feed = (feed_request_t *)job;
     
-    switch (evt->event_id) {
-        case HTTP_EVENT_ERROR:
-            ESP_LOGW(TAG, "HTTP error occurred");
-            break;
-        case HTTP_EVENT_ON_HEADER:
-            // Pre-allocate buffer based on content length
-            if (strcasecmp(evt->header_key, "Content-Length") == 0) {
-                size_t content_length = atoi(evt->header_value);
-                if (content_length > 0 && download->buffer == NULL) {
-                    download->buffer = malloc(content_length + 1024); // +1024 for safety
-                    download->buffer_allocated = content_length + 1024;
-                    if (download->buffer == NULL) {
-                        ESP_LOGE(TAG, "Failed to allocate %zu bytes for HTTP response", content_length + 1024);
-                        return ESP_FAIL;
-                    }
-                    download->buffer_size = 0;
-                }
-            }
-            break;
-        case HTTP_EVENT_ON_DATA:
-            if (evt->data_len > 0 && download->buffer != NULL) {
-                // Ensure we don't overflow the buffer
-                if (download->buffer_size + evt->data_len < download->buffer_allocated) {
-                    memcpy(download->buffer + download->buffer_size, evt->data, evt->data_len);
-                    download->buffer_size += evt->data_len;
-                    if (download->buffer_allocated > download->buffer_size) {
-                        download->buffer[download->buffer_size] = '\0'; // Null terminate if space allows
-                    }
-                }
-            }
-            break;
-        case HTTP_EVENT_ON_CONNECTED:
-        case HTTP_EVENT_HEADER_SENT:
-        case HTTP_EVENT_ON_FINISH:
-        case HTTP_EVENT_DISCONNECTED:
-        case HTTP_EVENT_REDIRECT:
-            // Reduce logging noise - only log errors and important events
-            break;
+    if (!retry_host_allow(RETRY_HOST_NHC)) {
+        ESP_LOGW(TAG, "NHC breaker open, feed not requested");
+        return ESP_ERR_NOT_ALLOWED;
+    }
+    
+    // Configure HTTP client to download XML
+    esp_http_client_config_t config = {
+        .url = feed->url,
+        .crt_bundle_attach = esp_crt_bundle_attach,
+    };
+    if (http_transfer_client(&feed->transfer, &config) == NULL) {
+        ESP_LOGE(TAG, "Failed to initialize HTTP client for XML download");
+        retry_host_release(RETRY_HOST_NHC);
+        return ESP_FAIL;
     }
     return ESP_OK;
 }
 
-// Image-specific HTTP event handler (for compatibility with existing code)
-static esp_err_t image_http_event_handler(esp_http_client_event_t *evt)
+static bool feed_attempt_end(http_job_t *job, esp_err_t err)
 {
-    // Get the image index from user_data
-    int *image_index_ptr = (int*)evt->user_data;
-    int image_index = (image_index_ptr != NULL) ? *image_index_ptr : 0;
-    
-    if (image_index < 0 || image_index >= MAX_IMAGES) {
-        ESP_LOGE(TAG, "Invalid image index: %d", image_index);
-        return ESP_FAIL;
+    feed_request_t *feed = (feed_request_t *)job;
+    http_transfer_t *transfer = &feed->transfer;
+    
+    err = http_transfer_attempt_end(transfer, err);
+    int status_code = transfer->status_code;
+    job->err = err;
+    if (http_transfer_retry_fresh(transfer, err)) {
+        return true;
+    }
+    if (transfer->expired || (err != ESP_OK && esp_timer_get_time() >= job->deadline_us)) {
+        budget_overrun(BUDGET_STAGE_FEED, -1);
+        retry_host_result(RETRY_HOST_NHC, false, 0);
+        job->err = ESP_ERR_TIMEOUT;
+        return false;
     }
     
-    char *buffer = NULL;
-    size_t buffer_size = 0, buffer_allocated = 0;
-    
-    switch (evt->event_id) {
-        case HTTP_EVENT_ERROR:
-            ESP_LOGI(TAG, "HTTP_EVENT_ERROR for image %d", image_index);
-            break;
-        case HTTP_EVENT_ON_CONNECTED:
-            ESP_LOGI(TAG, "HTTP_EVENT_ON_CONNECTED for image %d", image_index);
-            break;
-        case HTTP_EVENT_HEADER_SENT:
-            ESP_LOGI(TAG, "HTTP_EVENT_HEADER_SENT for image %d", image_index);
-            break;
-        case HTTP_EVENT_ON_HEADER:
-            ESP_LOGI(TAG, "HTTP_EVENT_ON_HEADER for image %d, key=%s, value=%s", image_index, evt->header_key, evt->header_value);
-            // If we get the content-length header, we can pre-allocate the buffer
-            if (strcasecmp(evt->header_key, "Content-Length") == 0) {
-                size_t content_length = atoi(evt->header_value);
-                get_image_buffer_info(image_index, &buffer, &buffer_size, &buffer_allocated);
-                if (content_length > 0 && buffer == NULL) {
-                    ESP_LOGI(TAG, "Pre-allocating download buffer for image %d with %zu bytes", image_index, content_length);
-                    // Add some extra space to be safe
-                    buffer = malloc(content_length + 1024);
-                    buffer_allocated = content_length + 1024;
-                    if (buffer == NULL) {
-                        ESP_LOGE(TAG, "Failed to allocate memory for download buffer of size %zu", content_length + 1024);
-                        return ESP_FAIL;
-                    }
-                    buffer_size = 0;
-                    set_image_buffer_info(image_index, buffer, buffer_size, buffer_allocated, false);
-                    ESP_LOGI(TAG, "Successfully allocated download buffer for image %d", image_index);
-                } else {
-                    ESP_LOGE(TAG, "Content-Length header missing or invalid for image %d", image_index);
-                    return ESP_FAIL;
-                }
-            }
-            break;
-        case HTTP_EVENT_ON_DATA:
-            ESP_LOGD(TAG, "HTTP_EVENT_ON_DATA for image %d, len=%d", image_index, evt->data_len);
-            if (evt->data_len > 0) {
-                get_image_buffer_info(image_index, &buffer, &buffer_size, &buffer_allocated);
-                if (buffer != NULL) {
-                    // Copy new data to buffer
-                    memcpy(buffer + buffer_size, evt->data, evt->data_len);
-                    buffer_size += evt->data_len;
-                    set_image_buffer_info(image_index, buffer, buffer_size, buffer_allocated, false);
-                }
-            }
-            break;
-        case HTTP_EVENT_ON_FINISH:
-            ESP_LOGI(TAG, "HTTP_EVENT_ON_FINISH for image %d", image_index);
-            get_image_buffer_info(image_index, &buffer, &buffer_size, &buffer_allocated);
-            if (buffer != NULL) {
-                ESP_LOGI(TAG, "Download complete for image %d: %zu bytes in buffer", image_index, buffer_size);
-            }
-            break;
-        case HTTP_EVENT_DISCONNECTED:
-            ESP_LOGI(TAG, "HTTP_EVENT_DISCONNECTED for image %d", image_index);
-            break;
-        case HTTP_EVENT_REDIRECT:
-            ESP_LOGI(TAG, "HTTP_EVENT_REDIRECT for image %d", image_index);
-            break;
+    bool transient = retry_transient(err, status_code);
+    retry_host_result(RETRY_HOST_NHC, !transient, transfer->retry_after_ms);
+    if (!http_transfer_range_valid(transfer)) {
+        transient = true;   // Not the range asked for; start over
     }
-    return ESP_OK;
+    if (!transient) {
+        return false;
+    }
+    if (http_transfer_resume_point(transfer) > 0) {
+        ESP_LOGI(TAG, "Feed interrupted, resuming from byte %zu", transfer->resume.offset);
+    }
+    return job->attempt < RETRY_MAX_ATTEMPTS &&
+           retry_schedule(RETRY_HOST_NHC, job->attempt - 1, transfer->retry_after_ms,
+                          job->deadline_us, &job->retry_at_us);
 }
 
+static const http_job_ops_t s_feed_job_ops = {
+    .attempt_start = feed_attempt_start,
+    .attempt_end = feed_attempt_end,
+};
+
 esp_err_t http_download_xml_feed(const char* url, http_download_t* result)
 {
     if (url == NULL || result == NULL) {
@@ -177,28 +170,21 @@ esp_err_t http_download_xml_feed(const char* url, http_download_t* result)
     
     // Initialize result structure
     memset(result, 0, sizeof(http_download_t));
-    
-    // Configure HTTP client to download XML
-    esp_http_client_config_t config = {
-        .url = url,
-        .event_handler = generic_http_event_handler,
-        .user_data = result,
-        .timeout_ms = 15000,
-        .crt_bundle_attach = esp_crt_bundle_attach,
-    };
-    
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    if (client == NULL) {
-        ESP_LOGE(TAG, "Failed to initialize HTTP client for XML download");
-        return ESP_FAIL;
-    }
-    
-    // Perform HTTP GET request
-    esp_err_t err = esp_http_client_perform(client);
-    int status_code = esp_http_client_get_status_code(client);
-    esp_http_client_cleanup(client);
-    
-    if (err == ESP_OK && status_code == 200 && result->buffer != NULL && result->buffer_size > 0) {
+    feed_request_t feed = { .url = url };
+    http_mem_sink_init(&feed.sink, result);
+    http_transfer_init(&feed.transfer, &s_feed_job_ops, &feed.sink.base);
+    feed.transfer.job.deadline_us = budget_deadline(BUDGET_STAGE_FEED);
+    feed.transfer.job.idle_timeout_ms = XML_TIMEOUT_MS;
+    feed.transfer.host = RETRY_HOST_NHC;
+    
+    TRACE_BEGIN("feed_download");
+    http_job_t *job = &feed.transfer.job;
+    http_engine_run(&job, 1, 1);
+    TRACE_END("feed_download");
+    
+    esp_err_t err = job->err;
+    int status_code = feed.transfer.status_code;
+    if (err == ESP_OK && http_transfer_body_ok(&feed.transfer) && result->buffer != NULL && result->buffer_size > 0) {
         ESP_LOGI(TAG, "XML download successful: %zu bytes", result->buffer_size);
         return ESP_OK;
     } else {
@@ -208,123 +194,280 @@ esp_err_t http_download_xml_feed(const char* url, http_download_t* result)
     }
 }
 
-esp_err_t http_download_image(int image_index)
+// Build the JSON body for a conversion API request. The crop depends on the
+// product; encoding is the output-format part of the request (cf/output/...).
+// Returns a malloc'd string, or NULL if out of memory.
+static char *build_conversion_request(const char *url, const char *encoding)
 {
-    if (image_index < 0 || image_index >= MAX_IMAGES) {
-        ESP_LOGE(TAG, "Invalid image index: %d", image_index);
-        return ESP_FAIL;
-    }
-    
-    // Reset download buffer before downloading
-    reset_image_buffer(image_index);
-    
-    // Print available memory info for debugging
-    ESP_LOGI(TAG, "Available heap: %lu bytes", heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
-    
-    esp_err_t err;
-    int status_code = 0;
-    esp_http_client_handle_t client = NULL;
-    
-    // Using the conversion API to convert and download the NHC image
-    ESP_LOGI(TAG, "Using conversion API to convert image %d from: %s", image_index, image_urls[image_index]);
-        
     const char *post_data_format;
-    if (is_outlook_image(image_urls[image_index])) {
-        ESP_LOGI(TAG, "Adding crop parameters for Atlantic outlook image %d", image_index);
+    if (is_outlook_image(url)) {
+        BINLOG(BL_DL_CROP_OUTLOOK);
         post_data_format = 
             "{"
             "\"url\": \"%s\","
-            "\"cf\": \"RGB565\","  // RGB565 format to match lvgl init
-            "\"dither\": \"true\","  // Dithering
-            "\"output\": \"bin\","    // Binary output format
-            "\"bigEndian\": false,"
-            "\"maxSize\": \"800x420\","  // TODO: make this configurable
+            "%s,"
+            "\"maxSize\": \"" IMAGE_MAX_SIZE "\","
             "\"crop\": {\"top\": 65, \"bottom\": 70}"
             "}";
     } else {
-        ESP_LOGI(TAG, "Adding crop parameters for forecast cone %d", image_index);
+        BINLOG(BL_DL_CROP_CONE);
         post_data_format = 
             "{"
             "\"url\": \"%s\","
-            "\"cf\": \"RGB565\","  // RGB565 format to match lvgl init
-            "\"dither\": \"true\","  // Dithering
-            "\"output\": \"bin\","    // Binary output format
-            "\"bigEndian\": false,"
-            "\"maxSize\": \"800x420\","
+            "%s,"
+            "\"maxSize\": \"" IMAGE_MAX_SIZE "\","
             "\"crop\": {\"top\": 50, \"bottom\": 40, \"left\": 7, \"right\": 7}"
             "}";
     }
-    
+
     // Calculate required buffer size and allocate
-    size_t url_len = strlen(image_urls[image_index]);
-    size_t post_data_len = strlen(post_data_format) + url_len - 2; // -2 for %s
+    size_t post_data_len = strlen(post_data_format) + strlen(url) + strlen(encoding) - 4; // -4 for two %s
     char *post_data = malloc(post_data_len + 1);
-    if (post_data == NULL) {
-        ESP_LOGE(TAG, "Failed to allocate memory for POST data");
-        return ESP_ERR_NO_MEM;
+    if (post_data != NULL) {
+        snprintf(post_data, post_data_len + 1, post_data_format, url, encoding);
     }
-    
-    // Format the POST data with the URL
-    snprintf(post_data, post_data_len + 1, post_data_format, image_urls[image_index]);
-    
+    return post_data;
+}
+
+// Client of one attempt at a conversion request
+static esp_http_client_handle_t conversion_client(http_transfer_t *transfer, const char *post_data)
+{
     // Configure HTTP client for POST request to conversion API
     esp_http_client_config_t config = {
         .url = conversion_api_url,
-        .event_handler = image_http_event_handler,
-        .user_data = &image_index,  // Pass image index to event handler
         .buffer_size = MAX_HTTP_RECV_BUFFER,
-        .timeout_ms = 30000,
         .crt_bundle_attach = esp_crt_bundle_attach,  // Use certificate bundle
     };
+    esp_http_client_handle_t client = http_transfer_client(transfer, &config);
+    if (client != NULL) {
+        // Set POST method and headers
+        esp_http_client_set_method(client, HTTP_METHOD_POST);
+        esp_http_client_set_header(client, "Content-Type", "application/json");
+        esp_http_client_set_post_field(client, post_data, strlen(post_data));
+    }
+    return client;
+}
+
+static esp_err_t convert_attempt_start(http_job_t *job)
+{
+    convert_request_t *request = (convert_request_t *)job;
+    return conversion_client(&request->transfer, request->post_data) != NULL ? ESP_OK : ESP_FAIL;
+}
+
+static bool convert_attempt_end(http_job_t *job, esp_err_t err)
+{
+    convert_request_t *request = (convert_request_t *)job;
+    job->err = http_transfer_attempt_end(&request->transfer, err);
+    // Single attempt, but for a kept-alive connection that had gone stale;
+    // the caller has its own fallback
+    return http_transfer_retry_fresh(&request->transfer, job->err);
+}
+
+static const http_job_ops_t s_convert_job_ops = {
+    .attempt_start = convert_attempt_start,
+    .attempt_end = convert_attempt_end,
+};
+
+esp_err_t http_convert_image(const char *url, const char *encoding, http_download_t *result)
+{
+    if (url == NULL || encoding == NULL || result == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
 
-    client = esp_http_client_init(&config);
+    memset(result, 0, sizeof(http_download_t));
+
+    if (!retry_host_allow(RETRY_HOST_CONVERSION)) {
+        return ESP_ERR_NOT_ALLOWED;
+    }
+    char *post_data = build_conversion_request(url, encoding);
+    if (post_data == NULL) {
+        retry_host_release(RETRY_HOST_CONVERSION);
+        return ESP_ERR_NO_MEM;
+    }
+
+    convert_request_t request = { .post_data = post_data };
+    http_mem_sink_init(&request.sink, result);
+    http_transfer_init(&request.transfer, &s_convert_job_ops, &request.sink.base);
+    request.transfer.job.deadline_us = budget_deadline(BUDGET_STAGE_IMAGE);
+    request.transfer.job.idle_timeout_ms = HTTP_TIMEOUT_MS;
+    request.transfer.host = RETRY_HOST_CONVERSION;
+
+    http_job_t *job = &request.transfer.job;
+    http_engine_run(&job, 1, 1);
+    free(post_data);
+    if (job->attempt == 0) {
+        retry_host_release(RETRY_HOST_CONVERSION);     // No client, nothing was sent
+        return ESP_FAIL;
+    }
+    esp_err_t err = job->err;
+    int status_code = request.transfer.status_code;
+    if (request.transfer.expired) {
+        err = ESP_ERR_TIMEOUT;
+    }
+    retry_host_result(RETRY_HOST_CONVERSION, !retry_transient(err, status_code), request.transfer.retry_after_ms);
+
+    if (err == ESP_OK && status_code == 200 && result->buffer != NULL && result->buffer_size > 0) {
+        return ESP_OK;
+    }
+    ESP_LOGW(TAG, "Conversion request failed: err=%s, status=%d", esp_err_to_name(err), status_code);
+    http_download_free(result);
+    return ESP_FAIL;
+}
+
+// First attempt of an image: build the request and restore or clear the slot
+static esp_err_t image_request_begin(image_request_t *request)
+{
+    int image_index = request->image_index;
     
-    // Set POST method and headers
-    esp_http_client_set_method(client, HTTP_METHOD_POST);
-    esp_http_client_set_header(client, "Content-Type", "application/json");
-    esp_http_client_set_post_field(client, post_data, strlen(post_data));
+    // Past the cycle deadline the slot is left as it was, not started and cancelled
+    if (budget_cycle_expired()) {
+        ESP_LOGW(TAG, "Cycle budget spent, image %d not refreshed", image_index);
+        return ESP_ERR_NOT_FINISHED;
+    }
+    BINLOG(BL_DL_START, image_index + 1, active_image_count);
     
-    ESP_LOGI(TAG, "Sending conversion request to API for image %d...", image_index);
-    err = esp_http_client_perform(client);
+    // Using the conversion API to convert and download the NHC image; the URL
+    // itself was logged when the feed was parsed
+    BINLOG(BL_DL_REQUEST, image_index, heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+        
+    const char *color_format = is_outlook_image(image_urls[image_index]) ? OUTLOOK_TRANSFER_CF : CONE_TRANSFER_CF;
+    char encoding[96];
+    if (strcmp(color_format, TRANSFER_CF_JPEG) == 0) {
+        // Baseline JPEG, decoded on the device by the ROM TJpgDec
+        snprintf(encoding, sizeof(encoding),
+                 "\"output\": \"jpg\", \"quality\": %d", JPEG_TRANSFER_QUALITY);
+    } else {
+        // RGB565 to match lvgl init, or indexed I8/I4 expanded on display
+        snprintf(encoding, sizeof(encoding),
+                 "\"cf\": \"%s\", \"dither\": \"true\", \"output\": \"bin\", \"bigEndian\": false",
+                 color_format);
+    }
+
+    request->post_data = build_conversion_request(image_urls[image_index], encoding);
+    if (request->post_data == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate memory for POST data");
+        return ESP_ERR_NO_MEM;
+    }
     
-    // Capture status code before cleanup
-    status_code = esp_http_client_get_status_code(client);
+    // Retries share the image budget
+    request->transfer.job.deadline_us = budget_deadline(BUDGET_STAGE_IMAGE);
+    request->transfer.job.idle_timeout_ms = HTTP_TIMEOUT_MS;
     
-    // Free allocated memory
-    free(post_data);
-    esp_http_client_cleanup(client);
-    client = NULL;
+    // Resume if the slot holds the start of this same response from an earlier
+    // pass. Otherwise the slot keeps its last image until a new body begins.
+    request->request_crc = esp_rom_crc32_le(0, (const uint8_t *)request->post_data, strlen(request->post_data));
+    slot_resume_t *saved = &s_slot_resume[image_index];
+    char *buffer = NULL;
+    size_t buffer_size = 0, buffer_allocated = 0;
+    get_image_buffer_info(image_index, &buffer, &buffer_size, &buffer_allocated);
+    if (saved->resume.offset > 0 && saved->request_crc == request->request_crc &&
+        buffer != NULL && buffer_size == saved->resume.offset) {
+        request->transfer.resume = saved->resume;
+    }
+    memset(saved, 0, sizeof(*saved));
+    return ESP_OK;
+}
+
+static esp_err_t image_attempt_start(http_job_t *job)
+{
+    image_request_t *request = (image_request_t *)job;
+    int image_index = request->image_index;
+    
+    // Before anything touches the slot: an open breaker leaves its last image
+    if (!retry_host_allow(RETRY_HOST_CONVERSION)) {
+        BINLOG(BL_DL_BREAKER_OPEN, image_index);
+        return ESP_ERR_NOT_ALLOWED;
+    }
+    if (job->attempt == 0) {
+        esp_err_t err = image_request_begin(request);
+        if (err != ESP_OK) {
+            retry_host_release(RETRY_HOST_CONVERSION);
+            return err;
+        }
+    }
+    // The slot is only replaced once a 2xx body begins (slot sink begin())
+    http_slot_sink_init(&request->sink, image_index, request->transfer.resume.offset);
+    
+    if (conversion_client(&request->transfer, request->post_data) == NULL) {
+        retry_host_release(RETRY_HOST_CONVERSION);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+static bool image_attempt_end(http_job_t *job, esp_err_t err)
+{
+    image_request_t *request = (image_request_t *)job;
+    http_transfer_t *transfer = &request->transfer;
+    int image_index = request->image_index;
+    
+    err = http_transfer_attempt_end(transfer, err);
+    int status_code = transfer->status_code;
+    job->err = err;
+    if (http_transfer_retry_fresh(transfer, err)) {
+        return true;
+    }
+    
+    // A cancelled request may still end with ESP_OK and a partial body
+    if (transfer->expired || (err != ESP_OK && esp_timer_get_time() >= job->deadline_us)) {
+        budget_overrun(BUDGET_STAGE_IMAGE, image_index);
+        retry_host_result(RETRY_HOST_CONVERSION, false, 0);
+        request->resumable = http_transfer_resume_point(transfer) > 0;
+        job->err = ESP_ERR_TIMEOUT;
+        return false;
+    }
+    
+    bool transient = retry_transient(err, status_code);
+    retry_host_result(RETRY_HOST_CONVERSION, !transient, transfer->retry_after_ms);
+    if (!http_transfer_range_valid(transfer)) {
+        transient = true;   // Not the range asked for; start over
+    }
+    if (!transient) {
+        return false;
+    }
+    BINLOG(BL_DL_RETRY, image_index, status_code, err);
+    request->resumable = http_transfer_resume_point(transfer) > 0;
+    return job->attempt < RETRY_MAX_ATTEMPTS &&
+           retry_schedule(RETRY_HOST_CONVERSION, job->attempt - 1, transfer->retry_after_ms,
+                          job->deadline_us, &job->retry_at_us);
+}
+
+// After the last attempt: check what arrived and mark the slot valid
+static esp_err_t image_request_end(image_request_t *request, esp_err_t err)
+{
+    int image_index = request->image_index;
+    int status_code = request->transfer.status_code;
+    char *buffer = NULL;
+    size_t buffer_size = 0, buffer_allocated = 0;
+    
+    free(request->post_data);
+    request->post_data = NULL;
    
     if (err == ESP_OK) {
-        char *buffer = NULL;
-        size_t buffer_size = 0, buffer_allocated = 0;
         get_image_buffer_info(image_index, &buffer, &buffer_size, &buffer_allocated);
         
-        ESP_LOGI(TAG, "HTTP GET Status = %d, download size = %zu bytes for image %d",
-                status_code, buffer_size, image_index);
+        BINLOG(BL_DL_STATUS, status_code, buffer_size, image_index);
         
+        if (status_code == 206 && http_transfer_body_ok(&request->transfer)) {
+            status_code = 200;  // The rest of a resumed body; the slot holds all of it now
+        }
         if (status_code != 200) {
             ESP_LOGE(TAG, "HTTP request returned non-200 status code: %d for image %d", status_code, image_index);
-            err = ESP_FAIL;
+            // Only failures worth repeating go to the retry pass
+            err = retry_transient(err, status_code) ? ESP_FAIL : ESP_ERR_INVALID_RESPONSE;
         } else if (buffer != NULL && buffer_size > 0) {
-            ESP_LOGI(TAG, "Downloaded data size: %zu bytes for image %d", buffer_size, image_index);
-            
             // Check PSRAM usage after download
             size_t psram_free = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
             size_t psram_total = heap_caps_get_total_size(MALLOC_CAP_SPIRAM);
             size_t psram_used = psram_total - psram_free;
-            
-            ESP_LOGI(TAG, "PSRAM after image %d download: %zu/%zu bytes used (%.1f%% used, %.1f%% free)", 
-                     image_index, psram_used, psram_total, 
-                     (psram_used * 100.0) / psram_total,
-                     (psram_free * 100.0) / psram_total);
+            BINLOG(BL_DL_PSRAM, image_index, psram_used / 1024, psram_total / 1024,
+                   psram_total ? (uint64_t)psram_used * 100 / psram_total : 0);
             
             // Verify the downloaded data is large enough
             // For a simple validation, check if the buffer is at least large enough
             // to contain a minimal header (8 bytes) plus some image data
             if (buffer_size < 100) { // Arbitrary small threshold
-                ESP_LOGW(TAG, "Downloaded data seems too small for an image (%zu bytes) for image %d", 
-                         buffer_size, image_index);
+                BINLOG(BL_DL_TOO_SMALL, buffer_size, image_index);
                 err = ESP_FAIL;
             } else {
                 set_image_buffer_info(image_index, buffer, buffer_size, buffer_allocated, true);
@@ -338,42 +481,159 @@ esp_err_t http_download_image(int image_index)
         ESP_LOGE(TAG, "HTTP GET request failed for image %d: %s", image_index, esp_err_to_name(err));
     }
     
+    // What arrived stays in the slot for the retry pass to resume from
+    if (err != ESP_OK && request->resumable) {
+        slot_resume_t *saved = &s_slot_resume[image_index];
+        saved->request_crc = request->request_crc;
+        saved->resume = request->transfer.resume;
+        BINLOG(BL_DL_RESUME_SAVED, image_index, request->transfer.resume.offset);
+    }
     return err;
 }
 
-esp_err_t http_download_all_images(void)
+static void image_done(http_job_t *job)
 {
-    int successful_downloads = 0;
+    image_request_t *request = (image_request_t *)job;
+    int image_index = request->image_index;
     
-    if (active_image_count == 0) {
+    if (request->post_data != NULL) {
+        job->err = image_request_end(request, job->err);
+    }
+    if (job->err == ESP_OK) {
+        if (request->successful != NULL) {
+            (*request->successful)++;
+        }
+        BINLOG(BL_DL_OK, image_index);
+    } else if (job->err != ESP_ERR_NOT_FINISHED) {
+        BINLOG(BL_DL_FAILED, image_index, job->err);
+    }
+    if (request->on_done != NULL) {
+        request->on_done(image_index, job->err, request->arg);
+    }
+}
+
+static const http_job_ops_t s_image_job_ops = {
+    .attempt_start = image_attempt_start,
+    .attempt_end = image_attempt_end,
+    .done = image_done,
+};
+
+static void image_request_init(image_request_t *request, int image_index, int priority)
+{
+    request->image_index = image_index;
+    http_slot_sink_init(&request->sink, image_index, 0);
+    http_transfer_init(&request->transfer, &s_image_job_ops, &request->sink.base);
+    request->transfer.job.priority = priority;
+    request->transfer.log_index = image_index;
+    request->transfer.host = RETRY_HOST_CONVERSION;
+}
+
+esp_err_t http_download_images(const int *order, int count, http_image_done_cb_t on_done, void *arg)
+{
+    // Indexes past the active images are dropped, keeping the order of the rest
+    int slots[MAX_IMAGES];
+    int n = 0;
+    for (int k = 0; k < count && n < MAX_IMAGES; k++) {
+        if (order[k] < 0 || order[k] >= active_image_count) {
+            continue;
+        }
+        if (image_urls[order[k]] == NULL) {
+            BINLOG(BL_DL_SKIP, order[k]);
+            continue;
+        }
+        slots[n++] = order[k];
+    }
+    count = n;
+    if (count == 0) {
         ESP_LOGW(TAG, "No active images to download");
         return ESP_FAIL;
     }
     
-    ESP_LOGI(TAG, "Downloading all %d active images...", active_image_count);
+    image_request_t *requests = calloc(count, sizeof(image_request_t));
+    if (requests == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
     
-    for (int i = 0; i < active_image_count; i++) {
-        if (image_urls[i] == NULL) {
-            ESP_LOGW(TAG, "Skipping image %d - no URL available", i);
-            continue;
-        }
-        
-        ESP_LOGI(TAG, "Downloading image %d of %d...", i + 1, active_image_count);
-        
-        if (http_download_image(i) == ESP_OK) {
-            successful_downloads++;
-            ESP_LOGI(TAG, "Successfully downloaded image %d", i);
-        } else {
-            ESP_LOGW(TAG, "Failed to download image %d", i);
-        }
+    // Position in order is the priority: the first images start first, and a
+    // retry that falls due goes ahead of images not started yet
+    int successful_downloads = 0;
+    http_job_t *jobs[MAX_IMAGES];
+    for (int k = 0; k < count; k++) {
+        image_request_init(&requests[k], slots[k], k);
+        requests[k].on_done = on_done;
+        requests[k].arg = arg;
+        requests[k].successful = &successful_downloads;
+        jobs[k] = &requests[k].transfer.job;
     }
     
-    ESP_LOGI(TAG, "Download complete: %d of %d images downloaded successfully", 
-             successful_downloads, active_image_count);
+    int concurrency = s_download_concurrency < count ? s_download_concurrency : count;
+    if (count == active_image_count) {
+        BINLOG(BL_DL_BATCH_START, count, concurrency);
+    } else {
+        BINLOG(BL_DL_SUBSET_START, count, concurrency);
+    }
+    
+    http_engine_run(jobs, count, concurrency);
+    free(requests);
+    
+    BINLOG(BL_DL_BATCH_DONE, successful_downloads, count);
     
     return (successful_downloads > 0) ? ESP_OK : ESP_FAIL;
 }
 
+esp_err_t http_set_download_concurrency(int concurrency)
+{
+    if (concurrency < 1 || concurrency > DOWNLOAD_CONCURRENCY_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_download_concurrency = concurrency;
+    return ESP_OK;
+}
+
+int http_get_download_concurrency(void)
+{
+    return s_download_concurrency;
+}
+
+static SemaphoreHandle_t feed_lock(void)
+{
+    portENTER_CRITICAL(&s_feed_lock_init);
+    if (s_feed_lock == NULL) {
+        s_feed_lock = xSemaphoreCreateMutexStatic(&s_feed_lock_buf);
+    }
+    portEXIT_CRITICAL(&s_feed_lock_init);
+    return s_feed_lock;
+}
+
+// Keep the feed just parsed in place of the previous one; takes ownership of its buffer
+static void cache_feed(http_download_t *feed)
+{
+    xSemaphoreTake(feed_lock(), portMAX_DELAY);
+    http_download_free(&s_cached_feed);
+    s_cached_feed = *feed;
+    xSemaphoreGive(feed_lock());
+    memset(feed, 0, sizeof(*feed));
+}
+
+esp_err_t http_copy_cached_feed(http_download_t *copy)
+{
+    memset(copy, 0, sizeof(*copy));
+    esp_err_t err = ESP_OK;
+    xSemaphoreTake(feed_lock(), portMAX_DELAY);
+    if (s_cached_feed.buffer == NULL) {
+        err = ESP_ERR_NOT_FOUND;
+    } else if ((copy->buffer = malloc(s_cached_feed.buffer_size + 1)) == NULL) {
+        err = ESP_ERR_NO_MEM;
+    } else {
+        memcpy(copy->buffer, s_cached_feed.buffer, s_cached_feed.buffer_size);
+        copy->buffer[s_cached_feed.buffer_size] = '\0';
+        copy->buffer_size = s_cached_feed.buffer_size;
+        copy->buffer_allocated = s_cached_feed.buffer_size + 1;
+    }
+    xSemaphoreGive(feed_lock());
+    return err;
+}
+
 esp_err_t http_update_image_urls_from_xml(void)
 {
     ESP_LOGI(TAG, "Downloading NHC XML feed from: %s", NHC_XML_FEED_URL);
@@ -387,6 +647,13 @@ esp_err_t http_update_image_urls_from_xml(void)
         // Clean up old URLs
         http_cleanup_image_urls();
         
+        // Parse XML to extract cone image URLs and when each advisory was published
+        int cone_count = 0;
+        time_t *cone_pub_dates = NULL;
+        time_t outlook_pub_date = 0;
+        char** cone_urls = xml_parse_cone_images(xml_response.buffer, xml_response.buffer_size, &cone_count,
+                                                 &cone_pub_dates, &outlook_pub_date);
+        
         // Always start with Atlantic outlook images
         int current_index = 0;
         int static_to_use = (STATIC_IMAGE_COUNT > MAX_IMAGES) ? MAX_IMAGES : STATIC_IMAGE_COUNT;
@@ -395,14 +662,11 @@ esp_err_t http_update_image_urls_from_xml(void)
         for (int i = 0; i < static_to_use && current_index < MAX_IMAGES; i++) {
             image_urls[current_index] = strdup(static_image_urls[i]);
             image_names[current_index] = strdup(static_image_names[i]);
+            image_pub_dates[current_index] = outlook_pub_date;
             ESP_LOGI(TAG, "Added Atlantic outlook image %d: %s", current_index, static_image_names[i]);
             current_index++;
         }
         
-        // Parse XML to extract cone image URLs
-        int cone_count = 0;
-        char** cone_urls = xml_parse_all_cone_image_urls(xml_response.buffer, xml_response.buffer_size, &cone_count);
-        
         if (cone_urls && cone_count > 0) {
             ESP_LOGI(TAG, "Found %d cone image URLs in XML", cone_count);
             
@@ -420,6 +684,7 @@ esp_err_t http_update_image_urls_from_xml(void)
                 char temp_name[64];
                 snprintf(temp_name, sizeof(temp_name), "Hurricane Cone %d", i + 1);
                 image_names[current_index] = strdup(temp_name);
+                image_pub_dates[current_index] = cone_pub_dates[i];
                 
                 ESP_LOGI(TAG, "Added cone image %d: %s", current_index, cone_urls[i]);
                 current_index++;
@@ -427,15 +692,21 @@ esp_err_t http_update_image_urls_from_xml(void)
             
             // Clean up parsed URLs
             xml_parse_free_urls(cone_urls, cone_count);
+            free(cone_pub_dates);
             
         } else {
             ESP_LOGW(TAG, "No cone image URLs found in XML, only Atlantic outlook images will be displayed");
         }
+        cache_feed(&xml_response);
         
         active_image_count = current_index;
         ESP_LOGI(TAG, "Total images configured: %d (Atlantic outlook + cone images)", active_image_count);
         err = ESP_OK;
         
+    } else if (active_image_count > 0) {
+        // Feed unavailable or over budget; last cycle's images are still the best guess
+        ESP_LOGE(TAG, "XML download failed, keeping the current %d URLs", active_image_count);
+        err = ESP_FAIL;
     } else {
         ESP_LOGE(TAG, "XML download failed, using static URLs");
         
@@ -469,6 +740,7 @@ void http_cleanup_image_urls(void)
             free(image_names[i]);
             image_names[i] = NULL;
         }
+        image_pub_dates[i] = 0;
     }
     active_image_count = 0;
 }
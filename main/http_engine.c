@@ -0,0 +1,219 @@
+#include "http_engine.h"
+#include "app_config.h"
+#include "trace.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <errno.h>
+
+static const char TAG[] = "http_engine";
+
+typedef enum {
+    JOB_QUEUED,                 // Not started yet
+    JOB_ACTIVE,                 // Attempt in flight
+    JOB_WAITING,                // Between attempts, until retry_at_us
+    JOB_FINISHED,
+} job_state_t;
+
+// Job whose client this task is polling; in its task's own TLS since several
+// tasks run the engine
+static __thread http_job_t *s_polling;
+
+// Most urgent job that may start an attempt now: queued, or due to retry
+static http_job_t *next_to_start(http_job_t *const *jobs, int count, int64_t now)
+{
+    http_job_t *best = NULL;
+    for (int i = 0; i < count; i++) {
+        http_job_t *job = jobs[i];
+        bool ready = job->state == JOB_QUEUED || (job->state == JOB_WAITING && now >= job->retry_at_us);
+        if (ready && (best == NULL || job->priority < best->priority)) {
+            best = job;
+        }
+    }
+    return best;
+}
+
+static void finish_job(http_job_t *job)
+{
+    job->state = JOB_FINISHED;
+    if (job->ops->done != NULL) {
+        job->ops->done(job);
+    }
+}
+
+// Returns true if the attempt is in flight
+static bool start_attempt(http_job_t *job, int64_t now)
+{
+    job->client = NULL;
+    esp_err_t err = job->ops->attempt_start(job);
+    if (err != ESP_OK || job->client == NULL) {
+        job->err = err != ESP_OK ? err : ESP_FAIL;
+        finish_job(job);
+        return false;
+    }
+    job->state = JOB_ACTIVE;
+    job->progress_us = now;
+    job->progress_bytes = job->bytes;
+    return true;
+}
+
+static void end_attempt(http_job_t *job, esp_err_t err)
+{
+    job->attempt++;
+    bool retry = job->ops->attempt_end(job, err);
+    job->client = NULL;
+    if (retry) {
+        job->state = JOB_WAITING;
+    } else {
+        finish_job(job);
+    }
+}
+
+// One step of an attempt, waiting at most wait_ms on its socket. Returns true
+// once the attempt has ended.
+static bool poll_attempt(http_job_t *job, uint32_t wait_ms)
+{
+    if (!job->blocking) {
+        esp_http_client_set_timeout_ms(job->client, (int)wait_ms);
+    }
+    // A body read whose wait runs out returns no bytes and leaves errno alone;
+    // perform() only reports that as ESP_ERR_HTTP_EAGAIN, instead of ending the
+    // body there, if errno says EAGAIN. A socket error sets errno itself.
+    errno = EAGAIN;
+    s_polling = job;
+    esp_err_t err = esp_http_client_perform(job->client);
+    s_polling = NULL;
+    if (err != ESP_ERR_HTTP_EAGAIN) {
+        end_attempt(job, err);
+        return true;
+    }
+
+    int64_t now = esp_timer_get_time();
+    if (job->bytes != job->progress_bytes) {
+        job->progress_bytes = job->bytes;
+        job->progress_us = now;
+    }
+    bool idle = job->idle_timeout_ms > 0 && now - job->progress_us >= (int64_t)job->idle_timeout_ms * 1000;
+    if (idle || (job->deadline_us != 0 && now >= job->deadline_us)) {
+        esp_http_client_cancel_request(job->client);
+        end_attempt(job, ESP_ERR_TIMEOUT);
+        return true;
+    }
+    return false;
+}
+
+// esp_timer time the engine must look at the jobs again by: the first retry
+// due, or the first deadline or idle timeout of an attempt in flight
+static int64_t next_wake_us(http_job_t *const *jobs, int count)
+{
+    int64_t wake_us = INT64_MAX;
+    for (int i = 0; i < count; i++) {
+        http_job_t *job = jobs[i];
+        int64_t at = INT64_MAX;
+        if (job->state == JOB_WAITING) {
+            at = job->retry_at_us;
+        } else if (job->state == JOB_ACTIVE) {
+            if (job->idle_timeout_ms > 0) {
+                at = job->progress_us + (int64_t)job->idle_timeout_ms * 1000;
+            }
+            if (job->deadline_us != 0 && job->deadline_us < at) {
+                at = job->deadline_us;
+            }
+        }
+        if (at < wake_us) {
+            wake_us = at;
+        }
+    }
+    return wake_us;
+}
+
+// How long each waiting transfer may block on its socket in the next pass.
+// The pass is shared between them, so data on any socket is seen within
+// about HTTP_ENGINE_POLL_MS, and it ends early for a retry or timeout due.
+static uint32_t poll_wait_ms(http_job_t *const *jobs, int count, bool progressed, int64_t now)
+{
+    int polled = 0;
+    for (int i = 0; i < count; i++) {
+        polled += jobs[i]->state == JOB_ACTIVE && !jobs[i]->blocking;
+    }
+    // After a pass that moved data, only look for more before going round again
+    uint32_t wait_ms = progressed || polled == 0 ? 1 : HTTP_ENGINE_POLL_MS / polled;
+    // A client timeout of 0 means no timeout to some of its layers
+    int64_t until_wake_ms = (next_wake_us(jobs, count) - now) / 1000;
+    if (until_wake_ms < wait_ms) {
+        wait_ms = until_wake_ms > 1 ? (uint32_t)until_wake_ms : 1;
+    }
+    return wait_ms;
+}
+
+http_job_t *http_engine_current_job(void)
+{
+    return s_polling;
+}
+
+esp_err_t http_engine_run(http_job_t *const *jobs, int count, int max_active)
+{
+    if (jobs == NULL || count < 0 || max_active < 1) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (int i = 0; i < count; i++) {
+        jobs[i]->state = JOB_QUEUED;
+        jobs[i]->attempt = 0;
+        jobs[i]->client = NULL;
+        jobs[i]->err = ESP_OK;
+    }
+
+    TRACE_BEGIN("http_engine");
+    int active = 0;
+    int finished = 0;
+    bool progressed = true;
+    while (finished < count) {
+        int64_t now = esp_timer_get_time();
+        http_job_t *job;
+        while (active < max_active && (job = next_to_start(jobs, count, now)) != NULL) {
+            if (start_attempt(job, now)) {
+                active++;
+            } else {
+                finished++;
+            }
+        }
+
+        uint32_t wait_ms = poll_wait_ms(jobs, count, progressed, now);
+        int64_t pass_start = esp_timer_get_time();
+        progressed = false;
+        for (int i = 0; i < count; i++) {
+            job = jobs[i];
+            if (job->state != JOB_ACTIVE) {
+                continue;
+            }
+            uint32_t before = job->bytes;
+            if (!poll_attempt(job, wait_ms)) {
+                progressed |= job->bytes != before;
+                continue;
+            }
+            progressed = true;
+            active--;
+            if (job->state == JOB_FINISHED) {
+                finished++;
+            }
+        }
+
+        if (active > 0 && !progressed && esp_timer_get_time() - pass_start < 1000) {
+            // Nothing waited on a socket: every transfer is in its TLS handshake,
+            // which only says it would block. Let lower priority tasks run
+            // rather than spin until a record arrives.
+            vTaskDelay(1);
+        } else if (active == 0 && finished < count) {
+            // Only retry waits left: sleep until the first is due
+            int64_t wake_us = next_wake_us(jobs, count);
+            int64_t sleep_ms = wake_us != INT64_MAX ? (wake_us - esp_timer_get_time() + 999) / 1000 : 0;
+            if (sleep_ms > 0) {
+                ESP_LOGD(TAG, "All transfers waiting to retry, sleeping %lld ms", sleep_ms);
+                vTaskDelay(pdMS_TO_TICKS(sleep_ms));
+            }
+        }
+    }
+    TRACE_END("http_engine");
+    return ESP_OK;
+}
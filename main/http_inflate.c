@@ -0,0 +1,344 @@
+#include "http_inflate.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_rom_crc.h"
+#include "rom/miniz.h"
+#include "freertos/FreeRTOS.h"
+#include <stdlib.h>
+#include <strings.h>
+
+static const char TAG[] = "http_inflate";
+
+#define GZIP_HEADER_SIZE 10
+#define GZIP_TRAILER_SIZE 8
+#define GZIP_FHCRC 0x02
+#define GZIP_FEXTRA 0x04
+#define GZIP_FNAME 0x08
+#define GZIP_FCOMMENT 0x10
+#define GZIP_FRESERVED 0xE0
+
+typedef enum {
+    INFLATE_HEADER,             // gzip fixed header, or the first two bytes of a deflate body
+    INFLATE_XLEN,
+    INFLATE_EXTRA,
+    INFLATE_NAME,
+    INFLATE_COMMENT,
+    INFLATE_HCRC,
+    INFLATE_BODY,
+    INFLATE_TRAILER,
+    INFLATE_DONE,
+} inflate_stage_t;
+
+struct http_inflate {
+    tinfl_decompressor tinfl;
+    http_encoding_t encoding;
+    mz_uint32 flags;
+    inflate_stage_t stage;
+    uint8_t header[GZIP_HEADER_SIZE];   // Also holds the trailer once the body is done
+    size_t header_len;
+    size_t skip;                // Bytes of FEXTRA or FHCRC left to skip
+    size_t pending;             // Header bytes that are deflate data (raw deflate sniffing)
+    uint32_t crc;               // CRC32 of the decoded bytes (gzip)
+    uint32_t size;              // Decoded bytes, mod 2^32
+    uint8_t *window;            // Wrapping LZ77 window of http_inflate_stream(), NULL until used
+    size_t window_len;          // Write position in window
+    uint32_t bytes_in;
+    uint32_t bytes_out;
+    int64_t time_us;
+};
+
+// Counters of the current cycle, added to as each response ends
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t s_responses;
+static uint64_t s_bytes_in;
+static uint64_t s_bytes_out;
+static int64_t s_time_us;
+
+http_encoding_t http_inflate_encoding(const char *value)
+{
+    if (value == NULL || value[0] == '\0' || strcasecmp(value, "identity") == 0) {
+        return HTTP_ENCODING_IDENTITY;
+    }
+    if (strcasecmp(value, "gzip") == 0 || strcasecmp(value, "x-gzip") == 0) {
+        return HTTP_ENCODING_GZIP;
+    }
+    if (strcasecmp(value, "deflate") == 0) {
+        return HTTP_ENCODING_DEFLATE;
+    }
+    return HTTP_ENCODING_UNSUPPORTED;
+}
+
+http_inflate_t *http_inflate_create(http_encoding_t encoding)
+{
+    if (encoding != HTTP_ENCODING_GZIP && encoding != HTTP_ENCODING_DEFLATE) {
+        return NULL;
+    }
+    // The Huffman tables are hit for every symbol; PSRAM only if internal RAM is short
+    http_inflate_t *inflate = heap_caps_calloc(1, sizeof(http_inflate_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (inflate == NULL) {
+        inflate = calloc(1, sizeof(http_inflate_t));
+        if (inflate == NULL) {
+            return NULL;
+        }
+    }
+    tinfl_init(&inflate->tinfl);
+    inflate->encoding = encoding;
+    inflate->flags = TINFL_FLAG_HAS_MORE_INPUT | TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF;
+    inflate->stage = INFLATE_HEADER;
+    return inflate;
+}
+
+// Next optional gzip header field after the given one
+static inflate_stage_t gzip_next_field(const http_inflate_t *inflate, inflate_stage_t after)
+{
+    uint8_t flags = inflate->header[3];
+    if (after < INFLATE_XLEN && (flags & GZIP_FEXTRA)) {
+        return INFLATE_XLEN;
+    }
+    if (after < INFLATE_NAME && (flags & GZIP_FNAME)) {
+        return INFLATE_NAME;
+    }
+    if (after < INFLATE_COMMENT && (flags & GZIP_FCOMMENT)) {
+        return INFLATE_COMMENT;
+    }
+    if (after < INFLATE_HCRC && (flags & GZIP_FHCRC)) {
+        return INFLATE_HCRC;
+    }
+    return INFLATE_BODY;
+}
+
+// The fixed part of the header is complete; check it and pick the next stage
+static esp_err_t header_done(http_inflate_t *inflate)
+{
+    const uint8_t *h = inflate->header;
+    if (inflate->encoding == HTTP_ENCODING_GZIP) {
+        if (h[0] != 0x1F || h[1] != 0x8B || h[2] != 8 || (h[3] & GZIP_FRESERVED)) {
+            ESP_LOGW(TAG, "Not a gzip stream (%02x %02x %02x %02x)", h[0], h[1], h[2], h[3]);
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+        inflate->stage = gzip_next_field(inflate, INFLATE_HEADER);
+        inflate->skip = inflate->stage == INFLATE_HCRC ? 2 : 0;
+        inflate->header_len = 0;
+        return ESP_OK;
+    }
+
+    // "deflate" should be a zlib stream, but some servers send raw deflate
+    if ((h[0] & 0x0F) == 8 && (h[0] >> 4) <= 7 && ((h[0] << 8) | h[1]) % 31 == 0) {
+        inflate->flags |= TINFL_FLAG_PARSE_ZLIB_HEADER | TINFL_FLAG_COMPUTE_ADLER32;
+    }
+    inflate->pending = inflate->header_len;
+    inflate->stage = INFLATE_BODY;
+    return ESP_OK;
+}
+
+// Consume one byte of the header or trailer
+static esp_err_t frame_byte(http_inflate_t *inflate, uint8_t byte)
+{
+    switch (inflate->stage) {
+        case INFLATE_HEADER:
+            inflate->header[inflate->header_len++] = byte;
+            if (inflate->header_len == (inflate->encoding == HTTP_ENCODING_GZIP ? GZIP_HEADER_SIZE : 2)) {
+                return header_done(inflate);
+            }
+            break;
+        case INFLATE_XLEN:
+            inflate->skip |= (size_t)byte << (8 * inflate->header_len++);
+            if (inflate->header_len == 2) {
+                inflate->header_len = 0;
+                inflate->stage = INFLATE_EXTRA;
+                if (inflate->skip == 0) {
+                    inflate->stage = gzip_next_field(inflate, INFLATE_EXTRA);
+                    inflate->skip = inflate->stage == INFLATE_HCRC ? 2 : 0;
+                }
+            }
+            break;
+        case INFLATE_EXTRA:
+        case INFLATE_HCRC:
+            if (--inflate->skip == 0) {
+                inflate->stage = gzip_next_field(inflate, inflate->stage);
+                inflate->skip = inflate->stage == INFLATE_HCRC ? 2 : 0;
+            }
+            break;
+        case INFLATE_NAME:
+        case INFLATE_COMMENT:
+            if (byte == 0) {
+                inflate->stage = gzip_next_field(inflate, inflate->stage);
+                inflate->skip = inflate->stage == INFLATE_HCRC ? 2 : 0;
+            }
+            break;
+        case INFLATE_TRAILER:
+            inflate->header[inflate->header_len++] = byte;
+            if (inflate->header_len == GZIP_TRAILER_SIZE) {
+                const uint8_t *t = inflate->header;
+                uint32_t crc = t[0] | (t[1] << 8) | (t[2] << 16) | ((uint32_t)t[3] << 24);
+                uint32_t size = t[4] | (t[5] << 8) | (t[6] << 16) | ((uint32_t)t[7] << 24);
+                if (crc != inflate->crc || size != inflate->size) {
+                    ESP_LOGW(TAG, "gzip trailer mismatch (crc %08lx/%08lx, size %lu/%lu)",
+                             crc, inflate->crc, size, inflate->size);
+                    return ESP_ERR_INVALID_RESPONSE;
+                }
+                inflate->stage = INFLATE_DONE;
+            }
+            break;
+        case INFLATE_BODY:
+        case INFLATE_DONE:
+            break;
+    }
+    return ESP_OK;
+}
+
+// Run tinfl over src into out. Returns ESP_ERR_INVALID_SIZE when out is full.
+static esp_err_t inflate_body(http_inflate_t *inflate, const uint8_t **src, size_t *src_len,
+                              uint8_t *out, size_t *out_len, size_t out_size)
+{
+    size_t in_bytes = *src_len;
+    size_t out_bytes = out_size - *out_len;
+    int64_t start = esp_timer_get_time();
+    tinfl_status status = tinfl_decompress(&inflate->tinfl, *src, &in_bytes, out, out + *out_len,
+                                           &out_bytes, inflate->flags);
+    inflate->time_us += esp_timer_get_time() - start;
+
+    if (inflate->encoding == HTTP_ENCODING_GZIP) {
+        inflate->crc = esp_rom_crc32_le(inflate->crc, out + *out_len, out_bytes);
+    }
+    inflate->size += out_bytes;
+    inflate->bytes_out += out_bytes;
+    *src += in_bytes;
+    *src_len -= in_bytes;
+    *out_len += out_bytes;
+
+    if (status < TINFL_STATUS_DONE) {
+        ESP_LOGW(TAG, "Corrupt %s stream (tinfl status %d)",
+                 inflate->encoding == HTTP_ENCODING_GZIP ? "gzip" : "deflate", status);
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    if (status == TINFL_STATUS_HAS_MORE_OUTPUT) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (status == TINFL_STATUS_DONE) {
+        if (inflate->encoding != HTTP_ENCODING_GZIP) {
+            inflate->stage = INFLATE_DONE;      // tinfl has checked the zlib Adler-32
+            return ESP_OK;
+        }
+        // tinfl may have read the start of the trailer into its bit buffer
+        inflate->stage = INFLATE_TRAILER;
+        inflate->header_len = 0;
+        tinfl_bit_buf_t bits = inflate->tinfl.m_bit_buf >> (inflate->tinfl.m_num_bits & 7);
+        for (mz_uint32 n = inflate->tinfl.m_num_bits / 8; n > 0 && inflate->stage == INFLATE_TRAILER; n--) {
+            esp_err_t err = frame_byte(inflate, bits & 0xFF);
+            if (err != ESP_OK) {
+                return err;
+            }
+            bits >>= 8;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t http_inflate_feed(http_inflate_t *inflate, const uint8_t **in, size_t *in_len,
+                            uint8_t *out, size_t *out_len, size_t out_size)
+{
+    size_t before = *in_len;
+    esp_err_t err = ESP_OK;
+
+    while (*in_len > 0 && err == ESP_OK) {
+        if (inflate->stage == INFLATE_DONE) {
+            *in += *in_len;     // Nothing follows a stream; ignore padding
+            *in_len = 0;
+        } else if (inflate->stage == INFLATE_BODY && inflate->pending > 0) {
+            // The sniffed start of a deflate body
+            const uint8_t *src = inflate->header + inflate->header_len - inflate->pending;
+            size_t src_len = inflate->pending;
+            err = inflate_body(inflate, &src, &src_len, out, out_len, out_size);
+            inflate->pending = src_len;
+        } else if (inflate->stage == INFLATE_BODY) {
+            err = inflate_body(inflate, in, in_len, out, out_len, out_size);
+        } else {
+            err = frame_byte(inflate, **in);
+            (*in)++;
+            (*in_len)--;
+        }
+    }
+    // The last header byte may complete the sniff with nothing left to feed it
+    if (err == ESP_OK && inflate->stage == INFLATE_BODY && inflate->pending > 0) {
+        const uint8_t *src = inflate->header + inflate->header_len - inflate->pending;
+        size_t src_len = inflate->pending;
+        err = inflate_body(inflate, &src, &src_len, out, out_len, out_size);
+        inflate->pending = src_len;
+    }
+    inflate->bytes_in += before - *in_len;
+    return err;
+}
+
+esp_err_t http_inflate_stream(http_inflate_t *inflate, const uint8_t *in, size_t in_len,
+                              http_inflate_write_t write, void *arg)
+{
+    if (inflate->window == NULL) {
+        inflate->window = malloc(TINFL_LZ_DICT_SIZE);
+        if (inflate->window == NULL) {
+            ESP_LOGE(TAG, "Failed to allocate the %d byte inflate window", TINFL_LZ_DICT_SIZE);
+            return ESP_ERR_NO_MEM;
+        }
+        inflate->flags &= ~TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF;
+    }
+    esp_err_t err;
+    do {
+        // tinfl stops at the end of the window; hand over what it wrote and wrap
+        size_t start = inflate->window_len;
+        err = http_inflate_feed(inflate, &in, &in_len, inflate->window, &inflate->window_len, TINFL_LZ_DICT_SIZE);
+        if (inflate->window_len > start) {
+            esp_err_t write_err = write(arg, inflate->window + start, inflate->window_len - start);
+            if (write_err != ESP_OK) {
+                return write_err;
+            }
+        }
+        inflate->window_len &= TINFL_LZ_DICT_SIZE - 1;
+    } while (err == ESP_ERR_INVALID_SIZE);
+    return err;
+}
+
+bool http_inflate_done(const http_inflate_t *inflate)
+{
+    return inflate != NULL && inflate->stage == INFLATE_DONE;
+}
+
+void http_inflate_destroy(http_inflate_t *inflate)
+{
+    if (inflate == NULL) {
+        return;
+    }
+    portENTER_CRITICAL(&s_lock);
+    s_responses++;
+    s_bytes_in += inflate->bytes_in;
+    s_bytes_out += inflate->bytes_out;
+    s_time_us += inflate->time_us;
+    portEXIT_CRITICAL(&s_lock);
+    free(inflate->window);
+    free(inflate);
+}
+
+void http_inflate_cycle_report(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    uint32_t responses = s_responses;
+    uint64_t bytes_in = s_bytes_in;
+    uint64_t bytes_out = s_bytes_out;
+    int64_t time_us = s_time_us;
+    s_responses = 0;
+    s_bytes_in = 0;
+    s_bytes_out = 0;
+    s_time_us = 0;
+    portEXIT_CRITICAL(&s_lock);
+
+    if (responses == 0) {
+        return;
+    }
+    uint32_t saved = bytes_out > bytes_in ? (uint32_t)(bytes_out - bytes_in) : 0;
+    uint32_t kbps = time_us > 0 ? (uint32_t)(bytes_out * 1000 / time_us) : 0;   // Decoded kB per second
+    ESP_LOGI(TAG, "Cycle compression: %lu responses, %lu bytes received for %lu decoded (%lu saved, %lu%%), "
+             "%lu ms inflating", responses, (uint32_t)bytes_in, (uint32_t)bytes_out, saved,
+             bytes_out ? (uint32_t)(saved * 100 / bytes_out) : 0, (uint32_t)(time_us / 1000));
+    ESP_LOGI(TAG, "INFLATE responses=%lu in=%lu out=%lu saved=%lu ms=%lu kBps=%lu", responses,
+             (uint32_t)bytes_in, (uint32_t)bytes_out, saved, (uint32_t)(time_us / 1000), kbps);
+}
@@ -0,0 +1,564 @@
+#include "http_sink.h"
+#include "app_config.h"
+#include "binlog.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char TAG[] = "http_sink";
+
+// Forward declarations for image management (implemented in main.c)
+esp_err_t get_image_buffer_info(int image_index, char **buffer, size_t *buffer_size, size_t *buffer_allocated);
+void set_image_buffer_info(int image_index, char *buffer, size_t buffer_size, size_t buffer_allocated, bool is_valid);
+void reset_image_buffer(int image_index);
+#if ENABLE_PROGRESSIVE_DISPLAY
+void image_download_progress(int image_index);
+#endif
+
+// Memory ---------------------------------------------------------------------
+
+static esp_err_t mem_grow(http_download_t *download, size_t size)
+{
+    char *buffer = realloc(download->buffer, size);
+    if (buffer == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate %zu bytes for HTTP response", size);
+        return ESP_ERR_NO_MEM;
+    }
+    download->buffer = buffer;
+    download->buffer_allocated = size;
+    return ESP_OK;
+}
+
+static esp_err_t mem_begin(http_sink_t *sink, size_t kept, int64_t length)
+{
+    http_download_t *download = ((http_mem_sink_t *)sink)->download;
+    if (kept == 0) {
+        http_download_free(download);
+    }
+    download->buffer_size = kept;
+    sink->length = kept;
+    // Room for the whole body and its terminator when the length is known
+    size_t needed = kept + (length > 0 ? (size_t)length : 0) + 1;
+    if (download->buffer_allocated < needed && mem_grow(download, needed) != ESP_OK) {
+        return ESP_ERR_NO_MEM;
+    }
+    download->buffer[kept] = '\0';
+    return ESP_OK;
+}
+
+static esp_err_t mem_write(http_sink_t *sink, const uint8_t *data, size_t len)
+{
+    http_download_t *download = ((http_mem_sink_t *)sink)->download;
+    size_t needed = download->buffer_size + len + 1;
+    if (needed > download->buffer_allocated &&
+        mem_grow(download, needed > download->buffer_allocated * 2 ? needed : download->buffer_allocated * 2) != ESP_OK) {
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(download->buffer + download->buffer_size, data, len);
+    download->buffer_size += len;
+    download->buffer[download->buffer_size] = '\0';
+    sink->length = download->buffer_size;
+    return ESP_OK;
+}
+
+static uint8_t *mem_body(http_sink_t *sink, size_t want, size_t *size)
+{
+    http_download_t *download = ((http_mem_sink_t *)sink)->download;
+    // The terminator is kept past the room handed out
+    if (download->buffer_allocated < want + 1) {
+        size_t doubled = download->buffer_allocated * 2;
+        if (mem_grow(download, want + 1 > doubled ? want + 1 : doubled) != ESP_OK) {
+            return NULL;
+        }
+    }
+    *size = download->buffer_allocated - 1;
+    return (uint8_t *)download->buffer;
+}
+
+static esp_err_t mem_commit(http_sink_t *sink, size_t len)
+{
+    http_download_t *download = ((http_mem_sink_t *)sink)->download;
+    download->buffer_size = len;
+    download->buffer[len] = '\0';
+    sink->length = len;
+    return ESP_OK;
+}
+
+static esp_err_t mem_end(http_sink_t *sink, bool complete)
+{
+    return ESP_OK;
+}
+
+static const http_sink_ops_t s_mem_ops = {
+    .begin = mem_begin,
+    .write = mem_write,
+    .body = mem_body,
+    .commit = mem_commit,
+    .end = mem_end,
+};
+
+void http_mem_sink_init(http_mem_sink_t *sink, http_download_t *download)
+{
+    *sink = (http_mem_sink_t) {
+        .base = { .ops = &s_mem_ops, .length = download->buffer_size, .resumable = true },
+        .download = download,
+    };
+}
+
+// Image slot -----------------------------------------------------------------
+
+static void slot_update(int image_index, char *buffer, size_t size, size_t allocated)
+{
+    set_image_buffer_info(image_index, buffer, size, allocated, false);
+#if ENABLE_PROGRESSIVE_DISPLAY
+    image_download_progress(image_index);
+#endif
+}
+
+static esp_err_t slot_begin(http_sink_t *sink, size_t kept, int64_t length)
+{
+    int image_index = ((http_slot_sink_t *)sink)->image_index;
+    char *buffer = NULL;
+    size_t buffer_size = 0, buffer_allocated = 0;
+    get_image_buffer_info(image_index, &buffer, &buffer_size, &buffer_allocated);
+
+    if (kept > 0) {
+        // The rest of a resumed download goes after the bytes kept in the
+        // slot; the buffer must not move while it may be on screen
+        if (buffer == NULL || buffer_size < kept || (length >= 0 && kept + length > buffer_allocated)) {
+            ESP_LOGW(TAG, "Resumed range does not fit image %d, starting over", image_index);
+            return ESP_ERR_INVALID_SIZE;
+        }
+        BINLOG(BL_DL_RESUMED, image_index, kept, length);
+        set_image_buffer_info(image_index, buffer, kept, buffer_allocated, false);
+        sink->length = kept;
+        return ESP_OK;
+    }
+    if (buffer != NULL) {
+        // The server sent the whole body again; drop the bytes kept
+        reset_image_buffer(image_index);
+    }
+    // Content-Length plus some slack, or room for the largest image when the
+    // length is unknown (chunked, or compressed)
+    buffer_allocated = length > 0 ? (size_t)length + 1024 : IMAGE_MAX_BYTES;
+    BINLOG(BL_HTTP_PREALLOC, image_index, buffer_allocated);
+    buffer = malloc(buffer_allocated);
+    if (buffer == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate memory for download buffer of size %zu", buffer_allocated);
+        return ESP_ERR_NO_MEM;
+    }
+    set_image_buffer_info(image_index, buffer, 0, buffer_allocated, false);
+    sink->length = 0;
+    return ESP_OK;
+}
+
+static esp_err_t slot_write(http_sink_t *sink, const uint8_t *data, size_t len)
+{
+    int image_index = ((http_slot_sink_t *)sink)->image_index;
+    char *buffer = NULL;
+    size_t buffer_size = 0, buffer_allocated = 0;
+    get_image_buffer_info(image_index, &buffer, &buffer_size, &buffer_allocated);
+    if (buffer == NULL || buffer_size + len > buffer_allocated) {
+        ESP_LOGE(TAG, "Image %d is larger than its %zu byte slot", image_index, buffer_allocated);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(buffer + buffer_size, data, len);
+    buffer_size += len;
+    slot_update(image_index, buffer, buffer_size, buffer_allocated);
+    sink->length = buffer_size;
+    return ESP_OK;
+}
+
+static uint8_t *slot_body(http_sink_t *sink, size_t want, size_t *size)
+{
+    int image_index = ((http_slot_sink_t *)sink)->image_index;
+    char *buffer = NULL;
+    size_t buffer_size = 0, buffer_allocated = 0;
+    get_image_buffer_info(image_index, &buffer, &buffer_size, &buffer_allocated);
+    *size = buffer_allocated;   // Fixed: rows may be on screen
+    return (uint8_t *)buffer;
+}
+
+static esp_err_t slot_commit(http_sink_t *sink, size_t len)
+{
+    int image_index = ((http_slot_sink_t *)sink)->image_index;
+    char *buffer = NULL;
+    size_t buffer_size = 0, buffer_allocated = 0;
+    get_image_buffer_info(image_index, &buffer, &buffer_size, &buffer_allocated);
+    slot_update(image_index, buffer, len, buffer_allocated);
+    sink->length = len;
+    return ESP_OK;
+}
+
+static esp_err_t slot_end(http_sink_t *sink, bool complete)
+{
+    // Validating the image is the caller's; a partial body stays for a resume
+    return ESP_OK;
+}
+
+static const http_sink_ops_t s_slot_ops = {
+    .begin = slot_begin,
+    .write = slot_write,
+    .body = slot_body,
+    .commit = slot_commit,
+    .end = slot_end,
+};
+
+void http_slot_sink_init(http_slot_sink_t *sink, int image_index, size_t kept)
+{
+    char *buffer = NULL;
+    size_t buffer_size = 0, buffer_allocated = 0;
+    get_image_buffer_info(image_index, &buffer, &buffer_size, &buffer_allocated);
+    // Anything else in the slot is the last image, not part of this body
+    *sink = (http_slot_sink_t) {
+        .base = { .ops = &s_slot_ops, .length = buffer != NULL && buffer_size >= kept ? kept : 0, .resumable = true },
+        .image_index = image_index,
+    };
+}
+
+// File -----------------------------------------------------------------------
+
+static esp_err_t file_begin(http_sink_t *sink, size_t kept, int64_t length)
+{
+    http_file_sink_t *file = (http_file_sink_t *)sink;
+    if (file->file != NULL) {
+        fclose(file->file);
+    }
+    file->file = fopen(file->path, kept > 0 ? "r+b" : "wb");
+    if (file->file == NULL) {
+        ESP_LOGE(TAG, "Failed to open %s", file->path);
+        return ESP_FAIL;
+    }
+    if (kept > 0 && fseek(file->file, kept, SEEK_SET) != 0) {
+        fclose(file->file);
+        file->file = NULL;
+        return ESP_FAIL;
+    }
+    sink->length = kept;
+    return ESP_OK;
+}
+
+static esp_err_t file_write(http_sink_t *sink, const uint8_t *data, size_t len)
+{
+    http_file_sink_t *file = (http_file_sink_t *)sink;
+    if (fwrite(data, 1, len, file->file) != len) {
+        ESP_LOGE(TAG, "Failed to write %s", file->path);
+        return ESP_FAIL;
+    }
+    sink->length += len;
+    return ESP_OK;
+}
+
+static esp_err_t file_end(http_sink_t *sink, bool complete)
+{
+    http_file_sink_t *file = (http_file_sink_t *)sink;
+    if (file->file == NULL) {
+        return ESP_OK;
+    }
+    int result = fclose(file->file);
+    file->file = NULL;
+    return result == 0 ? ESP_OK : ESP_FAIL;
+}
+
+static const http_sink_ops_t s_file_ops = {
+    .begin = file_begin,
+    .write = file_write,
+    .end = file_end,
+};
+
+void http_file_sink_init(http_file_sink_t *sink, const char *path)
+{
+    *sink = (http_file_sink_t) {
+        .base = { .ops = &s_file_ops, .resumable = true },
+        .path = path,
+    };
+}
+
+// Streaming XML --------------------------------------------------------------
+
+static void xml_drop(http_xml_sink_t *xml)
+{
+    if (xml->stream != NULL) {
+        int count = 0;
+        time_t *pub_dates = NULL;
+        char **urls = xml_stream_end(xml->stream, &count, &pub_dates, NULL);
+        xml_parse_free_urls(urls, count);
+        free(pub_dates);
+        xml->stream = NULL;
+    }
+}
+
+static esp_err_t xml_begin(http_sink_t *sink, size_t kept, int64_t length)
+{
+    http_xml_sink_t *xml = (http_xml_sink_t *)sink;
+    xml_drop(xml);
+    xml_parse_free_urls(xml->urls, xml->url_count);
+    free(xml->pub_dates);
+    xml->urls = NULL;
+    xml->url_count = 0;
+    xml->pub_dates = NULL;
+    xml->outlook_pub_date = 0;
+    xml->stream = xml_stream_begin();
+    sink->length = 0;
+    return xml->stream != NULL ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+static esp_err_t xml_write(http_sink_t *sink, const uint8_t *data, size_t len)
+{
+    http_xml_sink_t *xml = (http_xml_sink_t *)sink;
+    sink->length += len;
+    return xml_stream_feed(xml->stream, (const char *)data, len, false) ? ESP_OK : ESP_ERR_INVALID_RESPONSE;
+}
+
+static esp_err_t xml_end(http_sink_t *sink, bool complete)
+{
+    http_xml_sink_t *xml = (http_xml_sink_t *)sink;
+    if (xml->stream == NULL) {
+        return ESP_OK;
+    }
+    if (!complete) {
+        xml_drop(xml);
+        return ESP_OK;
+    }
+    bool valid = xml_stream_feed(xml->stream, NULL, 0, true);
+    xml->urls = xml_stream_end(xml->stream, &xml->url_count, &xml->pub_dates, &xml->outlook_pub_date);
+    xml->stream = NULL;
+    return valid ? ESP_OK : ESP_ERR_INVALID_RESPONSE;
+}
+
+static const http_sink_ops_t s_xml_ops = {
+    .begin = xml_begin,
+    .write = xml_write,
+    .end = xml_end,
+};
+
+void http_xml_sink_init(http_xml_sink_t *sink)
+{
+    *sink = (http_xml_sink_t) {
+        .base = { .ops = &s_xml_ops },
+    };
+}
+
+// Streaming JSON -------------------------------------------------------------
+
+// What the scanner expects next in the top-level object
+enum {
+    JSON_EXPECT_KEY,
+    JSON_EXPECT_COLON,
+    JSON_EXPECT_VALUE,
+    JSON_EXPECT_NEXT,           // ',' or the closing brace
+};
+
+static void json_token_char(http_json_sink_t *json, char c)
+{
+    if (json->token_len < sizeof(json->token) - 1) {
+        json->token[json->token_len++] = c;
+    }
+}
+
+// A key or scalar value of the top-level object has ended
+static void json_token_done(http_json_sink_t *json)
+{
+    json->token[json->token_len] = '\0';
+    if (json->expect == JSON_EXPECT_KEY) {
+        json->field = -1;
+        for (int i = 0; i < json->field_count; i++) {
+            if (strcmp(json->fields[i].key, json->token) == 0) {
+                json->field = i;
+                break;
+            }
+        }
+        json->expect = JSON_EXPECT_COLON;
+        return;
+    }
+    if (json->field >= 0) {
+        http_json_field_t *field = &json->fields[json->field];
+        strcpy(field->value, json->token);
+        field->found = true;
+    }
+    json->expect = JSON_EXPECT_NEXT;
+}
+
+static esp_err_t json_begin(http_sink_t *sink, size_t kept, int64_t length)
+{
+    http_json_sink_t *json = (http_json_sink_t *)sink;
+    json->depth = 0;
+    json->field = -1;
+    json->in_string = false;
+    json->escape = false;
+    json->in_scalar = false;
+    json->valid = false;
+    json->token_len = 0;
+    for (int i = 0; i < json->field_count; i++) {
+        json->fields[i].value[0] = '\0';
+        json->fields[i].found = false;
+    }
+    sink->length = 0;
+    return ESP_OK;
+}
+
+static esp_err_t json_write(http_sink_t *sink, const uint8_t *data, size_t len)
+{
+    http_json_sink_t *json = (http_json_sink_t *)sink;
+    sink->length += len;
+    for (size_t i = 0; i < len; i++) {
+        char c = (char)data[i];
+        bool top = json->depth == 1;
+        if (json->in_string) {
+            if (json->escape) {
+                json->escape = false;
+                if (top) {
+                    json_token_char(json, c);   // Kept as the escaped letter
+                }
+            } else if (c == '\\') {
+                json->escape = true;
+            } else if (c == '"') {
+                json->in_string = false;
+                if (top) {
+                    json_token_done(json);
+                }
+            } else if (top) {
+                json_token_char(json, c);
+            }
+            continue;
+        }
+        if (json->in_scalar) {
+            if (c != ',' && c != '}' && c != ']' && !isspace((unsigned char)c)) {
+                json_token_char(json, c);
+                continue;
+            }
+            json->in_scalar = false;
+            json_token_done(json);
+        }
+        if (isspace((unsigned char)c)) {
+            continue;
+        }
+        if (json->depth == 0) {
+            if (c != '{' || json->valid) {
+                return ESP_ERR_INVALID_RESPONSE;
+            }
+            json->depth = 1;
+            json->expect = JSON_EXPECT_KEY;
+            continue;
+        }
+        switch (c) {
+            case '"':
+                if (top && json->expect != JSON_EXPECT_KEY && json->expect != JSON_EXPECT_VALUE) {
+                    return ESP_ERR_INVALID_RESPONSE;
+                }
+                json->in_string = true;
+                json->token_len = 0;
+                break;
+            case '{':
+            case '[':
+                // Nested values are skipped
+                if (top) {
+                    if (json->expect != JSON_EXPECT_VALUE) {
+                        return ESP_ERR_INVALID_RESPONSE;
+                    }
+                    json->expect = JSON_EXPECT_NEXT;
+                }
+                json->depth++;
+                break;
+            case '}':
+            case ']':
+                if (--json->depth == 0) {
+                    json->valid = true;
+                }
+                break;
+            case ':':
+                if (top) {
+                    if (json->expect != JSON_EXPECT_COLON) {
+                        return ESP_ERR_INVALID_RESPONSE;
+                    }
+                    json->expect = JSON_EXPECT_VALUE;
+                }
+                break;
+            case ',':
+                if (top) {
+                    if (json->expect != JSON_EXPECT_NEXT) {
+                        return ESP_ERR_INVALID_RESPONSE;
+                    }
+                    json->expect = JSON_EXPECT_KEY;
+                }
+                break;
+            default:
+                // Number, true, false or null
+                if (top) {
+                    if (json->expect != JSON_EXPECT_VALUE) {
+                        return ESP_ERR_INVALID_RESPONSE;
+                    }
+                    json->in_scalar = true;
+                    json->token_len = 0;
+                    json_token_char(json, c);
+                }
+                break;
+        }
+    }
+    return ESP_OK;
+}
+
+static esp_err_t json_end(http_sink_t *sink, bool complete)
+{
+    http_json_sink_t *json = (http_json_sink_t *)sink;
+    return complete && json->valid ? ESP_OK : ESP_ERR_INVALID_RESPONSE;
+}
+
+static const http_sink_ops_t s_json_ops = {
+    .begin = json_begin,
+    .write = json_write,
+    .end = json_end,
+};
+
+void http_json_sink_init(http_json_sink_t *sink, http_json_field_t *fields, int count)
+{
+    *sink = (http_json_sink_t) {
+        .base = { .ops = &s_json_ops },
+        .fields = fields,
+        .field_count = count,
+    };
+    json_begin(&sink->base, 0, -1);
+}
+
+// Hash only ------------------------------------------------------------------
+
+static esp_err_t hash_begin(http_sink_t *sink, size_t kept, int64_t length)
+{
+    http_hash_sink_t *hash = (http_hash_sink_t *)sink;
+    if (kept > 0 && kept != sink->length) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (kept == 0) {
+        hash->crc = 0;
+        sink->length = 0;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t hash_write(http_sink_t *sink, const uint8_t *data, size_t len)
+{
+    http_hash_sink_t *hash = (http_hash_sink_t *)sink;
+    hash->crc = esp_rom_crc32_le(hash->crc, data, len);
+    sink->length += len;
+    return ESP_OK;
+}
+
+static esp_err_t hash_end(http_sink_t *sink, bool complete)
+{
+    return ESP_OK;
+}
+
+static const http_sink_ops_t s_hash_ops = {
+    .begin = hash_begin,
+    .write = hash_write,
+    .end = hash_end,
+};
+
+void http_hash_sink_init(http_hash_sink_t *sink)
+{
+    *sink = (http_hash_sink_t) {
+        .base = { .ops = &s_hash_ops, .resumable = true },
+    };
+}
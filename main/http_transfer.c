@@ -0,0 +1,686 @@
+#include "http_transfer.h"
+#include "binlog.h"
+#include "net_timing.h"
+#include "perf_probe.h"
+#include "retry_policy.h"
+#include "esp_log.h"
+#include "esp_crt_bundle.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "lwip/netdb.h"
+#include "sdkconfig.h"
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+static const char TAG[] = "http_transfer";
+
+// Pooled clients keep the TLS session of their last connection for the next
+#if ENABLE_HTTP_KEEPALIVE && defined(CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS)
+#define KEEP_TLS_SESSIONS 1
+#else
+#define KEEP_TLS_SESSIONS 0
+#endif
+
+#if ENABLE_HTTP_KEEPALIVE
+// Idle client kept for the next request to its host
+typedef struct {
+    esp_http_client_handle_t client;    // NULL for a free entry
+    bool connected;                     // Its connection was left open
+    int64_t idle_until_us;              // Past this the server may have closed it
+} pooled_client_t;
+
+static portMUX_TYPE s_pool_lock = portMUX_INITIALIZER_UNLOCKED;
+static pooled_client_t s_pool[RETRY_HOST_COUNT][HTTP_KEEPALIVE_PER_HOST];
+#endif
+
+// Client handles are not safe to use from another task, so an over-budget
+// transfer cancels itself from its event handler
+static bool transfer_over_budget(http_transfer_t *transfer, esp_http_client_handle_t client)
+{
+    if (transfer->expired) {
+        return true;
+    }
+    if (transfer->job.deadline_us == 0 || esp_timer_get_time() < transfer->job.deadline_us) {
+        return false;
+    }
+    transfer->expired = true;
+    esp_http_client_cancel_request(client);
+    return true;
+}
+
+static void resume_on_header(http_resume_t *resume, const char *key, const char *value)
+{
+    if (strcasecmp(key, "Accept-Ranges") == 0) {
+        resume->accept_ranges = strcasecmp(value, "bytes") == 0;
+    } else if (strcasecmp(key, "ETag") == 0) {
+        // If-Range only works with a strong validator
+        if (strncmp(value, "W/", 2) != 0 && strlen(value) < sizeof(resume->etag)) {
+            strcpy(resume->etag, value);
+        }
+    } else if (strcasecmp(key, "Content-Range") == 0) {
+        unsigned long start;
+        if (sscanf(value, "bytes %lu-", &start) == 1) {
+            resume->range_start = start;
+        }
+    }
+}
+
+// Bytes already received that this response continues, 0 if it starts over
+static size_t resume_kept(const http_resume_t *resume, esp_http_client_handle_t client)
+{
+    return (resume->offset > 0 && esp_http_client_get_status_code(client) == 206) ? resume->offset : 0;
+}
+
+// Add the range headers for a resumed attempt, then forget the last response
+static void resume_prepare(http_resume_t *resume, esp_http_client_handle_t client)
+{
+    if (resume->offset > 0) {
+        char range[32];
+        snprintf(range, sizeof(range), "bytes=%zu-", resume->offset);
+        esp_http_client_set_header(client, "Range", range);
+        esp_http_client_set_header(client, "If-Range", resume->etag);
+    }
+    resume->accept_ranges = false;
+    resume->etag[0] = '\0';
+    resume->range_start = 0;
+    resume->broken = false;
+}
+
+// Content-Encoding of a response. The decoder cannot pick up part way
+// through a stream, so a compressed body is never resumed.
+static esp_err_t encoding_on_header(http_transfer_t *transfer, const char *value)
+{
+    transfer->encoding = http_inflate_encoding(value);
+    if (transfer->encoding == HTTP_ENCODING_UNSUPPORTED) {
+        ESP_LOGW(TAG, "Unsupported Content-Encoding: %s", value);
+        return ESP_FAIL;
+    }
+    if (transfer->encoding != HTTP_ENCODING_IDENTITY) {
+        transfer->resume.broken = true;
+    }
+    return ESP_OK;
+}
+
+// Hand the sink the start of a 2xx body, once: all headers and the status
+// code are in by now, so this is where a resumed response is told apart
+static esp_err_t sink_begin(http_transfer_t *transfer, esp_http_client_handle_t client)
+{
+    if (transfer->begun) {
+        return ESP_OK;
+    }
+    transfer->begun = true;
+    size_t kept = resume_kept(&transfer->resume, client);
+    if (kept > 0 && transfer->encoding != HTTP_ENCODING_IDENTITY) {
+        ESP_LOGW(TAG, "Resumed range came back compressed, starting over");
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    int64_t length = transfer->encoding == HTTP_ENCODING_IDENTITY ? esp_http_client_get_content_length(client) : -1;
+    esp_err_t err = transfer->sink->ops->begin(transfer->sink, kept, length >= 0 ? length : -1);
+    if (err != ESP_OK && kept > 0) {
+        transfer->resume.broken = true;
+    }
+    return err;
+}
+
+static esp_err_t sink_write(void *arg, const uint8_t *data, size_t len)
+{
+    http_sink_t *sink = arg;
+    return sink->ops->write(sink, data, len);
+}
+
+// Inflate a chunk of a compressed body: in place into a sink that holds the
+// body in one buffer, else through the decoder's window
+static esp_err_t sink_inflate(http_transfer_t *transfer, const uint8_t *data, size_t len)
+{
+    http_sink_t *sink = transfer->sink;
+    if (transfer->inflate == NULL) {
+        transfer->inflate = http_inflate_create(transfer->encoding);
+        if (transfer->inflate == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    if (sink->ops->body == NULL) {
+        return http_inflate_stream(transfer->inflate, data, len, sink_write, sink);
+    }
+
+    size_t want = sink->length + len * 4 + 1024;
+    size_t last_size = 0;
+    esp_err_t err;
+    do {
+        size_t size = 0;
+        uint8_t *out = sink->ops->body(sink, want, &size);
+        if (out == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+        if (size <= last_size) {
+            ESP_LOGE(TAG, "Body inflates to more than its %zu byte buffer", size);
+            return ESP_ERR_INVALID_SIZE;
+        }
+        size_t out_len = sink->length;
+        err = http_inflate_feed(transfer->inflate, &data, &len, out, &out_len, size);
+        esp_err_t commit_err = sink->ops->commit(sink, out_len);
+        if (commit_err != ESP_OK) {
+            return commit_err;
+        }
+        last_size = size;
+        want = size * 2;
+    } while (err == ESP_ERR_INVALID_SIZE);
+    return err;
+}
+
+static esp_err_t sink_data(http_transfer_t *transfer, esp_http_client_handle_t client, const uint8_t *data, size_t len)
+{
+    if (transfer->sink_err != ESP_OK) {
+        return transfer->sink_err;
+    }
+    int status_code = esp_http_client_get_status_code(client);
+    if (status_code < 200 || status_code >= 300) {
+        return ESP_OK;      // An error page is not the body
+    }
+    PERF_PROBE_BEGIN(probe);
+    esp_err_t err = sink_begin(transfer, client);
+    if (err == ESP_OK) {
+        err = transfer->encoding != HTTP_ENCODING_IDENTITY ? sink_inflate(transfer, data, len)
+                                                           : transfer->sink->ops->write(transfer->sink, data, len);
+    }
+    PERF_PROBE_END(PERF_PROBE_HTTP_DATA, probe);
+    if (err != ESP_OK) {
+        // Nothing more of this body is wanted
+        transfer->sink_err = err;
+        esp_http_client_cancel_request(client);
+    }
+    return err;
+}
+
+// Host name part of url, false if it has none or it does not fit
+static bool url_host(const char *url, char *host, size_t size)
+{
+    const char *start = url != NULL ? strstr(url, "://") : NULL;
+    if (start == NULL) {
+        return false;
+    }
+    start += 3;
+    size_t len = strcspn(start, ":/?#");
+    if (len == 0 || len >= size) {
+        return false;
+    }
+    memcpy(host, start, len);
+    host[len] = '\0';
+    return true;
+}
+
+// Look the host up ahead of the client, to time the lookup on its own
+static void timing_resolve(http_transfer_t *transfer, const char *url)
+{
+    char host[128];
+    struct addrinfo hints = { .ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM };
+    struct addrinfo *res = NULL;
+    if (url_host(url, host, sizeof(host)) && getaddrinfo(host, NULL, &hints, &res) == 0) {
+        transfer->resolved_us = esp_timer_get_time();
+    }
+    if (res != NULL) {
+        freeaddrinfo(res);
+    }
+}
+
+// esp-tls attaches the certificate bundle once the TCP connect completes and
+// right before the handshake, the one point between the two the client shows
+static esp_err_t timing_crt_attach(void *conf)
+{
+    http_transfer_t *transfer = (http_transfer_t *)http_engine_current_job();
+    if (transfer == NULL) {
+        return esp_crt_bundle_attach(conf);
+    }
+    if (transfer->tcp_us == 0) {
+        transfer->tcp_us = esp_timer_get_time();
+    }
+    return transfer->crt_attach(conf);
+}
+
+// Time between two phase marks, -1 unless both were reached
+static int32_t timing_span(int64_t from_us, int64_t to_us)
+{
+    if (from_us == 0 || to_us < from_us) {
+        return -1;
+    }
+    return to_us - from_us < INT32_MAX ? (int32_t)(to_us - from_us) : INT32_MAX;
+}
+
+static void timing_record(const http_transfer_t *transfer)
+{
+    int64_t now = esp_timer_get_time();
+    // Without a TLS handshake the connect ends at ON_CONNECTED
+    int64_t tcp_us = transfer->tcp_us != 0 ? transfer->tcp_us : transfer->connected_us;
+    net_timing_sample_t sample = {
+        .phase_us = {
+            [NET_PHASE_DNS] = timing_span(transfer->started_us, transfer->resolved_us),
+            [NET_PHASE_CONNECT] = timing_span(transfer->resolved_us, tcp_us),
+            [NET_PHASE_TLS] = timing_span(transfer->tcp_us, transfer->connected_us),
+            [NET_PHASE_TTFB] = timing_span(transfer->sent_us, transfer->response_us),
+            [NET_PHASE_TRANSFER] = timing_span(transfer->response_us, now),
+        },
+        .bytes = transfer->job.bytes - transfer->started_bytes,
+    };
+    net_timing_record(transfer->host, &sample);
+}
+
+// "Keep-Alive: timeout=5, max=100": the server closes an idle connection after
+// timeout seconds; keep a second's margin for the next request to reach it
+static void keepalive_on_header(http_transfer_t *transfer, const char *value)
+{
+    const char *timeout = strstr(value, "timeout=");
+    unsigned long seconds;
+    if (timeout != NULL && sscanf(timeout, "timeout=%lu", &seconds) == 1) {
+        transfer->keepalive_ms = seconds > 1 ? (seconds - 1) * 1000 : 1;
+    }
+}
+
+#if ENABLE_HTTP_KEEPALIVE
+// Take an idle client of host out of the pool, one with a live connection first
+static bool pool_take(int host, pooled_client_t *taken)
+{
+    int64_t now = esp_timer_get_time();
+    pooled_client_t *best = NULL;
+    bool best_live = false;
+    portENTER_CRITICAL(&s_pool_lock);
+    for (int i = 0; i < HTTP_KEEPALIVE_PER_HOST; i++) {
+        pooled_client_t *entry = &s_pool[host][i];
+        bool live = entry->connected && now < entry->idle_until_us;
+        if (entry->client != NULL && (best == NULL || (live && !best_live))) {
+            best = entry;
+            best_live = live;
+        }
+    }
+    if (best != NULL) {
+        *taken = *best;
+        best->client = NULL;
+    }
+    portEXIT_CRITICAL(&s_pool_lock);
+    return best != NULL;
+}
+
+// Returns false if the host's pool is full
+static bool pool_put(int host, esp_http_client_handle_t client, bool connected, int64_t idle_until_us)
+{
+    bool kept = false;
+    portENTER_CRITICAL(&s_pool_lock);
+    for (int i = 0; i < HTTP_KEEPALIVE_PER_HOST && !kept; i++) {
+        pooled_client_t *entry = &s_pool[host][i];
+        if (entry->client == NULL) {
+            *entry = (pooled_client_t) { client, connected, idle_until_us };
+            kept = true;
+        }
+    }
+    portEXIT_CRITICAL(&s_pool_lock);
+    return kept;
+}
+
+// Idle client of the transfer's host, set up for this request; NULL if none
+static esp_http_client_handle_t transfer_reuse_client(http_transfer_t *transfer, const esp_http_client_config_t *config)
+{
+    pooled_client_t pooled;
+    if (!pool_take(transfer->host, &pooled)) {
+        return NULL;
+    }
+    esp_http_client_handle_t client = pooled.client;
+    if (pooled.connected && esp_timer_get_time() >= pooled.idle_until_us) {
+        // The server may have dropped it by now: reconnect rather than fail the request
+        esp_http_client_close(client);
+        pooled.connected = false;
+    }
+    if (esp_http_client_set_url(client, config->url) != ESP_OK) {
+        esp_http_client_cleanup(client);
+        return NULL;
+    }
+    // Nothing of the last request carries over but the connection
+    esp_http_client_set_user_data(client, transfer);
+    esp_http_client_set_timeout_ms(client, config->timeout_ms);
+    esp_http_client_set_method(client, config->method);
+    esp_http_client_set_post_field(client, NULL, 0);
+    esp_http_client_delete_header(client, "Content-Type");
+    esp_http_client_delete_header(client, "Range");
+    esp_http_client_delete_header(client, "If-Range");
+    esp_http_client_delete_header(client, "Accept-Encoding");
+    transfer->connected = pooled.connected;
+    transfer->reused = pooled.connected;
+    return client;
+}
+#endif
+
+// Pool the client of an attempt that ended cleanly, else clean it up
+static void transfer_release_client(http_transfer_t *transfer, bool clean)
+{
+    esp_http_client_handle_t client = transfer->job.client;
+#if ENABLE_HTTP_KEEPALIVE
+    if (clean && transfer->host >= 0) {
+        uint32_t idle_ms = HTTP_KEEPALIVE_IDLE_MS;
+        if (transfer->keepalive_ms > 0 && transfer->keepalive_ms < idle_ms) {
+            idle_ms = transfer->keepalive_ms;
+        }
+        esp_http_client_set_user_data(client, NULL);
+        if (pool_put(transfer->host, client, transfer->connected, esp_timer_get_time() + idle_ms * 1000LL)) {
+            return;
+        }
+        esp_http_client_set_user_data(client, transfer);
+    }
+#endif
+    esp_http_client_cleanup(client);
+}
+
+static esp_err_t transfer_event_handler(esp_http_client_event_t *evt)
+{
+    http_transfer_t *transfer = (http_transfer_t *)evt->user_data;
+    if (transfer == NULL) {
+        return ESP_OK;      // A pooled client being closed
+    }
+    int index = transfer->log_index;
+
+    if (transfer_over_budget(transfer, evt->client)) {
+        return ESP_FAIL;
+    }
+
+    switch (evt->event_id) {
+        case HTTP_EVENT_ERROR:
+            if (index >= 0) {
+                BINLOG(BL_HTTP_ERROR, index);
+            } else {
+                ESP_LOGW(TAG, "HTTP error occurred");
+            }
+            break;
+        case HTTP_EVENT_ON_CONNECTED:
+            if (transfer->connected_us == 0) {
+                transfer->connected_us = esp_timer_get_time();
+            }
+            transfer->connected = true;
+            if (index >= 0) {
+                BINLOG(BL_HTTP_CONNECTED, index);
+            }
+            break;
+        case HTTP_EVENT_HEADER_SENT:
+            if (transfer->sent_us == 0) {
+                transfer->sent_us = esp_timer_get_time();
+            }
+            if (index >= 0) {
+                BINLOG(BL_HTTP_HEADER_SENT, index);
+            }
+            break;
+        case HTTP_EVENT_ON_HEADER:
+            // Header strings are transient, so they only go to the synchronous debug log
+            ESP_LOGD(TAG, "HTTP_EVENT_ON_HEADER, key=%s, value=%s", evt->header_key, evt->header_value);
+            if (transfer->response_us == 0) {
+                transfer->response_us = esp_timer_get_time();
+            }
+            if (strcasecmp(evt->header_key, "Retry-After") == 0) {
+                transfer->retry_after_ms = retry_parse_after(evt->header_value);
+            }
+            resume_on_header(&transfer->resume, evt->header_key, evt->header_value);
+            if (strcasecmp(evt->header_key, "Keep-Alive") == 0) {
+                keepalive_on_header(transfer, evt->header_value);
+            }
+            if (strcasecmp(evt->header_key, "Content-Encoding") == 0 &&
+                encoding_on_header(transfer, evt->header_value) != ESP_OK) {
+                transfer->sink_err = ESP_FAIL;
+                return ESP_FAIL;
+            }
+            break;
+        case HTTP_EVENT_ON_DATA:
+            transfer->job.bytes += evt->data_len;
+            if (evt->data_len > 0 && sink_data(transfer, evt->client, evt->data, evt->data_len) != ESP_OK) {
+                return ESP_FAIL;
+            }
+            break;
+        case HTTP_EVENT_ON_FINISH:
+            if (index >= 0 && transfer->begun) {
+                BINLOG(BL_HTTP_FINISH, index, transfer->sink->length);
+            }
+            break;
+        case HTTP_EVENT_DISCONNECTED:
+            transfer->connected = false;
+            if (index >= 0) {
+                BINLOG(BL_HTTP_DISCONNECTED, index);
+            }
+            break;
+        case HTTP_EVENT_REDIRECT:
+            if (index >= 0) {
+                BINLOG(BL_HTTP_REDIRECT, index);
+            }
+            break;
+    }
+    return ESP_OK;
+}
+
+void http_transfer_init(http_transfer_t *transfer, const http_job_ops_t *ops, http_sink_t *sink)
+{
+    *transfer = (http_transfer_t) {
+        .job = { .ops = ops },
+        .sink = sink,
+        .log_index = -1,
+        .host = -1,
+    };
+}
+
+esp_http_client_handle_t http_transfer_client(http_transfer_t *transfer, const esp_http_client_config_t *config)
+{
+    transfer->retry_after_ms = 0;
+    transfer->status_code = 0;
+    transfer->encoding = HTTP_ENCODING_IDENTITY;
+    transfer->inflate = NULL;
+    transfer->begun = false;
+    transfer->sink_err = ESP_OK;
+    transfer->started_us = esp_timer_get_time();
+    transfer->resolved_us = 0;
+    transfer->tcp_us = 0;
+    transfer->connected_us = 0;
+    transfer->sent_us = 0;
+    transfer->response_us = 0;
+    transfer->started_bytes = transfer->job.bytes;
+    transfer->connected = false;
+    transfer->reused = false;
+    transfer->keepalive_ms = 0;
+
+    esp_http_client_config_t attempt = *config;
+    attempt.event_handler = transfer_event_handler;
+    attempt.user_data = transfer;
+    // Only the TLS transport connects without blocking. The engine sets the
+    // timeout of an async client before each poll; a plain http:// client runs
+    // its attempt to the end in one perform() call, so its timeout is the job's
+    // idle timeout, cut short by its deadline.
+    attempt.is_async = strncasecmp(config->url, "https://", 8) == 0;
+    transfer->job.blocking = !attempt.is_async;
+    int64_t timeout_ms = HTTP_ENGINE_POLL_MS;
+    if (transfer->job.blocking) {
+        timeout_ms = transfer->job.idle_timeout_ms > 0 ? transfer->job.idle_timeout_ms : HTTP_TIMEOUT_MS;
+        if (transfer->job.deadline_us != 0) {
+            int64_t left_ms = (transfer->job.deadline_us - transfer->started_us) / 1000;
+            timeout_ms = left_ms < 1 ? 1 : left_ms < timeout_ms ? left_ms : timeout_ms;
+        }
+    }
+    attempt.timeout_ms = (int)timeout_ms;
+    esp_http_client_handle_t client = NULL;
+    if (transfer->host >= 0) {
+        transfer->crt_attach = config->crt_bundle_attach;
+        if (transfer->crt_attach != NULL) {
+            attempt.crt_bundle_attach = timing_crt_attach;
+        }
+#if KEEP_TLS_SESSIONS
+        attempt.save_client_session = true;
+#endif
+#if ENABLE_HTTP_KEEPALIVE
+        if (!transfer->fresh) {
+            client = transfer_reuse_client(transfer, &attempt);
+        }
+        transfer->fresh = false;
+#endif
+        if (!transfer->connected) {
+            timing_resolve(transfer, config->url);
+        }
+    }
+
+    if (client == NULL) {
+        client = esp_http_client_init(&attempt);
+    }
+    transfer->job.client = client;
+    if (client == NULL) {
+        return NULL;
+    }
+    resume_prepare(&transfer->resume, client);
+#if ENABLE_HTTP_COMPRESSION
+    // Ask for a compressed body, unless this attempt resumes an identity one
+    if (transfer->resume.offset == 0) {
+        esp_http_client_set_header(client, "Accept-Encoding", "gzip, deflate");
+    }
+#endif
+    return client;
+}
+
+esp_err_t http_transfer_attempt_end(http_transfer_t *transfer, esp_err_t err)
+{
+    esp_http_client_handle_t client = transfer->job.client;
+    http_sink_t *sink = transfer->sink;
+
+    transfer->status_code = esp_http_client_get_status_code(client);
+    if (err == ESP_OK && !esp_http_client_is_complete_data_received(client)) {
+        err = ESP_FAIL;     // Connection dropped part way through the body
+    }
+    if (err == ESP_OK && transfer->status_code >= 200 && transfer->status_code < 300 && transfer->sink_err == ESP_OK) {
+        transfer->sink_err = sink_begin(transfer, client);  // An empty body still begins and ends
+    }
+    if (err == ESP_OK && transfer->sink_err != ESP_OK) {
+        err = transfer->sink_err;
+    }
+    // A compressed body that ended before its trailer is truncated
+    if (err == ESP_OK && transfer->encoding != HTTP_ENCODING_IDENTITY && !http_inflate_done(transfer->inflate)) {
+        err = ESP_FAIL;
+    }
+    http_inflate_destroy(transfer->inflate);
+    transfer->inflate = NULL;
+    transfer->encoding = HTTP_ENCODING_IDENTITY;
+
+    if (transfer->begun) {
+        esp_err_t end_err = sink->ops->end(sink, err == ESP_OK);
+        if (err == ESP_OK) {
+            err = end_err;
+        }
+    }
+    if (transfer->host >= 0) {
+        timing_record(transfer);
+    }
+    transfer_release_client(transfer, err == ESP_OK && !transfer->expired);
+    transfer->job.client = NULL;
+    return err;
+}
+
+bool http_transfer_retry_fresh(http_transfer_t *transfer, esp_err_t err)
+{
+    http_job_t *job = &transfer->job;
+    int64_t now = esp_timer_get_time();
+    if (err == ESP_OK || err == ESP_ERR_TIMEOUT || !transfer->reused || transfer->response_us != 0 ||
+        transfer->expired || (job->deadline_us != 0 && now >= job->deadline_us)) {
+        return false;
+    }
+    ESP_LOGI(TAG, "Kept-alive connection failed before a response (%s), retrying on a new one",
+             esp_err_to_name(err));
+    // The attempt_start of the next attempt asks the breaker again
+    retry_host_release((retry_host_t)transfer->host);
+    transfer->fresh = true;
+    job->retry_at_us = now;
+    return true;
+}
+
+bool http_transfer_range_valid(const http_transfer_t *transfer)
+{
+    // A 206 must start exactly where the kept bytes end
+    return transfer->status_code != 206 ||
+           (transfer->resume.offset > 0 && transfer->resume.range_start == transfer->resume.offset);
+}
+
+bool http_transfer_body_ok(const http_transfer_t *transfer)
+{
+    return transfer->status_code == 200 || (transfer->status_code == 206 && http_transfer_range_valid(transfer));
+}
+
+size_t http_transfer_resume_point(http_transfer_t *transfer)
+{
+    const http_resume_t *resume = &transfer->resume;
+    bool resumable = transfer->sink->resumable && resume->accept_ranges && resume->etag[0] != '\0' &&
+                     !resume->broken && http_transfer_range_valid(transfer);
+    transfer->resume.offset = resumable ? transfer->sink->length : 0;
+    return transfer->resume.offset;
+}
+
+void http_transfer_close_idle(void)
+{
+#if ENABLE_HTTP_KEEPALIVE
+    int closed = 0;
+    for (int host = 0; host < RETRY_HOST_COUNT; host++) {
+        for (int i = 0; i < HTTP_KEEPALIVE_PER_HOST; i++) {
+            // Out of the pool while it is closed, so that no request takes it meanwhile
+            portENTER_CRITICAL(&s_pool_lock);
+            pooled_client_t pooled = s_pool[host][i];
+            s_pool[host][i].client = NULL;
+            portEXIT_CRITICAL(&s_pool_lock);
+            if (pooled.client == NULL) {
+                continue;
+            }
+            closed += pooled.connected;
+#if KEEP_TLS_SESSIONS
+            esp_http_client_close(pooled.client);
+            if (pool_put(host, pooled.client, false, 0)) {
+                continue;
+            }
+#endif
+            esp_http_client_cleanup(pooled.client);
+        }
+    }
+    if (closed > 0) {
+        ESP_LOGI(TAG, "Closed %d idle connection(s)", closed);
+    }
+#endif
+}
+
+// A plain GET for http_transfer_get()
+typedef struct {
+    http_transfer_t transfer;
+    const char *url;
+} get_request_t;
+
+static esp_err_t get_attempt_start(http_job_t *job)
+{
+    get_request_t *request = (get_request_t *)job;
+    esp_http_client_config_t config = {
+        .url = request->url,
+        .buffer_size = MAX_HTTP_RECV_BUFFER,
+        .crt_bundle_attach = esp_crt_bundle_attach,
+    };
+    return http_transfer_client(&request->transfer, &config) != NULL ? ESP_OK : ESP_FAIL;
+}
+
+static bool get_attempt_end(http_job_t *job, esp_err_t err)
+{
+    get_request_t *request = (get_request_t *)job;
+    job->err = http_transfer_attempt_end(&request->transfer, err);
+    return http_transfer_retry_fresh(&request->transfer, job->err);
+}
+
+static const http_job_ops_t s_get_job_ops = {
+    .attempt_start = get_attempt_start,
+    .attempt_end = get_attempt_end,
+};
+
+esp_err_t http_transfer_get(const char *url, http_sink_t *sink, int *status_code)
+{
+    get_request_t request = { .url = url };
+    http_transfer_init(&request.transfer, &s_get_job_ops, sink);
+    request.transfer.job.idle_timeout_ms = HTTP_TIMEOUT_MS;
+
+    http_job_t *job = &request.transfer.job;
+    http_engine_run(&job, 1, 1);
+    if (status_code != NULL) {
+        *status_code = request.transfer.status_code;
+    }
+    if (job->err == ESP_OK && request.transfer.status_code != 200) {
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    return job->err;
+}
@@ -0,0 +1,602 @@
+#include "image_codec.h"
+#include "app_config.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "rom/tjpgd.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <string.h>
+
+static const char TAG[] = "image_codec";
+
+#define CODEC_WORKER_COUNT 2
+
+typedef struct {
+    image_codec_rows_fn_t fn;
+    void *ctx;
+    int row_start;
+    int row_end;
+} row_job_t;
+
+static TaskHandle_t s_workers[CODEC_WORKER_COUNT];
+static row_job_t s_jobs[CODEC_WORKER_COUNT];
+static SemaphoreHandle_t s_done = NULL;
+static SemaphoreHandle_t s_lock = NULL;
+
+static void row_worker_task(void *pvParameters)
+{
+    row_job_t *job = &s_jobs[(int)(intptr_t)pvParameters];
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (job->row_end > job->row_start) {
+            job->fn(job->ctx, job->row_start, job->row_end);
+        }
+        xSemaphoreGive(s_done);
+    }
+}
+
+esp_err_t image_codec_init(void)
+{
+    if (s_lock != NULL) {
+        return ESP_OK;
+    }
+
+    s_done = xSemaphoreCreateCounting(CODEC_WORKER_COUNT, 0);
+    s_lock = xSemaphoreCreateMutex();
+    if (s_done == NULL || s_lock == NULL) {
+        ESP_LOGE(TAG, "Failed to create worker semaphores");
+        return ESP_ERR_NO_MEM;
+    }
+
+    for (int core = 0; core < CODEC_WORKER_COUNT; core++) {
+        if (xTaskCreatePinnedToCore(row_worker_task, "codec_worker", CODEC_WORKER_STACK_SIZE,
+                                    (void *)(intptr_t)core, CODEC_WORKER_PRIORITY,
+                                    &s_workers[core], core) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create pixel worker on core %d", core);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    ESP_LOGI(TAG, "Pixel workers started on %d cores", CODEC_WORKER_COUNT);
+    return ESP_OK;
+}
+
+void image_codec_parallel_rows(image_codec_rows_fn_t fn, void *ctx, int rows)
+{
+    if (s_lock == NULL) {
+        fn(ctx, 0, rows);
+        return;
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+
+    int split = rows / CODEC_WORKER_COUNT;
+    for (int i = 0; i < CODEC_WORKER_COUNT; i++) {
+        s_jobs[i].fn = fn;
+        s_jobs[i].ctx = ctx;
+        s_jobs[i].row_start = i * split;
+        s_jobs[i].row_end = (i == CODEC_WORKER_COUNT - 1) ? rows : (i + 1) * split;
+        xTaskNotifyGive(s_workers[i]);
+    }
+    for (int i = 0; i < CODEC_WORKER_COUNT; i++) {
+        xSemaphoreTake(s_done, portMAX_DELAY);
+    }
+
+    xSemaphoreGive(s_lock);
+}
+
+bool image_codec_is_indexed(lv_color_format_t cf)
+{
+    return cf == LV_COLOR_FORMAT_I1 || cf == LV_COLOR_FORMAT_I2 ||
+           cf == LV_COLOR_FORMAT_I4 || cf == LV_COLOR_FORMAT_I8;
+}
+
+static uint32_t indexed_bpp(lv_color_format_t cf)
+{
+    switch (cf) {
+        case LV_COLOR_FORMAT_I1: return 1;
+        case LV_COLOR_FORMAT_I2: return 2;
+        case LV_COLOR_FORMAT_I4: return 4;
+        case LV_COLOR_FORMAT_I8: return 8;
+        default: return 0;
+    }
+}
+
+size_t image_codec_palette_entries(lv_color_format_t cf)
+{
+    uint32_t bpp = indexed_bpp(cf);
+    return bpp ? (1u << bpp) : 0;
+}
+
+size_t image_codec_indexed_stride(lv_color_format_t cf, uint32_t width)
+{
+    return (width * indexed_bpp(cf) + 7) / 8;
+}
+
+void image_codec_build_palette_lut(const uint8_t *palette, size_t entries, uint16_t *lut)
+{
+    for (size_t i = 0; i < entries; i++) {
+        // lv_color32_t layout: blue, green, red, alpha
+        uint32_t b = palette[i * 4 + 0];
+        uint32_t g = palette[i * 4 + 1];
+        uint32_t r = palette[i * 4 + 2];
+        uint32_t a = palette[i * 4 + 3];
+        if (a != 0xFF) {
+            r = r * a / 255;
+            g = g * a / 255;
+            b = b * a / 255;
+        }
+        lut[i] = (uint16_t)(((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3));
+    }
+}
+
+typedef struct {
+    const uint8_t *indices;
+    size_t stride;
+    uint32_t width;
+    uint32_t bpp;
+    const uint16_t *lut;
+    uint16_t *dst;
+} expand_ctx_t;
+
+void image_codec_expand_indexed_span(const uint8_t *src, uint32_t bpp, uint32_t x0, uint32_t count,
+                                     const uint16_t *lut, uint16_t *dst)
+{
+    uint32_t x = x0;
+    const uint32_t end = x0 + count;
+
+    if (bpp == 8) {
+        for (; x + 4 <= end; x += 4) {
+            *dst++ = lut[src[x + 0]];
+            *dst++ = lut[src[x + 1]];
+            *dst++ = lut[src[x + 2]];
+            *dst++ = lut[src[x + 3]];
+        }
+        for (; x < end; x++) {
+            *dst++ = lut[src[x]];
+        }
+    } else if (bpp == 4) {
+        // First pixel lives in the high nibble
+        if ((x & 1) && x < end) {
+            *dst++ = lut[src[x >> 1] & 0x0F];
+            x++;
+        }
+        for (; x + 2 <= end; x += 2) {
+            uint8_t pair = src[x >> 1];
+            *dst++ = lut[pair >> 4];
+            *dst++ = lut[pair & 0x0F];
+        }
+        if (x < end) {
+            *dst++ = lut[src[x >> 1] >> 4];
+        }
+    } else {
+        const uint32_t per_byte = 8 / bpp;
+        const uint32_t mask = (1u << bpp) - 1;
+        for (; x < end; x++) {
+            uint32_t shift = 8 - bpp * (x % per_byte + 1);
+            *dst++ = lut[(src[x / per_byte] >> shift) & mask];
+        }
+    }
+}
+
+static void expand_rows(void *arg, int row_start, int row_end)
+{
+    const expand_ctx_t *c = arg;
+
+    for (int y = row_start; y < row_end; y++) {
+        image_codec_expand_indexed_span(c->indices + (size_t)y * c->stride, c->bpp, 0, c->width,
+                                        c->lut, c->dst + (size_t)y * c->width);
+    }
+}
+
+uint32_t image_codec_indexed_bpp(lv_color_format_t cf)
+{
+    return indexed_bpp(cf);
+}
+
+esp_err_t image_codec_expand_indexed(const lv_image_dsc_t *src, const uint16_t *lut, uint16_t *dst)
+{
+    if (src == NULL || lut == NULL || dst == NULL || !image_codec_is_indexed(src->header.cf)) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    expand_ctx_t ctx = {
+        .indices = src->data + image_codec_palette_entries(src->header.cf) * 4,
+        .stride = image_codec_indexed_stride(src->header.cf, src->header.w),
+        .width = src->header.w,
+        .bpp = indexed_bpp(src->header.cf),
+        .lut = lut,
+        .dst = dst,
+    };
+    image_codec_parallel_rows(expand_rows, &ctx, src->header.h);
+    return ESP_OK;
+}
+
+uint8_t *image_codec_alloc_rgb565(uint32_t width, uint32_t height, size_t *size)
+{
+    size_t total = IMAGE_HEADER_SIZE + (size_t)width * height * sizeof(uint16_t);
+    if (size != NULL) {
+        *size = total;
+    }
+
+    uint8_t *buf = heap_caps_malloc(total, MALLOC_CAP_SPIRAM);
+    if (buf == NULL) {
+        return NULL;
+    }
+
+    // Same 12-byte header the conversion API writes for RGB565 .bin output
+    const uint16_t header[IMAGE_HEADER_SIZE / 2] = {
+        LVGL_MAGIC_NUMBER | (LV_COLOR_FORMAT_RGB565 << 8),
+        0,
+        width,
+        height,
+        width * sizeof(uint16_t),
+        0,
+    };
+    memcpy(buf, header, sizeof(header));
+    return buf;
+}
+
+bool image_codec_is_jpeg(const uint8_t *data, size_t len)
+{
+    return data != NULL && len >= 2 && data[0] == 0xFF && data[1] == 0xD8;
+}
+
+typedef struct {
+    const uint8_t *src;
+    size_t len;
+    size_t pos;
+    uint16_t *dst;
+    uint32_t width;
+} jpeg_io_t;
+
+// TJpgDec input callback: copy (or skip, when buf is NULL) the next n bytes
+static uint32_t jpeg_input(JDEC *jd, uint8_t *buf, uint32_t n)
+{
+    jpeg_io_t *io = jd->device;
+    if (n > io->len - io->pos) {
+        n = io->len - io->pos;
+    }
+    if (buf != NULL) {
+        memcpy(buf, io->src + io->pos, n);
+    }
+    io->pos += n;
+    return n;
+}
+
+// TJpgDec output callback: one MCU block of RGB888 (R, G, B) converted in place to RGB565
+static uint32_t jpeg_output(JDEC *jd, void *bitmap, JRECT *rect)
+{
+    jpeg_io_t *io = jd->device;
+    const uint8_t *rgb = bitmap;
+
+    for (uint32_t y = rect->top; y <= rect->bottom; y++) {
+        uint16_t *dst = io->dst + y * io->width + rect->left;
+        for (uint32_t x = rect->left; x <= rect->right; x++) {
+            *dst++ = (uint16_t)(((rgb[0] & 0xF8) << 8) | ((rgb[1] & 0xFC) << 3) | (rgb[2] >> 3));
+            rgb += 3;
+        }
+    }
+    return 1;
+}
+
+esp_err_t image_codec_decode_jpeg(const uint8_t *jpeg, size_t len, uint8_t **out, size_t *out_size,
+                                  uint32_t *decode_us)
+{
+    if (jpeg == NULL || out == NULL || out_size == NULL || !image_codec_is_jpeg(jpeg, len)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *out = NULL;
+    *out_size = 0;
+
+    int64_t start = esp_timer_get_time();
+    void *work = heap_caps_malloc(JPEG_WORK_BUF_SIZE, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (work == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate JPEG work buffer");
+        return ESP_ERR_NO_MEM;
+    }
+
+    jpeg_io_t io = {
+        .src = jpeg,
+        .len = len,
+    };
+    JDEC jd;
+    JRESULT res = jd_prepare(&jd, jpeg_input, work, JPEG_WORK_BUF_SIZE, &io);
+    if (res != JDR_OK) {
+        ESP_LOGE(TAG, "jd_prepare failed: %d", res);
+        free(work);
+        return ESP_FAIL;
+    }
+
+    size_t size = 0;
+    uint8_t *buf = image_codec_alloc_rgb565(jd.width, jd.height, &size);
+    if (buf == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate %zu bytes for decoded JPEG", size);
+        free(work);
+        return ESP_ERR_NO_MEM;
+    }
+
+    io.dst = (uint16_t *)(buf + IMAGE_HEADER_SIZE);
+    io.width = jd.width;
+    res = jd_decomp(&jd, jpeg_output, 0);
+    free(work);
+    if (res != JDR_OK) {
+        ESP_LOGE(TAG, "jd_decomp failed: %d", res);
+        free(buf);
+        return ESP_FAIL;
+    }
+
+    if (decode_us != NULL) {
+        *decode_us = (uint32_t)(esp_timer_get_time() - start);
+    }
+    *out = buf;
+    *out_size = size;
+    return ESP_OK;
+}
+
+// c * a / 255, rounded, without a divide
+static inline uint32_t mul_div255(uint32_t c, uint32_t a)
+{
+    uint32_t t = c * a + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+// Top bits of an xRGB word (B in the low byte) packed to RGB565
+static inline uint16_t xrgb_to_rgb565(uint32_t p)
+{
+    return (uint16_t)(((p >> 8) & 0xF800) | ((p >> 5) & 0x07E0) | ((p >> 3) & 0x001F));
+}
+
+// Blend an ARGB8888 word over black, two channels per multiply
+static inline uint32_t argb_over_black(uint32_t p)
+{
+    uint32_t a = p >> 24;
+    uint32_t rb = (p & 0x00FF00FF) * a + 0x00800080;
+    rb = ((rb + ((rb >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+    uint32_t g = mul_div255((p >> 8) & 0xFF, a);
+    return rb | (g << 8);
+}
+
+static inline uint16_t rgb565_over_black(uint16_t c, uint32_t a)
+{
+    uint32_t r = mul_div255(c >> 11, a);
+    uint32_t g = mul_div255((c >> 5) & 0x3F, a);
+    uint32_t b = mul_div255(c & 0x1F, a);
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+typedef struct {
+    const uint8_t *src;
+    const uint8_t *alpha;       // RGB565A8 alpha plane
+    size_t src_stride;
+    size_t alpha_stride;
+    uint32_t width;
+    lv_color_format_t cf;
+    bool premultiplied;
+    uint16_t *dst;
+} normalize_ctx_t;
+
+static inline uint16_t normalize_pixel(const normalize_ctx_t *c, const uint8_t *row, const uint8_t *arow, uint32_t x)
+{
+    switch (c->cf) {
+        case LV_COLOR_FORMAT_RGB888: {
+            const uint8_t *p = row + x * 3;     // B, G, R
+            return (uint16_t)(((p[2] & 0xF8) << 8) | ((p[1] & 0xFC) << 3) | (p[0] >> 3));
+        }
+        case LV_COLOR_FORMAT_XRGB8888:
+            return xrgb_to_rgb565(((const uint32_t *)row)[x]);
+        case LV_COLOR_FORMAT_ARGB8888: {
+            uint32_t p = ((const uint32_t *)row)[x];
+            if ((p >> 24) != 0xFF && !c->premultiplied) {
+                p = argb_over_black(p);
+            }
+            return xrgb_to_rgb565(p);
+        }
+        case LV_COLOR_FORMAT_RGB565A8: {
+            uint16_t px = ((const uint16_t *)row)[x];
+            uint8_t a = arow[x];
+            return (a == 0xFF || c->premultiplied) ? px : rgb565_over_black(px, a);
+        }
+        case LV_COLOR_FORMAT_ARGB8565: {
+            const uint8_t *p = row + x * 3;     // RGB565 (little endian), then alpha
+            uint16_t px = (uint16_t)(p[0] | (p[1] << 8));
+            return (p[2] == 0xFF || c->premultiplied) ? px : rgb565_over_black(px, p[2]);
+        }
+        default:
+            return 0;
+    }
+}
+
+static void normalize_rows(void *arg, int row_start, int row_end)
+{
+    const normalize_ctx_t *c = arg;
+
+    for (int y = row_start; y < row_end; y++) {
+        const uint8_t *row = c->src + (size_t)y * c->src_stride;
+        const uint8_t *arow = c->alpha ? c->alpha + (size_t)y * c->alpha_stride : NULL;
+        uint16_t *dst = c->dst + (size_t)y * c->width;
+        uint32_t x = 0;
+
+        // Two pixels per 32-bit store when the row is word aligned, halving PSRAM write transactions
+        if (((uintptr_t)dst & 3) == 0) {
+            uint32_t *dst32 = (uint32_t *)dst;
+            for (; x + 2 <= c->width; x += 2) {
+                *dst32++ = normalize_pixel(c, row, arow, x) |
+                           ((uint32_t)normalize_pixel(c, row, arow, x + 1) << 16);
+            }
+        }
+        for (; x < c->width; x++) {
+            dst[x] = normalize_pixel(c, row, arow, x);
+        }
+    }
+}
+
+static void build_gray_lut(uint16_t *lut)
+{
+    for (uint32_t l = 0; l < 256; l++) {
+        lut[l] = (uint16_t)(((l & 0xF8) << 8) | ((l & 0xFC) << 3) | (l >> 3));
+    }
+}
+
+bool image_codec_needs_normalize(lv_color_format_t cf)
+{
+    switch (cf) {
+        case LV_COLOR_FORMAT_RGB888:
+        case LV_COLOR_FORMAT_XRGB8888:
+        case LV_COLOR_FORMAT_ARGB8888:
+        case LV_COLOR_FORMAT_RGB565A8:
+        case LV_COLOR_FORMAT_ARGB8565:
+        case LV_COLOR_FORMAT_L8:
+            return true;
+        default:
+            return false;
+    }
+}
+
+esp_err_t image_codec_normalize(const lv_image_dsc_t *src, uint16_t *dst)
+{
+    if (src == NULL || dst == NULL || !image_codec_needs_normalize(src->header.cf)) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    uint32_t w = src->header.w;
+    uint32_t h = src->header.h;
+    uint32_t bpp = lv_color_format_get_size(src->header.cf);
+    size_t stride = src->header.stride ? src->header.stride : w * bpp;
+
+    // L8 is a 256-entry lookup, the same loop as I8 without a palette
+    if (src->header.cf == LV_COLOR_FORMAT_L8) {
+        uint16_t lut[256];
+        build_gray_lut(lut);
+        expand_ctx_t ctx = {
+            .indices = src->data,
+            .stride = stride,
+            .width = w,
+            .bpp = 8,
+            .lut = lut,
+            .dst = dst,
+        };
+        image_codec_parallel_rows(expand_rows, &ctx, h);
+        return ESP_OK;
+    }
+
+    normalize_ctx_t ctx = {
+        .src = src->data,
+        .src_stride = stride,
+        .width = w,
+        .cf = src->header.cf,
+        .premultiplied = (src->header.flags & LV_IMAGE_FLAGS_PREMULTIPLIED) != 0,
+        .dst = dst,
+    };
+    if (src->header.cf == LV_COLOR_FORMAT_RGB565A8) {
+        // RGB565 plane followed by an A8 plane at half the stride
+        ctx.src_stride = src->header.stride ? src->header.stride : w * 2;
+        ctx.alpha = src->data + ctx.src_stride * h;
+        ctx.alpha_stride = ctx.src_stride / 2;
+    }
+    image_codec_parallel_rows(normalize_rows, &ctx, h);
+    return ESP_OK;
+}
+
+#define ROTATE_TILE 16      // Output tile edge; 16 source rows stay cached while columns are gathered
+
+typedef struct {
+    const uint8_t *src;
+    size_t src_stride;
+    uint32_t width;         // Source size; the output is height x width
+    uint32_t height;
+    uint32_t px_size;
+    bool clockwise;
+    bool pairs;             // 2-byte pixels moved as aligned 32-bit pairs
+    uint8_t *dst;
+} rotate_ctx_t;
+
+// Source pixel that lands at output column x of output row y
+static inline const uint8_t *rotate_src(const rotate_ctx_t *c, uint32_t y, uint32_t x)
+{
+    uint32_t sy = c->clockwise ? c->height - 1 - x : x;
+    uint32_t sx = c->clockwise ? y : c->width - 1 - y;
+    return c->src + (size_t)sy * c->src_stride + sx * c->px_size;
+}
+
+static inline void rotate_px(const rotate_ctx_t *c, uint32_t y, uint32_t x)
+{
+    uint8_t *dst = c->dst + ((size_t)y * c->height + x) * c->px_size;
+    const uint8_t *src = rotate_src(c, y, x);
+    if (c->px_size == 2) {
+        *(uint16_t *)dst = *(const uint16_t *)src;
+    } else {
+        *dst = *src;
+    }
+}
+
+// Output rows y and y + 1, columns x and x + 1, from two 32-bit loads and two
+// 32-bit stores. Each load covers both output rows of one output column.
+static inline void rotate_2x2(const rotate_ctx_t *c, uint32_t y, uint32_t x)
+{
+    const uint8_t *p = rotate_src(c, c->clockwise ? y : y + 1, x);
+    uint32_t a = *(const uint32_t *)p;
+    uint32_t b = *(const uint32_t *)(c->clockwise ? p - c->src_stride : p + c->src_stride);
+    uint32_t *row0 = (uint32_t *)(c->dst + ((size_t)y * c->height + x) * 2);
+    uint32_t *row1 = (uint32_t *)((uint8_t *)row0 + c->height * 2);
+
+    // Clockwise, the low half of each load belongs to row y; counter-clockwise to row y + 1
+    uint32_t lo = (a & 0xFFFF) | (b << 16);
+    uint32_t hi = (a >> 16) | (b & 0xFFFF0000);
+    *row0 = c->clockwise ? lo : hi;
+    *row1 = c->clockwise ? hi : lo;
+}
+
+static void rotate_rows(void *arg, int row_start, int row_end)
+{
+    const rotate_ctx_t *c = arg;
+
+    // Pairs start on even rows; a worker range starting odd does one row alone
+    if (c->pairs && (row_start & 1) && row_start < row_end) {
+        for (uint32_t x = 0; x < c->height; x++) {
+            rotate_px(c, row_start, x);
+        }
+        row_start++;
+    }
+
+    for (uint32_t ty = row_start; ty < (uint32_t)row_end; ty += ROTATE_TILE) {
+        uint32_t y_end = LV_MIN(ty + ROTATE_TILE, (uint32_t)row_end);
+        for (uint32_t tx = 0; tx < c->height; tx += ROTATE_TILE) {
+            uint32_t x_end = LV_MIN(tx + ROTATE_TILE, c->height);
+            uint32_t y = ty;
+            if (c->pairs) {
+                for (; y + 2 <= y_end; y += 2) {
+                    for (uint32_t x = tx; x < x_end; x += 2) {
+                        rotate_2x2(c, y, x);
+                    }
+                }
+            }
+            for (; y < y_end; y++) {
+                for (uint32_t x = tx; x < x_end; x++) {
+                    rotate_px(c, y, x);
+                }
+            }
+        }
+    }
+}
+
+void image_codec_rotate(const uint8_t *src, uint32_t width, uint32_t height, size_t src_stride,
+                        uint32_t px_size, bool clockwise, uint8_t *dst)
+{
+    rotate_ctx_t ctx = {
+        .src = src,
+        .src_stride = src_stride,
+        .width = width,
+        .height = height,
+        .px_size = px_size,
+        .clockwise = clockwise,
+        .dst = dst,
+    };
+    // Even sizes keep every pair load and store word aligned
+    ctx.pairs = px_size == 2 && (width & 1) == 0 && (height & 1) == 0 && (src_stride & 3) == 0 &&
+                ((uintptr_t)src & 3) == 0 && ((uintptr_t)dst & 3) == 0;
+    image_codec_parallel_rows(rotate_rows, &ctx, width);
+}
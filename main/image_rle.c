@@ -0,0 +1,155 @@
+#include "image_rle.h"
+#include <stdbool.h>
+#include <string.h>
+
+// Shortest repeat worth a control byte; shorter repeats are cheaper as literals
+#define RLE_MIN_RUN 3
+
+static inline bool block_equal(const uint8_t *a, const uint8_t *b, uint8_t blk)
+{
+    for (uint8_t i = 0; i < blk; i++) {
+        if (a[i] != b[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static inline bool block_is_zero(const uint8_t *a, uint8_t blk)
+{
+    for (uint8_t i = 0; i < blk; i++) {
+        if (a[i] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t rle_encode(const uint8_t *in, size_t len, uint8_t *out, size_t out_cap, uint8_t blk)
+{
+    if (blk == 0 || len % blk != 0) {
+        return 0;
+    }
+
+    size_t blocks = len / blk;
+    size_t i = 0;
+    size_t o = 0;
+    size_t lit_start = 0;
+    size_t lit_count = 0;
+
+    while (i < blocks) {
+        const uint8_t *cur = in + i * blk;
+        size_t run = 1;
+        while (i + run < blocks && run < RLE_MAX_RUN && block_equal(cur, cur + run * blk, blk)) {
+            run++;
+        }
+
+        if (run >= RLE_MIN_RUN || lit_count == RLE_MAX_RUN) {
+            // Flush pending literals first
+            if (lit_count > 0) {
+                size_t bytes = lit_count * blk;
+                if (o + 1 + bytes > out_cap) {
+                    return 0;
+                }
+                out[o++] = (uint8_t)(0x80 | lit_count);
+                memcpy(out + o, in + lit_start * blk, bytes);
+                o += bytes;
+                lit_count = 0;
+            }
+        }
+
+        if (run >= RLE_MIN_RUN) {
+            if (o + 1 + blk > out_cap) {
+                return 0;
+            }
+            out[o++] = (uint8_t)run;
+            memcpy(out + o, cur, blk);
+            o += blk;
+            i += run;
+        } else {
+            if (lit_count == 0) {
+                lit_start = i;
+            }
+            lit_count++;
+            i++;
+        }
+    }
+
+    if (lit_count > 0) {
+        size_t bytes = lit_count * blk;
+        if (o + 1 + bytes > out_cap) {
+            return 0;
+        }
+        out[o++] = (uint8_t)(0x80 | lit_count);
+        memcpy(out + o, in + lit_start * blk, bytes);
+        o += bytes;
+    }
+
+    return o;
+}
+
+size_t rle_decode(const uint8_t *in, size_t in_len, uint8_t *out, size_t out_cap, uint8_t blk)
+{
+    size_t rd = 0;
+    size_t wr = 0;
+
+    while (rd < in_len) {
+        uint8_t ctrl = in[rd++];
+        if (ctrl & 0x80) {
+            size_t bytes = (size_t)(ctrl & 0x7f) * blk;
+            if (rd + bytes > in_len || wr + bytes > out_cap) {
+                return 0;
+            }
+            memcpy(out + wr, in + rd, bytes);
+            rd += bytes;
+            wr += bytes;
+        } else {
+            if (rd + blk > in_len || wr + (size_t)ctrl * blk > out_cap) {
+                return 0;
+            }
+            for (uint8_t n = 0; n < ctrl; n++) {
+                memcpy(out + wr, in + rd, blk);
+                wr += blk;
+            }
+            rd += blk;
+        }
+    }
+
+    return wr;
+}
+
+size_t rle_decode_xor(const uint8_t *in, size_t in_len, uint8_t *dst, size_t dst_len, uint8_t blk)
+{
+    size_t rd = 0;
+    size_t wr = 0;
+
+    while (rd < in_len) {
+        uint8_t ctrl = in[rd++];
+        if (ctrl & 0x80) {
+            size_t bytes = (size_t)(ctrl & 0x7f) * blk;
+            if (rd + bytes > in_len || wr + bytes > dst_len) {
+                return 0;
+            }
+            for (size_t k = 0; k < bytes; k++) {
+                dst[wr + k] ^= in[rd + k];
+            }
+            rd += bytes;
+            wr += bytes;
+        } else {
+            size_t bytes = (size_t)ctrl * blk;
+            if (rd + blk > in_len || wr + bytes > dst_len) {
+                return 0;
+            }
+            const uint8_t *pattern = in + rd;
+            if (!block_is_zero(pattern, blk)) {
+                for (size_t k = 0; k < bytes; k++) {
+                    dst[wr + k] ^= pattern[k % blk];
+                }
+            }
+            rd += blk;
+            wr += bytes;
+        }
+    }
+
+    return wr;
+}
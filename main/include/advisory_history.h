@@ -0,0 +1,101 @@
+#pragma once
+
+#include "esp_err.h"
+#include "lvgl.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HISTORY_STORM_ID_LEN 16
+
+/*
+ * Per-storm advisory history kept on the storage partition.
+ *
+ * Each storm has one file holding a keyframe (RLE-compressed RGB565 frame)
+ * followed by XOR deltas against the previous advisory, also RLE-compressed.
+ * Only the last CONFIG_ADVISORY_HISTORY_DEPTH advisories are kept; when the
+ * file grows past that, the oldest frame is folded into a new keyframe.
+ */
+
+typedef struct history_player history_player_t;
+
+/**
+ * @brief Create the history directory and lock; requires storage_init()
+ *
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t history_init(void);
+
+/**
+ * @brief Derive a storm identifier (e.g. "AL052024") from a cone image URL
+ *
+ * @param url Cone graphic URL from the NHC feed
+ * @param id Output buffer, at least HISTORY_STORM_ID_LEN bytes
+ * @param len Size of the output buffer
+ * @return true if the URL names a storm, false otherwise (e.g. outlook images)
+ */
+bool history_storm_id_from_url(const char *url, char *id, size_t len);
+
+/**
+ * @brief Append an advisory frame to a storm's history
+ *
+ * The frame is skipped if it is identical to the newest stored advisory.
+ * Only RGB565 images are recorded.
+ *
+ * @param storm_id Storm identifier from history_storm_id_from_url()
+ * @param img Decoded image to record
+ * @param timestamp Time the advisory was downloaded
+ * @return ESP_OK if recorded or unchanged, error code otherwise
+ */
+esp_err_t history_record(const char *storm_id, const lv_image_dsc_t *img, time_t timestamp);
+
+/**
+ * @brief Number of advisories stored for a storm
+ *
+ * @return Advisory count, 0 if none
+ */
+int history_count(const char *storm_id);
+
+/**
+ * @brief Load a storm's history into PSRAM for playback
+ *
+ * The compressed records are held in PSRAM and applied to a single
+ * decoded frame, so seeking costs only the size of the deltas crossed.
+ *
+ * @return Player handle, or NULL if there is no history or no memory
+ */
+history_player_t *history_player_open(const char *storm_id);
+
+/**
+ * @brief Number of advisories available in the player
+ */
+int history_player_count(const history_player_t *player);
+
+/**
+ * @brief Move the player to an advisory and return its frame
+ *
+ * The returned descriptor is owned by the player and stays valid (with
+ * updated pixels) until history_player_close().
+ *
+ * @param index Advisory index, 0 is the oldest
+ * @return Image descriptor of the frame, or NULL on error
+ */
+const lv_image_dsc_t *history_player_seek(history_player_t *player, int index);
+
+/**
+ * @brief Download time of an advisory in the player
+ */
+time_t history_player_timestamp(const history_player_t *player, int index);
+
+/**
+ * @brief Release a player and its buffers
+ */
+void history_player_close(history_player_t *player);
+
+#ifdef __cplusplus
+}
+#endif
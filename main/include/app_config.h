@@ -15,6 +15,7 @@ extern "C" {
 /* Image Management */
 #define MAX_IMAGES 10
 #define IMAGE_DISPLAY_INTERVAL_MS (10 * 1000)  // 10 seconds between images
+#define IMAGE_DISPLAY_MIN_INTERVAL_MS 1000     // Shortest dwell accepted from the console
 
 /* Backlight Settings */
 #define BACKLIGHT_TIMEOUT_MS (60 * 1000)  // 120 seconds timeout
@@ -37,6 +38,55 @@ extern "C" {
 #define NETWORK_STABILIZATION_DELAY_MS 3000
 #define HTTP_TIMEOUT_MS 30000
 #define XML_TIMEOUT_MS 15000
+#define HTTP_ETAG_MAX_LEN 80      // Longest ETag kept to resume a download with If-Range
+#define HTTP_ENGINE_POLL_MS 20    // Longest pass of the HTTP engine while every transfer waits on its socket
+#ifdef CONFIG_HTTP_COMPRESSION
+#define ENABLE_HTTP_COMPRESSION 1 // Ask for gzip/deflate bodies and inflate them as they arrive
+#else
+#define ENABLE_HTTP_COMPRESSION 0
+#endif
+#ifdef CONFIG_HTTP_KEEPALIVE
+#define ENABLE_HTTP_KEEPALIVE 1   // Send the next request to a host over the connection of the last one
+#else
+#define ENABLE_HTTP_KEEPALIVE 0
+#endif
+#ifdef CONFIG_HTTP_KEEPALIVE_IDLE_MS
+#define HTTP_KEEPALIVE_IDLE_MS CONFIG_HTTP_KEEPALIVE_IDLE_MS
+#else
+#define HTTP_KEEPALIVE_IDLE_MS 4000
+#endif
+#define HTTP_KEEPALIVE_PER_HOST 4 // Idle clients kept per host: one per download in flight (DOWNLOAD_CONCURRENCY_MAX)
+
+/* Update pipeline budgets */
+#ifdef CONFIG_BUDGET_FEED_SECONDS
+#define BUDGET_FEED_MS (CONFIG_BUDGET_FEED_SECONDS * 1000)
+#define BUDGET_IMAGE_MS (CONFIG_BUDGET_IMAGE_SECONDS * 1000)
+#define BUDGET_CYCLE_MS (CONFIG_BUDGET_CYCLE_SECONDS * 1000)
+#else
+#define BUDGET_FEED_MS (20 * 1000)
+#define BUDGET_IMAGE_MS (45 * 1000)
+#define BUDGET_CYCLE_MS (240 * 1000)
+#endif
+
+/* Retries and per-host circuit breakers */
+#ifdef CONFIG_RETRY_MAX_ATTEMPTS
+#define RETRY_MAX_ATTEMPTS CONFIG_RETRY_MAX_ATTEMPTS
+#define RETRY_BASE_DELAY_MS CONFIG_RETRY_BASE_DELAY_MS
+#define RETRY_BREAKER_FAILURES CONFIG_RETRY_BREAKER_FAILURES
+#define RETRY_BREAKER_OPEN_MS (CONFIG_RETRY_BREAKER_OPEN_SECONDS * 1000)
+#define RETRY_SLOT_DELAY_MS (CONFIG_RETRY_SLOT_DELAY_SECONDS * 1000)
+#define RETRY_SLOT_PASSES CONFIG_RETRY_SLOT_PASSES
+#else
+#define RETRY_MAX_ATTEMPTS 3
+#define RETRY_BASE_DELAY_MS 1000
+#define RETRY_BREAKER_FAILURES 4
+#define RETRY_BREAKER_OPEN_MS (60 * 1000)
+#define RETRY_SLOT_DELAY_MS (30 * 1000)
+#define RETRY_SLOT_PASSES 3
+#endif
+#define RETRY_MAX_DELAY_MS (16 * 1000)
+#define RETRY_AFTER_MAX_MS (60 * 60 * 1000)
+#define RETRY_BREAKER_OPEN_MAX_MS (15 * 60 * 1000)
 
 /* URLs */
 #define NHC_XML_FEED_URL "https://www.nhc.noaa.gov/index-at.xml"
@@ -57,6 +107,7 @@ extern "C" {
 // Times to update images from nhc 00:10 UTC, and every 3 hours after
 #define NHC_UPDATE_TIMES { "00:10", "03:10", "06:10", "09:10", "12:10", "15:10", "18:10", "21:10" }
 #define NHC_UPDATE_TIMES_COUNT 8
+#define CLOCK_VALID_EPOCH 1451606400     // 2016-01-01; anything earlier means the clock is not set
 
 /* WiFi Settings */
 #define MAXIMUM_RETRY 5
@@ -68,6 +119,16 @@ extern "C" {
 #define UPDATE_TASK_STACK_SIZE 16384
 #define DISPLAY_TASK_PRIORITY 4
 #define UPDATE_TASK_PRIORITY 5
+#define CODEC_WORKER_STACK_SIZE 3072
+#define CODEC_WORKER_PRIORITY 4
+#define PROCESS_TASK_STACK_SIZE 8192
+#define PROCESS_TASK_PRIORITY 4
+#ifdef CONFIG_DOWNLOAD_CONCURRENCY
+#define DOWNLOAD_CONCURRENCY CONFIG_DOWNLOAD_CONCURRENCY
+#else
+#define DOWNLOAD_CONCURRENCY 2
+#endif
+#define DOWNLOAD_CONCURRENCY_MAX 4      // Upper bound when changed at runtime
 
 /* LVGL Settings */
 #define LVGL_TASK_MAX_SLEEP_MS 500
@@ -95,6 +156,160 @@ extern "C" {
 #define MIN_VALID_IMAGE_SIZE 100  // Minimum bytes for valid image
 #define IMAGE_HEADER_SIZE 12      // Custom binary format header size
 #define LVGL_MAGIC_NUMBER 0x19    // Expected magic number for LVGL v9
+#define PALETTE_ENTRY_SIZE 4      // lv_color32_t per palette entry in indexed images
+
+/* Transfer formats requested from the conversion API, per product class */
+#define TRANSFER_CF_JPEG "JPEG"   // Not an LVGL format: requests JPEG output instead of a .bin
+
+#if defined(CONFIG_OUTLOOK_FORMAT_I8)
+#define OUTLOOK_TRANSFER_CF "I8"
+#elif defined(CONFIG_OUTLOOK_FORMAT_I4)
+#define OUTLOOK_TRANSFER_CF "I4"
+#elif defined(CONFIG_OUTLOOK_FORMAT_JPEG)
+#define OUTLOOK_TRANSFER_CF TRANSFER_CF_JPEG
+#else
+#define OUTLOOK_TRANSFER_CF "RGB565"
+#endif
+
+#if defined(CONFIG_CONE_FORMAT_I8)
+#define CONE_TRANSFER_CF "I8"
+#elif defined(CONFIG_CONE_FORMAT_I4)
+#define CONE_TRANSFER_CF "I4"
+#elif defined(CONFIG_CONE_FORMAT_JPEG)
+#define CONE_TRANSFER_CF TRANSFER_CF_JPEG
+#else
+#define CONE_TRANSFER_CF "RGB565"
+#endif
+
+#ifdef CONFIG_JPEG_TRANSFER_QUALITY
+#define JPEG_TRANSFER_QUALITY CONFIG_JPEG_TRANSFER_QUALITY
+#else
+#define JPEG_TRANSFER_QUALITY 80
+#endif
+#define JPEG_WORK_BUF_SIZE 3100   // Minimum work area for the ROM TJpgDec
+
+/* Display orientation: images are turned by DISPLAY_ROTATION degrees clockwise at load time */
+#if defined(CONFIG_DISPLAY_PORTRAIT_TOP_LEFT)
+#define DISPLAY_ROTATION 90
+#elif defined(CONFIG_DISPLAY_PORTRAIT_TOP_RIGHT)
+#define DISPLAY_ROTATION 270
+#else
+#define DISPLAY_ROTATION 0
+#endif
+#define CAPTION_HEIGHT 40         // Caption strip along the bottom edge as viewed
+
+#if DISPLAY_ROTATION
+#define IMAGE_MAX_SIZE "480x740"  // maxSize sent to the conversion API (portrait)
+#define IMAGE_MAX_PIXELS (480 * 740)
+#else
+#define IMAGE_MAX_SIZE "800x420"  // maxSize sent to the conversion API
+#define IMAGE_MAX_PIXELS (800 * 420)
+#endif
+// Largest image a slot can hold: header, a 256-entry palette and RGB565 pixels
+#define IMAGE_MAX_BYTES (IMAGE_HEADER_SIZE + 256 * PALETTE_ENTRY_SIZE + IMAGE_MAX_PIXELS * 2)
+
+/* Slot storage and the streaming slot decoder */
+#ifdef CONFIG_SLOT_RLE_COMPRESSION
+#define ENABLE_SLOT_COMPRESSION 1
+#else
+#define ENABLE_SLOT_COMPRESSION 0
+#endif
+#ifdef CONFIG_SLOT_DECODER_BAND_ROWS
+#define SLOT_BAND_ROWS CONFIG_SLOT_DECODER_BAND_ROWS
+#else
+#define SLOT_BAND_ROWS 16
+#endif
+#define SLOT_DECODER_MAX_WIDTH 800  // Widest image the band cache holds
+#ifdef CONFIG_PROGRESSIVE_DISPLAY
+#define ENABLE_PROGRESSIVE_DISPLAY 1
+#else
+#define ENABLE_PROGRESSIVE_DISPLAY 0
+#endif
+
+/* Hot-path probes */
+#ifdef CONFIG_PERF_PROBES
+#define ENABLE_PERF_PROBES 1
+#else
+#define ENABLE_PERF_PROBES 0
+#endif
+#define PERF_BENCH_ITERATIONS 20       // Feed parses and full-screen renders per benchmark run
+
+/* Deferred logging */
+#ifdef CONFIG_DEFERRED_LOG
+#define ENABLE_DEFERRED_LOG 1
+#else
+#define ENABLE_DEFERRED_LOG 0
+#endif
+#ifdef CONFIG_DEFERRED_LOG_RECORDS
+#define BINLOG_RING_RECORDS CONFIG_DEFERRED_LOG_RECORDS
+#else
+#define BINLOG_RING_RECORDS 256
+#endif
+#define BINLOG_TASK_STACK_SIZE 3072
+#define BINLOG_TASK_PRIORITY 1          // Below every application task
+#define BINLOG_DRAIN_PERIOD_MS 200
+#define BINLOG_LINE_MAX 160             // Longest formatted message
+
+/* Timeline tracing */
+#ifdef CONFIG_TRACE
+#define ENABLE_TRACE 1
+#else
+#define ENABLE_TRACE 0
+#endif
+#ifdef CONFIG_TRACE_RING_EVENTS
+#define TRACE_RING_EVENTS CONFIG_TRACE_RING_EVENTS
+#else
+#define TRACE_RING_EVENTS 512
+#endif
+#define TRACE_MAX_TASKS 16              // Task names remembered per core
+
+/* Serial console */
+#ifdef CONFIG_SERIAL_CONSOLE
+#define ENABLE_SERIAL_CONSOLE 1
+#else
+#define ENABLE_SERIAL_CONSOLE 0
+#endif
+#define CONSOLE_PROMPT "cyd> "
+#define CONSOLE_TASK_STACK_SIZE 8192    // Feed parse benchmark runs on the console task
+#define CONSOLE_TASK_PRIORITY 2
+#define CONSOLE_BENCH_DEFAULT_RUNS 10
+#define CONSOLE_ROTATION_MAX_ROUNDS 100 // Each round renders every valid image once
+
+/* Data freshness (NHC pubDate to screen) */
+#ifdef CONFIG_FRESHNESS_STALE_MINUTES
+#define FRESHNESS_STALE_MINUTES CONFIG_FRESHNESS_STALE_MINUTES
+#else
+#define FRESHNESS_STALE_MINUTES 90
+#endif
+#define FRESHNESS_SAMPLES 64            // Recent advisories kept per product for percentiles
+
+/* Network phase timing */
+#define NET_TIMING_SAMPLES 32           // Recent requests kept per host for the phase histograms
+#define NET_TIMING_BUCKETS 14           // Power-of-two ms buckets: <1, <2, <4 ... <4096, >=4096
+
+/* Storage */
+#define STORAGE_PARTITION_LABEL "storage"
+#define STORAGE_BASE_PATH "/storage"
+
+/* Advisory History */
+#ifdef CONFIG_ADVISORY_HISTORY
+#define ENABLE_ADVISORY_HISTORY 1
+#define HISTORY_DEPTH CONFIG_ADVISORY_HISTORY_DEPTH
+#define HISTORY_PLAYBACK_FPS CONFIG_ADVISORY_HISTORY_FPS
+#else
+#define ENABLE_ADVISORY_HISTORY 0
+#define HISTORY_DEPTH 0
+#define HISTORY_PLAYBACK_FPS 1
+#endif
+#define HISTORY_DIR STORAGE_BASE_PATH "/history"
+#define HISTORY_VIEW_TIMEOUT_MS (60 * 1000)  // Return to rotation after a minute without input
+
+/* Storage Benchmark */
+#define STORAGE_BENCH_BASE_PATH "/bench"
+#define STORAGE_BENCH_RECORD_SIZE (IMAGE_HEADER_SIZE + 800 * 420 * 2)  // One RGB565 image slot
+#define STORAGE_BENCH_RANDOM_READS 256
+#define STORAGE_BENCH_REWRITES 4
+#define STORAGE_BENCH_REDRAW_PERIOD_MS 33  // Full-screen invalidation rate while benchmarking
 
 #ifdef __cplusplus
 }
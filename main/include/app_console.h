@@ -0,0 +1,36 @@
+#pragma once
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Serial console for profiling a unit in place. Commands:
+ *
+ *   update [feed|images]     Run an update cycle now (default: feed and images)
+ *   bench_parse [runs]       Time the feed parse over the last fetched feed
+ *   bench_sinks [runs]       Time a feed download into each response sink
+ *   bench_rotation [rounds]  Time switching to each valid image (rebuild + render)
+ *   metrics                  Boot timeline, freshness, budget overruns, retries, network timing, probes
+ *   heap [internal|psram|dma] Heap totals, or the region map for one capability
+ *   trace                    Print and clear the timeline trace (CONFIG_TRACE)
+ *   dwell [ms]               Show or set how long each image stays up
+ *   concurrency [n]          Show or set how many images download at once
+ *
+ * Runtime changes are not saved and revert to the configured values on reset.
+ */
+
+/**
+ * @brief Register the commands and start the REPL task on the console port
+ *
+ * Call once the update and display tasks are running.
+ *
+ * @return ESP_OK on success, or the esp_console error
+ */
+esp_err_t app_console_start(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "app_config.h"
+#include "binlog_msgs.h"
+#include "esp_err.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Deferred binary logging for the download and display paths. A call site
+ * records a message id from binlog_msgs.h and up to four integer arguments
+ * into a ring in internal RAM; a low-priority task formats and prints the
+ * records later, or with CONFIG_DEFERRED_LOG_RAW prints them as hex for
+ * tools/binlog/binlog_decode.py to format on the host. Nothing is formatted
+ * or written to the UART on the calling task.
+ *
+ * Messages above the default log level are discarded when recorded. With
+ * CONFIG_DEFERRED_LOG off, records are formatted and printed immediately,
+ * which is the baseline the per-cycle report is measured against.
+ */
+
+#define BINLOG_MAX_ARGS 4
+
+typedef enum {
+#define BINLOG_ENUM(id, level, tag, fmt) id,
+    BINLOG_MESSAGES(BINLOG_ENUM)
+#undef BINLOG_ENUM
+    BINLOG_MSG_COUNT,
+} binlog_msg_t;
+
+/**
+ * @brief Start the formatting task
+ *
+ * Records made before this are kept in the ring and printed once it runs.
+ *
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the task could not be created
+ */
+esp_err_t binlog_init(void);
+
+/**
+ * @brief Record a message; use BINLOG() rather than calling this directly
+ */
+void binlog_write(binlog_msg_t msg, uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3);
+
+/**
+ * @brief Print everything recorded so far and wait for it to drain
+ *
+ * @param timeout_ms Longest time to wait for the formatting task
+ */
+void binlog_flush(uint32_t timeout_ms);
+
+/**
+ * @brief Log and reset the counters for one update cycle
+ *
+ * Reports records written and dropped, the time spent recording them on the
+ * calling tasks, and the time spent formatting and printing them, which is
+ * what those tasks would otherwise have spent inline.
+ */
+void binlog_cycle_report(void);
+
+// BINLOG(id, args...) with zero to four integer arguments
+#define BINLOG(...) BINLOG_PAD_(__VA_ARGS__, 0, 0, 0, 0, 0)
+#define BINLOG_PAD_(msg, a0, a1, a2, a3, ...) \
+    binlog_write((msg), (uint32_t)(a0), (uint32_t)(a1), (uint32_t)(a2), (uint32_t)(a3))
+
+#ifdef __cplusplus
+}
+#endif
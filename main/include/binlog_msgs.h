@@ -0,0 +1,63 @@
+#pragma once
+
+/*
+ * Deferred log message table. Each entry is
+ *   X(id, level, tag, format)
+ * where level is an esp_log_level_t suffix and the format takes up to
+ * BINLOG_MAX_ARGS 32-bit integer arguments (%ld, %lu, %lx). Strings
+ * cannot be recorded since they may be gone by the time the record is
+ * formatted.
+ *
+ * Record ids are positions in this table, so tools/binlog/binlog_decode.py
+ * reads it directly to format raw records on the host; append new messages
+ * rather than reordering.
+ */
+
+#define BINLOG_MESSAGES(X) \
+    /* Image downloads (http_client.c) */ \
+    X(BL_HTTP_ERROR,          INFO,  "http_client", "HTTP_EVENT_ERROR for image %ld") \
+    X(BL_HTTP_CONNECTED,      INFO,  "http_client", "HTTP_EVENT_ON_CONNECTED for image %ld") \
+    X(BL_HTTP_HEADER_SENT,    INFO,  "http_client", "HTTP_EVENT_HEADER_SENT for image %ld") \
+    X(BL_HTTP_PREALLOC,       INFO,  "http_client", "Pre-allocating download buffer for image %ld with %lu bytes") \
+    X(BL_HTTP_DATA,           DEBUG, "http_client", "HTTP_EVENT_ON_DATA for image %ld, len=%ld") \
+    X(BL_HTTP_FINISH,         INFO,  "http_client", "Download complete for image %ld: %lu bytes in buffer") \
+    X(BL_HTTP_DISCONNECTED,   INFO,  "http_client", "HTTP_EVENT_DISCONNECTED for image %ld") \
+    X(BL_HTTP_REDIRECT,       INFO,  "http_client", "HTTP_EVENT_REDIRECT for image %ld") \
+    X(BL_DL_CROP_OUTLOOK,     INFO,  "http_client", "Adding crop parameters for Atlantic outlook image") \
+    X(BL_DL_CROP_CONE,        INFO,  "http_client", "Adding crop parameters for forecast cone") \
+    X(BL_DL_REQUEST,          INFO,  "http_client", "Converting image %ld, %lu bytes internal heap free") \
+    X(BL_DL_STATUS,           INFO,  "http_client", "HTTP status %ld, %lu bytes for image %ld") \
+    X(BL_DL_PSRAM,            INFO,  "http_client", "PSRAM after image %ld download: %lu/%lu KB used (%lu%%)") \
+    X(BL_DL_TOO_SMALL,        WARN,  "http_client", "Downloaded data seems too small for an image (%lu bytes) for image %ld") \
+    X(BL_DL_SKIP,             WARN,  "http_client", "Skipping image %ld - no URL available") \
+    X(BL_DL_START,            INFO,  "http_client", "Downloading image %ld of %ld...") \
+    X(BL_DL_OK,               INFO,  "http_client", "Successfully downloaded image %ld") \
+    X(BL_DL_FAILED,           WARN,  "http_client", "Failed to download image %ld (error 0x%lx)") \
+    X(BL_DL_BATCH_START,      INFO,  "http_client", "Downloading all %ld active images, %ld at a time...") \
+    X(BL_DL_BATCH_DONE,       INFO,  "http_client", "Download complete: %ld of %ld images downloaded successfully") \
+    /* Processing and display (main.c) */ \
+    X(BL_IMG_PROCESSING,      INFO,  APP_NAME, "Processing downloaded image %ld (%lu bytes)") \
+    X(BL_IMG_JPEG,            INFO,  APP_NAME, "Decoded JPEG image %ld: %lu -> %lu bytes in %lu us") \
+    X(BL_IMG_HEADER,          INFO,  APP_NAME, "Parsed header for image %ld: cf=0x%02lx, %lux%lu") \
+    X(BL_IMG_BAD_MAGIC,       WARN,  APP_NAME, "Unexpected magic number: 0x%02lx (expected 0x19) for image %ld") \
+    X(BL_IMG_BAD_SIZE,        WARN,  APP_NAME, "Image dimensions invalid: %lux%lu for image %ld") \
+    X(BL_IMG_UNKNOWN_CF,      WARN,  APP_NAME, "Unknown color format 0x%02lx, defaulting to RGB565 for image %ld") \
+    X(BL_IMG_SHORT,           WARN,  APP_NAME, "Downloaded buffer size (%lu) is smaller than expected for image %ld (%lu + 12 byte header)") \
+    X(BL_IMG_NORMALIZED,      INFO,  APP_NAME, "Normalized image %ld from cf %ld to RGB565 in %lu us (%lu bytes)") \
+    X(BL_IMG_ROTATED,         INFO,  APP_NAME, "Rotated image %ld (%lux%lu) in %lu us") \
+    X(BL_IMG_INDEXED,         INFO,  APP_NAME, "Image %ld stored indexed: %lu bytes instead of %lu as RGB565") \
+    X(BL_IMG_CREATED,         INFO,  APP_NAME, "Created LVGL image %ld: %lux%lu, format: %ld") \
+    X(BL_IMG_UNCOMPRESSED,    INFO,  APP_NAME, "Keeping image %ld uncompressed (error 0x%lx)") \
+    X(BL_IMG_COMPRESSED,      INFO,  APP_NAME, "Compressed image %ld: %lu -> %lu bytes in %lu us") \
+    X(BL_IMG_PROCESS_FAILED,  WARN,  APP_NAME, "Failed to process image %ld") \
+    X(BL_IMG_PROCESSED,       INFO,  APP_NAME, "Successfully processed image %ld (crc %08lx, unchanged %ld)") \
+    X(BL_DISP_NO_VALID,       WARN,  APP_NAME, "No valid images available, using error image") \
+    X(BL_DISP_NO_IMAGE,       WARN,  APP_NAME, "No image to display, using error image") \
+    X(BL_DISP_SHOW,           INFO,  APP_NAME, "Displaying image %ld") \
+    X(BL_DISP_TIMESTAMP,      DEBUG, APP_NAME, "Caption timestamp for image %ld (stored %ld)") \
+    /* Retries (http_client.c) */ \
+    X(BL_DL_RETRY,            WARN,  "http_client", "Image %ld failed transiently (HTTP %ld, error 0x%lx)") \
+    X(BL_DL_BREAKER_OPEN,     WARN,  "http_client", "Conversion API breaker open, image %ld not requested") \
+    X(BL_DL_SUBSET_START,     INFO,  "http_client", "Downloading %ld selected images, %ld at a time...") \
+    X(BL_DL_RESUMED,          INFO,  "http_client", "Resuming image %ld after %lu bytes, %ld to go (-1: unknown)") \
+    X(BL_DL_RESUME_SAVED,     INFO,  "http_client", "Image %ld interrupted at %lu bytes, kept for the retry pass")
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "app_config.h"
+#include "lvgl.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Boot timeline. Each phase is stamped once per boot (milliseconds since
+ * the application started, from esp_timer) into RTC memory that survives
+ * software, panic and watchdog resets, so after a reset the previous boot's
+ * record shows how far it got. Once the first image is on screen the
+ * timeline is logged as a table and as one "BOOT_METRICS key=ms ..." line,
+ * which tools/boot_budget/check_boot_budget.py checks against budgets.
+ */
+
+typedef enum {
+    BOOT_PHASE_NVS,             // NVS ready
+    BOOT_PHASE_LCD,             // Panel initialised
+    BOOT_PHASE_TOUCH,           // Touch controller initialised (touchscreen builds)
+    BOOT_PHASE_LVGL,            // LVGL and its task running
+    BOOT_PHASE_WIFI,            // Station connected with an IP
+    BOOT_PHASE_TIME_SYNC,       // Clock set (or given up on)
+    BOOT_PHASE_FEED,            // NHC feed fetched and parsed
+    BOOT_PHASE_FIRST_VALID,     // First image slot processed
+    BOOT_PHASE_FIRST_PIXEL,     // First frame showing image content (progressive or complete)
+    BOOT_PHASE_FIRST_SHOWN,     // First frame showing a complete image
+    BOOT_PHASE_COUNT,
+} boot_phase_t;
+
+/**
+ * @brief Start a new boot record, keeping the previous one, and log the
+ *        previous boot's reset reason and last phase reached
+ *
+ * Call first thing in app_main.
+ */
+void boot_profile_init(void);
+
+/**
+ * @brief Stamp a phase; only the first call per boot counts
+ */
+void boot_profile_mark(boot_phase_t phase);
+
+/**
+ * @brief Stamp a phase when the display finishes rendering its next frame
+ *
+ * Call with the LVGL lock held, after changing what is on screen.
+ */
+void boot_profile_mark_next_frame(boot_phase_t phase);
+
+/**
+ * @brief Render-complete hook for boot_profile_mark_next_frame()
+ *
+ * Call with the LVGL lock held.
+ */
+void boot_profile_watch_display(lv_display_t *disp);
+
+/**
+ * @brief Log this boot's timeline once, after the first image is shown
+ *
+ * Does nothing before BOOT_PHASE_FIRST_SHOWN is reached unless @p force is
+ * set, in which case unreached phases are reported as missing.
+ */
+void boot_profile_report(bool force);
+
+/**
+ * @brief Log this boot's timeline so far, without the BOOT_METRICS line
+ */
+void boot_profile_print(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Compare wire/at-rest image formats on the current NHC imagery
+ *
+ * Every active image URL is requested from the conversion API in each
+ * candidate format (raw and dithered RGB565, indexed I8/I4, LVGL RLE and LZ4
+ * compressed .bin, JPEG at several qualities); the repo's own RLE is derived
+ * from the dithered RGB565 variant. Each result is decoded to RGB565 on the
+ * device and the encoded size, decode time and PSRAM bytes touched per decode
+ * (encoded bytes read plus RGB565 bytes written) are printed as one table,
+ * tagged with the firmware version. Formats the API rejects are reported as
+ * n/a. tools/codec_bench produces the same table on the host.
+ *
+ * @return ESP_OK if at least one image was benchmarked, ESP_FAIL otherwise
+ */
+esp_err_t codec_bench_run(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "app_config.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Data freshness: how long after NHC publishes an advisory (the feed item's
+ * pubDate) it is first on screen. Each slot's publication time is recorded
+ * once, the first time the slot is shown with it, into a per-product window
+ * of recent samples. An advisory that took longer than FRESHNESS_STALE_MINUTES
+ * to reach the screen is flagged stale in the caption.
+ */
+
+typedef enum {
+    FRESHNESS_PRODUCT_OUTLOOK,      // Tropical Weather Outlook graphics
+    FRESHNESS_PRODUCT_CONE,         // Forecast cone graphics
+    FRESHNESS_PRODUCT_COUNT,
+} freshness_product_t;
+
+/**
+ * @brief Note that a slot is on screen and check whether its data was stale
+ *
+ * The delay from publication to now is recorded only the first time a slot
+ * is shown with a given publication time. Nothing is recorded while the
+ * clock is not set or the publication time is unknown (0).
+ *
+ * @param product Product the slot shows
+ * @param slot Image slot index
+ * @param published UTC publication time of the slot's advisory, 0 if unknown
+ * @param delay_s Set to the recorded publication-to-screen delay in seconds,
+ *        or -1 if none is known (may be NULL)
+ * @return true if the delay exceeded FRESHNESS_STALE_MINUTES
+ */
+bool freshness_slot_shown(freshness_product_t product, int slot, time_t published, int32_t *delay_s);
+
+/**
+ * @brief Log p50/p95/max publication-to-screen delay per product
+ *
+ * Also logged as one "FRESHNESS product=... n=... p50=... p95=... max=..."
+ * line per product, in seconds, for collection from the console.
+ */
+void freshness_report(void);
+
+#ifdef __cplusplus
+}
+#endif
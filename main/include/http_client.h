@@ -17,6 +17,11 @@ typedef struct {
 /**
  * @brief Download XML feed from NHC website
  * 
+ * The request is cancelled once it runs over BUDGET_FEED_MS or the cycle deadline.
+ * Transient failures are retried within that budget (see retry_policy.h), resuming
+ * a body cut off part way when the server supports ranges. A gzip or deflate
+ * body (ENABLE_HTTP_COMPRESSION) is inflated into result as it arrives.
+ * 
  * @param url The URL to download from
  * @param result Pointer to http_download_t structure to store result
  * @return ESP_OK on success, ESP_FAIL on failure
@@ -24,19 +29,84 @@ typedef struct {
 esp_err_t http_download_xml_feed(const char* url, http_download_t* result);
 
 /**
- * @brief Download a single image using the conversion API
- * 
- * @param image_index Index of the image in the global image array (0-9)
- * @return ESP_OK on success, ESP_FAIL on failure
+ * @brief Convert an image through the conversion API with an explicit output encoding
+ *
+ * Uses the same product crop and size as http_download_images(), but the
+ * result is returned in a standalone buffer instead of an image slot.
+ *
+ * @param url Source image URL
+ * @param encoding JSON members selecting the output, e.g. "\"cf\": \"I8\", \"output\": \"bin\""
+ * @param result Receives the response body (free with http_download_free())
+ * @return ESP_OK on success, ESP_ERR_NOT_ALLOWED if the conversion API breaker is open,
+ *         ESP_FAIL on failure
  */
-esp_err_t http_download_image(int image_index);
+esp_err_t http_convert_image(const char *url, const char *encoding, http_download_t *result);
 
 /**
- * @brief Download all configured images
- * 
+ * @brief Called on the downloading task as soon as one image has been downloaded
+ *
+ * The other transfers wait while it runs, so it should only hand the slot on.
+ *
+ * @param image_index Index of the image in the global image array
+ * @param err ESP_OK, ESP_ERR_TIMEOUT if it ran over its budget, ESP_ERR_NOT_ALLOWED if
+ *            the conversion API breaker is open, ESP_ERR_INVALID_RESPONSE for an HTTP
+ *            error that is not worth retrying (4xx), ESP_FAIL on other failures, or
+ *            ESP_ERR_NOT_FINISHED if the cycle budget ran out before it started, in
+ *            which case the slot was left untouched
+ * @param arg User argument given to http_download_images()
+ */
+typedef void (*http_image_done_cb_t)(int image_index, esp_err_t err, void *arg);
+
+/**
+ * @brief Download configured images through the conversion API, http_get_download_concurrency() at a time
+ *
+ * All transfers are driven from the calling task by the HTTP engine
+ * (http_engine.h); the call returns once every image has been attempted (or
+ * skipped because the cycle budget ran out) and every callback has returned.
+ * Images are started in order as transfers finish, and an image due to retry
+ * goes ahead of those not started yet, so with a partial failure or a cycle cut
+ * short by its budget the first ones are the most likely to arrive.
+ *
+ * Each request is cancelled once it runs over BUDGET_IMAGE_MS or the cycle
+ * deadline. Transient failures are retried within that budget (see
+ * retry_policy.h). A body cut off part way is resumed with a Range request when
+ * the response had "Accept-Ranges: bytes" and a strong ETag; if the budget runs
+ * out first, the bytes received stay in the slot and the next download of it
+ * resumes from there. A compressed body is inflated into the slot as it arrives
+ * and is never resumed; the slot is then sized for IMAGE_MAX_BYTES.
+ *
+ * @param order Image indexes, most important first; indexes past the active images are ignored
+ * @param count Number of entries in order
+ * @param on_done Optional callback for each finished image, so it can be
+ *                processed while the remaining downloads continue
+ * @param arg User argument passed to on_done
  * @return ESP_OK if at least one image downloaded successfully, ESP_FAIL otherwise
  */
-esp_err_t http_download_all_images(void);
+esp_err_t http_download_images(const int *order, int count, http_image_done_cb_t on_done, void *arg);
+
+/**
+ * @brief Change how many images are downloaded at once
+ *
+ * Takes effect from the next http_download_images() call.
+ *
+ * @param concurrency 1 to DOWNLOAD_CONCURRENCY_MAX
+ * @return ESP_OK, or ESP_ERR_INVALID_ARG if out of range
+ */
+esp_err_t http_set_download_concurrency(int concurrency);
+
+/**
+ * @brief Number of images downloaded at once (DOWNLOAD_CONCURRENCY at boot)
+ */
+int http_get_download_concurrency(void);
+
+/**
+ * @brief Copy the NHC feed last parsed by http_update_image_urls_from_xml()
+ *
+ * @param copy Receives a NUL-terminated copy (free with http_download_free())
+ * @return ESP_OK, ESP_ERR_NOT_FOUND if no feed has been fetched yet,
+ *         ESP_ERR_NO_MEM if the copy could not be allocated
+ */
+esp_err_t http_copy_cached_feed(http_download_t *copy);
 
 /**
  * @brief Update image URLs by downloading and parsing NHC XML feed
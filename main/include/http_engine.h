@@ -0,0 +1,99 @@
+#pragma once
+
+#include "esp_err.h"
+#include "esp_http_client.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Single-task HTTP engine. Each https:// transfer is an esp_http_client in
+ * async mode (is_async): esp_http_client_perform() returns
+ * ESP_ERR_HTTP_EAGAIN instead of blocking while it connects, shakes hands or
+ * waits for the server, and the engine moves on to the next transfer.
+ * Several feed and image transfers thus run from the calling task without a
+ * task stack each. A plain http:// transfer cannot connect asynchronously,
+ * so its perform() blocks until the attempt ends (job.blocking).
+ *
+ * A job is one logical request. Its ops set up each attempt (creating the
+ * client, whose event handler and user data are the job's sink), judge how
+ * the attempt ended and report the result. A job waiting to retry holds no
+ * connection, so the next job can use its place in the meantime.
+ *
+ * Waiting is done on the sockets: before each perform() the engine sets the
+ * client's timeout to that transfer's share of HTTP_ENGINE_POLL_MS (less if a
+ * retry, deadline or idle timeout falls due sooner), and a read that runs out
+ * of it counts as ESP_ERR_HTTP_EAGAIN. The job's deadline and idle timeout
+ * are enforced by the engine between polls.
+ */
+
+typedef struct http_job http_job_t;
+
+typedef struct {
+    /**
+     * Set up the next attempt: create job->client, configured with is_async
+     * for https://, and set job->blocking if it is not (http_transfer_client()
+     * does both). Return an error to end the job with that result; the
+     * client must then not be left set.
+     */
+    esp_err_t (*attempt_start)(http_job_t *job);
+    /**
+     * The attempt ended with err (ESP_ERR_TIMEOUT if the engine stopped it).
+     * Clean up job->client. Return true to retry at job->retry_at_us, or
+     * false once job->err holds the result.
+     */
+    bool (*attempt_end)(http_job_t *job, esp_err_t err);
+    /**
+     * The job is over; job->err holds its result. May be NULL.
+     */
+    void (*done)(http_job_t *job);
+} http_job_ops_t;
+
+struct http_job {
+    const http_job_ops_t *ops;
+    int priority;               // Lower starts first, and restarts first after a retry wait
+    int64_t deadline_us;        // esp_timer time an attempt is stopped at, 0 for none
+    uint32_t idle_timeout_ms;   // Attempt stopped after this long without a byte, 0 for none
+    uint32_t bytes;             // Bytes received; the sink adds to it so the engine sees progress
+    bool blocking;              // Set by attempt_start: the client is not is_async, so perform()
+                                // runs the whole attempt and the engine waits for it
+
+    // Owned by the engine and the ops
+    esp_http_client_handle_t client;
+    int attempt;                // Attempts already ended
+    int64_t retry_at_us;
+    esp_err_t err;
+    int state;
+    int64_t progress_us;
+    uint32_t progress_bytes;
+};
+
+/**
+ * @brief Run jobs to completion from the calling task
+ *
+ * Jobs start in priority order, at most max_active at a time. Returns once
+ * every job's done op has returned.
+ *
+ * @param jobs Jobs to run; each must have ops set
+ * @param count Number of jobs
+ * @param max_active Transfers open at once, at least 1
+ * @return ESP_OK, or ESP_ERR_INVALID_ARG
+ */
+esp_err_t http_engine_run(http_job_t *const *jobs, int count, int max_active);
+
+/**
+ * @brief Job whose client the calling task is polling
+ *
+ * For callbacks of the client's lower layers (such as its TLS setup) that get
+ * no user data.
+ *
+ * @return The job, or NULL outside esp_http_client_perform() in the engine
+ */
+http_job_t *http_engine_current_job(void);
+
+#ifdef __cplusplus
+}
+#endif
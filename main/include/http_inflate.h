@@ -0,0 +1,120 @@
+#pragma once
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Streaming decoder for gzip and deflate response bodies. Each received chunk
+ * is inflated by the ROM tinfl straight into the response's own buffer, which
+ * doubles as the LZ77 window: no 32 KB window and no copy of the compressed
+ * body is kept. The gzip trailer (CRC32 and length) is checked as it arrives.
+ *
+ * A body going somewhere other than one contiguous buffer (a file, a
+ * streaming parser) is decoded with http_inflate_stream() instead, through a
+ * 32 KB wrapping window allocated on first use.
+ *
+ * Compressed and decoded bytes and inflate time are counted per update cycle.
+ */
+
+typedef enum {
+    HTTP_ENCODING_IDENTITY,
+    HTTP_ENCODING_GZIP,
+    HTTP_ENCODING_DEFLATE,          // zlib stream, or raw deflate from servers that send that
+    HTTP_ENCODING_UNSUPPORTED,
+} http_encoding_t;
+
+typedef struct http_inflate http_inflate_t;
+
+/**
+ * @brief Map a Content-Encoding header value to an encoding
+ *
+ * @param value Header value, NULL if the header is absent
+ * @return HTTP_ENCODING_IDENTITY for NULL, "" and "identity"
+ */
+http_encoding_t http_inflate_encoding(const char *value);
+
+/**
+ * @brief Start decoding one response body
+ *
+ * The decompressor state (about 11 KB) goes in internal RAM if it fits.
+ *
+ * @param encoding HTTP_ENCODING_GZIP or HTTP_ENCODING_DEFLATE
+ * @return The decoder, or NULL if out of memory or the encoding is not compressed
+ */
+http_inflate_t *http_inflate_create(http_encoding_t encoding);
+
+/**
+ * @brief Decode one chunk of the body
+ *
+ * The output buffer holds the whole decoded body so far and is the window
+ * later matches copy from. It may be moved or grown between calls (realloc)
+ * as long as its contents are kept.
+ *
+ * @param inflate Decoder
+ * @param in Next compressed bytes; advanced past the bytes consumed
+ * @param in_len Bytes at *in; reduced by the bytes consumed
+ * @param out Start of the decoded body
+ * @param out_len Bytes already decoded into out; increased by the new ones
+ * @param out_size Capacity of out
+ * @return
+ *      - ESP_OK: all input consumed (bytes after the end of the stream are ignored)
+ *      - ESP_ERR_INVALID_SIZE: out is full with input left; grow it and call again
+ *      - ESP_ERR_INVALID_RESPONSE: corrupt stream, or CRC or length mismatch
+ */
+esp_err_t http_inflate_feed(http_inflate_t *inflate, const uint8_t **in, size_t *in_len,
+                            uint8_t *out, size_t *out_len, size_t out_size);
+
+/**
+ * @brief Receives decoded bytes from http_inflate_stream()
+ *
+ * @return ESP_OK to go on; any other value stops decoding and is returned
+ */
+typedef esp_err_t (*http_inflate_write_t)(void *arg, const uint8_t *data, size_t len);
+
+/**
+ * @brief Decode one chunk of the body through the decoder's own window
+ *
+ * For output that is not kept in one buffer. A decoder must be used with
+ * either this or http_inflate_feed(), not both.
+ *
+ * @param inflate Decoder
+ * @param in Next compressed bytes
+ * @param in_len Bytes at in
+ * @param write Called with each run of decoded bytes, in order
+ * @param arg Passed to write
+ * @return ESP_OK once all input is consumed, ESP_ERR_NO_MEM if the window
+ *         cannot be allocated, ESP_ERR_INVALID_RESPONSE for a corrupt stream,
+ *         or the error write returned
+ */
+esp_err_t http_inflate_stream(http_inflate_t *inflate, const uint8_t *in, size_t in_len,
+                              http_inflate_write_t write, void *arg);
+
+/**
+ * @brief Whether the whole stream, trailer included, has been decoded and checked
+ *
+ * A body that ends before this is truncated.
+ */
+bool http_inflate_done(const http_inflate_t *inflate);
+
+/**
+ * @brief Free a decoder; NULL is ignored
+ */
+void http_inflate_destroy(http_inflate_t *inflate);
+
+/**
+ * @brief Log and reset the compression counters of the cycle
+ *
+ * One "INFLATE responses=... in=... out=... saved=... ms=... kBps=..." line;
+ * nothing if no compressed response arrived.
+ */
+void http_inflate_cycle_report(void);
+
+#ifdef __cplusplus
+}
+#endif
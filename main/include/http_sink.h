@@ -0,0 +1,182 @@
+#pragma once
+
+#include "esp_err.h"
+#include "http_client.h"
+#include "xml_parse.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Where a response body goes. A transfer (http_transfer.h) owns everything
+ * HTTP about a download: headers, ranges, encodings, retries. It hands the
+ * sink only the decoded body: begin() once the response headers are in, then
+ * write() for each chunk, then end().
+ *
+ * Sinks that hold the body in one buffer also have body() and commit(), so a
+ * compressed body is inflated straight into that buffer, which doubles as
+ * the LZ77 window. Other sinks get it through the decoder's own 32 KB window.
+ *
+ * A sink is embedded at the start of its typed struct (http_mem_sink_t, ...)
+ * and set up by that type's init function; it is not freed by the transfer.
+ */
+
+typedef struct http_sink http_sink_t;
+
+typedef struct {
+    /**
+     * The response headers are in. kept is the number of bytes of an earlier
+     * attempt the body continues (0 if it starts over); length the number of
+     * bytes this response adds, -1 if unknown (chunked or compressed). A
+     * failure with kept > 0 means the kept bytes cannot be continued.
+     */
+    esp_err_t (*begin)(http_sink_t *sink, size_t kept, int64_t length);
+    /** The next len bytes of the body */
+    esp_err_t (*write)(http_sink_t *sink, const uint8_t *data, size_t len);
+    /**
+     * Optional: the body so far, with room for at least want bytes in all;
+     * NULL if it cannot hold that many. *size receives the room there is.
+     */
+    uint8_t *(*body)(http_sink_t *sink, size_t want, size_t *size);
+    /** With body(): bytes up to len have been written into it */
+    esp_err_t (*commit)(http_sink_t *sink, size_t len);
+    /** The attempt is over; complete is false if the body was cut short or failed */
+    esp_err_t (*end)(http_sink_t *sink, bool complete);
+} http_sink_ops_t;
+
+struct http_sink {
+    const http_sink_ops_t *ops;
+    size_t length;              // Body bytes held, kept ones included
+    bool resumable;             // Can take the rest of a body after an interrupted attempt
+};
+
+/**
+ * @brief Growable buffer in RAM, kept null terminated
+ */
+typedef struct {
+    http_sink_t base;
+    http_download_t *download;
+} http_mem_sink_t;
+
+/**
+ * @brief Body into download, which the sink grows as needed
+ *
+ * The buffer is preallocated from Content-Length and freed when a response
+ * starts over. The caller frees it with http_download_free().
+ */
+void http_mem_sink_init(http_mem_sink_t *sink, http_download_t *download);
+
+/**
+ * @brief An image slot (see get_image_buffer_info() in main.c)
+ */
+typedef struct {
+    http_sink_t base;
+    int image_index;
+} http_slot_sink_t;
+
+/**
+ * @brief Body into an image slot, with progressive display if enabled
+ *
+ * The slot keeps its last image, which may be on screen, until a 2xx body
+ * begins; a body that starts over then replaces it. The slot is sized once
+ * from Content-Length, or for IMAGE_MAX_BYTES if the length is unknown, and
+ * never moves while it fills since rows may already be on screen. A body that
+ * would overflow it fails.
+ *
+ * @param kept Bytes in the slot that an earlier attempt left for this body to
+ *        continue (the transfer's resume offset), 0 if none
+ */
+void http_slot_sink_init(http_slot_sink_t *sink, int image_index, size_t kept);
+
+/**
+ * @brief A file, written as the body arrives
+ */
+typedef struct {
+    http_sink_t base;
+    const char *path;
+    FILE *file;
+} http_file_sink_t;
+
+/**
+ * @brief Body into the file at path, truncated unless a resumed body continues it
+ */
+void http_file_sink_init(http_file_sink_t *sink, const char *path);
+
+/**
+ * @brief NHC feed parsed as it arrives, without keeping it
+ */
+typedef struct {
+    http_sink_t base;
+    xml_stream_t *stream;
+    // Set by a complete body; free urls with xml_parse_free_urls() and pub_dates with free()
+    char **urls;
+    int url_count;
+    time_t *pub_dates;
+    time_t outlook_pub_date;
+} http_xml_sink_t;
+
+/**
+ * @brief Feed into xml_stream_feed(); the cone URLs are set once the body is complete
+ */
+void http_xml_sink_init(http_xml_sink_t *sink);
+
+#define HTTP_JSON_VALUE_MAX_LEN 48
+
+/**
+ * @brief One top-level member captured by a JSON sink
+ */
+typedef struct {
+    const char *key;
+    char value[HTTP_JSON_VALUE_MAX_LEN];    // Scalar as text, strings unquoted; truncated to fit
+    bool found;
+} http_json_field_t;
+
+/**
+ * @brief JSON object scanned as it arrives for a few top-level scalars
+ */
+typedef struct {
+    http_sink_t base;
+    http_json_field_t *fields;
+    int field_count;
+    // Scanner state
+    int depth;
+    int expect;
+    int field;
+    bool in_string;
+    bool escape;
+    bool in_scalar;
+    bool valid;
+    char token[HTTP_JSON_VALUE_MAX_LEN];
+    size_t token_len;
+} http_json_sink_t;
+
+/**
+ * @brief Capture the named members of a JSON object without building a tree
+ *
+ * Only members of the top-level object are matched; nested objects and arrays
+ * are skipped. end() fails for a body that is not one complete object.
+ *
+ * @param fields Members to capture, each with key set; filled in as they arrive
+ * @param count Number of fields
+ */
+void http_json_sink_init(http_json_sink_t *sink, http_json_field_t *fields, int count);
+
+/**
+ * @brief CRC32 and length of the body, which is not kept
+ */
+typedef struct {
+    http_sink_t base;
+    uint32_t crc;
+} http_hash_sink_t;
+
+void http_hash_sink_init(http_hash_sink_t *sink);
+
+#ifdef __cplusplus
+}
+#endif
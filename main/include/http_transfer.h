@@ -0,0 +1,180 @@
+#pragma once
+
+#include "esp_err.h"
+#include "esp_http_client.h"
+#include "app_config.h"
+#include "http_engine.h"
+#include "http_inflate.h"
+#include "http_sink.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * One download, run as an http_engine job, into a sink (http_sink.h). The
+ * transfer handles everything about the response that is not its body:
+ * Retry-After, ranges and If-Range for resuming, Content-Encoding and the
+ * inflating of compressed bodies, the budget deadline. The body of a 2xx
+ * response goes to the sink; the body of an error response is dropped.
+ *
+ * The caller's job ops decide what an attempt sends and whether to retry:
+ * attempt_start creates the client with http_transfer_client(), attempt_end
+ * calls http_transfer_attempt_end() first.
+ *
+ * With ENABLE_HTTP_KEEPALIVE, the clients of transfers with a host set are
+ * pooled per host: an attempt that ended cleanly leaves its client, and the
+ * open connection, for the next attempt to that host. Every request to a host
+ * must thus use the same client config apart from url and method.
+ */
+
+// Resume point of an interrupted transfer. The next attempt asks for the rest
+// with "Range: bytes=<offset>-" and "If-Range: <etag>": a 206 continues the
+// bytes the sink holds, a 200 (the entity changed, or the range was ignored)
+// replaces them.
+typedef struct {
+    size_t offset;              // Bytes kept from earlier attempts, 0 to start over
+    bool accept_ranges;         // Last response advertised "Accept-Ranges: bytes"
+    char etag[HTTP_ETAG_MAX_LEN];   // Its strong ETag, "" if none
+    size_t range_start;         // First byte of its Content-Range
+    bool broken;                // The kept bytes cannot be continued
+} http_resume_t;
+
+typedef struct {
+    http_job_t job;             // First, so an engine job is its transfer
+    http_sink_t *sink;
+    int log_index;              // Image index for the per-event binlog, -1 for none
+    int host;                   // retry_host_t the attempts are timed for (net_timing.h), -1 for none
+    bool expired;               // Cancelled for running past job.deadline_us
+    uint32_t retry_after_ms;    // Retry-After of the last response, 0 if none
+    int status_code;            // Of the last attempt
+    http_resume_t resume;
+
+    // State of the attempt in flight
+    http_encoding_t encoding;
+    http_inflate_t *inflate;    // Decoder of a compressed body, created on its first bytes
+    bool begun;                 // The sink has seen begin()
+    esp_err_t sink_err;         // First error from the sink or the decoder
+
+    // Phase times of the attempt in flight (esp_timer us, 0 until reached)
+    int64_t started_us;
+    int64_t resolved_us;        // Host name lookup done, 0 if it failed
+    int64_t tcp_us;             // TCP connected, TLS about to start (https only)
+    int64_t connected_us;       // HTTP_EVENT_ON_CONNECTED
+    int64_t sent_us;            // Request headers sent
+    int64_t response_us;        // First response header
+    uint32_t started_bytes;     // job.bytes at the start of the attempt
+    esp_err_t (*crt_attach)(void *conf);    // The config's own, called once TCP connects
+    bool connected;             // The client's connection is open
+    bool reused;                // The attempt went out on a pooled client's open connection
+    bool fresh;                 // The next attempt opens a new connection, not a pooled one
+    uint32_t keepalive_ms;      // Keep-Alive timeout the server sent, 0 if none
+} http_transfer_t;
+
+/**
+ * @brief Set up a transfer into sink, before its first attempt
+ *
+ * The caller then sets job.priority, job.deadline_us, job.idle_timeout_ms,
+ * log_index and host as needed.
+ */
+void http_transfer_init(http_transfer_t *transfer, const http_job_ops_t *ops, http_sink_t *sink);
+
+/**
+ * @brief Create the client of the next attempt
+ *
+ * config is completed with the transfer's event handler and is_async for an
+ * https:// URL. Any other URL gets a blocking client (job.blocking) whose
+ * timeout is the job's idle timeout (HTTP_TIMEOUT_MS if it has none), or less
+ * if its deadline is nearer. Range headers are added
+ * for a resumed attempt, and Accept-Encoding (ENABLE_HTTP_COMPRESSION) for
+ * one that starts over. The client is also stored in transfer->job.client.
+ *
+ * With host set, an idle client of that host is reused if there is one;
+ * the caller's method, post field, headers and timeout replace those of its
+ * last request. Unless its connection is still open, the host name is looked
+ * up first, so that the lookup is timed apart from the connect (the client's
+ * own then hits the DNS cache). The phases of the attempt are recorded when
+ * it ends.
+ *
+ * @param transfer Transfer
+ * @param config URL, TLS and buffer settings of the request
+ * @return The client, or NULL if it could not be created
+ */
+esp_http_client_handle_t http_transfer_client(http_transfer_t *transfer, const esp_http_client_config_t *config);
+
+/**
+ * @brief Close the attempt in flight
+ *
+ * Records the status code, checks the body arrived whole (and, compressed,
+ * decoded through its trailer), ends the sink, and returns the client to its
+ * host's pool if the attempt ended cleanly, else cleans it up.
+ *
+ * @param transfer Transfer
+ * @param err How esp_http_client_perform() ended, as passed to attempt_end
+ * @return err, or the first failure found in the body
+ */
+esp_err_t http_transfer_attempt_end(http_transfer_t *transfer, esp_err_t err);
+
+/**
+ * @brief Retry at once if a pooled connection failed before any response
+ *
+ * A kept-alive connection the server closed in the meantime fails before the
+ * first byte of the response. That says nothing about the host, so attempt_end
+ * should call this first, after http_transfer_attempt_end(): the next attempt
+ * then starts now, on a new connection, without reporting a result to the
+ * host's breaker or backing off. It still counts as one of the job's attempts.
+ *
+ * @param transfer Transfer
+ * @param err As returned by http_transfer_attempt_end()
+ * @return true, with job.retry_at_us set, if attempt_end should return true
+ */
+bool http_transfer_retry_fresh(http_transfer_t *transfer, esp_err_t err);
+
+/**
+ * @brief Whether the last response was a whole body (200) or the range asked for (206)
+ */
+bool http_transfer_body_ok(const http_transfer_t *transfer);
+
+/**
+ * @brief Whether the last response was anything but a 206 for the wrong range
+ */
+bool http_transfer_range_valid(const http_transfer_t *transfer);
+
+/**
+ * @brief After a failed attempt, pick where the next one starts
+ *
+ * Resumes from the bytes the sink holds if the server allows it and the
+ * sink can continue them, else starts over.
+ *
+ * @return The new resume offset, 0 to start over
+ */
+size_t http_transfer_resume_point(http_transfer_t *transfer);
+
+/**
+ * @brief Close the idle connections kept for reuse
+ *
+ * Called at the end of an update cycle, as the next one comes after the
+ * servers' keep-alive timeouts. With CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+ * the clients stay pooled with their TLS sessions, which the next connection
+ * resumes; otherwise they are cleaned up.
+ */
+void http_transfer_close_idle(void);
+
+/**
+ * @brief GET url into sink, one attempt, from the calling task
+ *
+ * No breaker, budget or retry; for tools such as the sink benchmark.
+ *
+ * @param url URL to fetch (https uses the certificate bundle)
+ * @param sink Where the body goes
+ * @param status_code Receives the HTTP status, 0 if no response; may be NULL
+ * @return ESP_OK if a 200 body arrived whole and the sink took it, else the failure
+ */
+esp_err_t http_transfer_get(const char *url, http_sink_t *sink, int *status_code);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,171 @@
+#pragma once
+
+#include "esp_err.h"
+#include "lvgl.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Row range callback for image_codec_parallel_rows()
+ *
+ * @param ctx User context passed through unchanged
+ * @param row_start First row to process
+ * @param row_end One past the last row to process
+ */
+typedef void (*image_codec_rows_fn_t)(void *ctx, int row_start, int row_end);
+
+/**
+ * @brief Start the pixel worker tasks (one pinned to each core)
+ *
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the tasks could not be created
+ */
+esp_err_t image_codec_init(void);
+
+/**
+ * @brief Split a row range across both cores and wait for completion
+ *
+ * Falls back to running on the calling task if image_codec_init() has not
+ * been called. Calls are serialized.
+ *
+ * @param fn Row callback
+ * @param ctx User context
+ * @param rows Total number of rows
+ */
+void image_codec_parallel_rows(image_codec_rows_fn_t fn, void *ctx, int rows);
+
+/**
+ * @brief Check whether a colour format is palette-indexed (I1/I2/I4/I8)
+ */
+bool image_codec_is_indexed(lv_color_format_t cf);
+
+/**
+ * @brief Number of palette entries stored ahead of the pixels for an indexed format
+ *
+ * @return 2/4/16/256 for I1/I2/I4/I8, 0 otherwise
+ */
+size_t image_codec_palette_entries(lv_color_format_t cf);
+
+/**
+ * @brief Bits per pixel of an indexed format (0 for other formats)
+ */
+uint32_t image_codec_indexed_bpp(lv_color_format_t cf);
+
+/**
+ * @brief Row stride in bytes of the index data for an indexed format
+ */
+size_t image_codec_indexed_stride(lv_color_format_t cf, uint32_t width);
+
+/**
+ * @brief Convert an LVGL palette (lv_color32_t, BGRA) to an RGB565 lookup table
+ *
+ * Translucent entries are blended against black, the screen background.
+ *
+ * @param palette Palette as stored in the .bin
+ * @param entries Number of palette entries
+ * @param lut Output table with @p entries RGB565 values
+ */
+void image_codec_build_palette_lut(const uint8_t *palette, size_t entries, uint16_t *lut);
+
+/**
+ * @brief Expand an indexed image to RGB565 on both cores
+ *
+ * @param src Indexed image; data points at the palette followed by the indices
+ * @param lut RGB565 table from image_codec_build_palette_lut()
+ * @param dst Output buffer of width * height RGB565 pixels
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED for non-indexed formats
+ */
+esp_err_t image_codec_expand_indexed(const lv_image_dsc_t *src, const uint16_t *lut, uint16_t *dst);
+
+/**
+ * @brief Expand part of one row of indices to RGB565
+ *
+ * @param src Start of the row's index data
+ * @param bpp Bits per index (1, 2, 4 or 8)
+ * @param x0 First pixel to expand
+ * @param count Number of pixels
+ * @param lut RGB565 table from image_codec_build_palette_lut()
+ * @param dst Output, @p count pixels
+ */
+void image_codec_expand_indexed_span(const uint8_t *src, uint32_t bpp, uint32_t x0, uint32_t count,
+                                     const uint16_t *lut, uint16_t *dst);
+
+/**
+ * @brief Allocate an RGB565 slot buffer in PSRAM with its LVGL header filled in
+ *
+ * The layout matches an RGB565 .bin from the conversion API: an
+ * IMAGE_HEADER_SIZE-byte header followed by width * height pixels.
+ *
+ * @param size Receives the total buffer size (may be NULL)
+ * @return Buffer (caller frees), or NULL if out of memory
+ */
+uint8_t *image_codec_alloc_rgb565(uint32_t width, uint32_t height, size_t *size);
+
+/**
+ * @brief Check whether a colour format is converted by image_codec_normalize()
+ *
+ * True for RGB888, XRGB8888, ARGB8888, RGB565A8, ARGB8565 and L8. RGB565 is
+ * already native, and indexed images stay indexed until shown.
+ */
+bool image_codec_needs_normalize(lv_color_format_t cf);
+
+/**
+ * @brief Convert a non-native image to opaque RGB565 on both cores
+ *
+ * Alpha is blended against black, the screen background (skipped for
+ * premultiplied images), so the result can be drawn with a plain copy.
+ *
+ * @param src Source image; header.stride may be 0 for tightly packed rows
+ * @param dst Output buffer of width * height RGB565 pixels, not overlapping @p src
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED for other formats
+ */
+esp_err_t image_codec_normalize(const lv_image_dsc_t *src, uint16_t *dst);
+
+/**
+ * @brief Rotate pixels a quarter turn into a new buffer on both cores
+ *
+ * Works in 16x16 output tiles so the source rows feeding a tile stay in cache
+ * while their columns are gathered. With even sizes, 2-byte pixels move as
+ * 2x2 blocks of word-aligned 32-bit loads and stores.
+ *
+ * @param src First source row
+ * @param width Source width
+ * @param height Source height
+ * @param src_stride Source row stride in bytes
+ * @param px_size Bytes per pixel: 2 for RGB565, 1 for I8 indices
+ * @param clockwise Rotate 90 degrees clockwise, otherwise counter-clockwise
+ * @param dst Output of width rows by height pixels, tightly packed, not overlapping @p src
+ */
+void image_codec_rotate(const uint8_t *src, uint32_t width, uint32_t height, size_t src_stride,
+                        uint32_t px_size, bool clockwise, uint8_t *dst);
+
+/**
+ * @brief Check whether a downloaded buffer is a JPEG (SOI marker)
+ */
+bool image_codec_is_jpeg(const uint8_t *data, size_t len);
+
+/**
+ * @brief Decode a JPEG with the ROM TJpgDec decoder into an RGB565 slot buffer
+ *
+ * The output buffer is allocated in PSRAM with the same layout as an RGB565
+ * .bin from the conversion API (IMAGE_HEADER_SIZE-byte LVGL header followed
+ * by the pixels), so it can replace the downloaded buffer directly. MCU strips
+ * are converted straight into it; there is no full RGB888 intermediate.
+ *
+ * @param jpeg JPEG data
+ * @param len Length of the JPEG data
+ * @param out Receives the allocated RGB565 buffer (caller frees)
+ * @param out_size Receives the size of the RGB565 buffer
+ * @param decode_us Receives the decode time in microseconds (may be NULL)
+ * @return ESP_OK on success, ESP_ERR_NO_MEM or ESP_FAIL otherwise
+ */
+esp_err_t image_codec_decode_jpeg(const uint8_t *jpeg, size_t len, uint8_t **out, size_t *out_size,
+                                  uint32_t *decode_us);
+
+#ifdef __cplusplus
+}
+#endif
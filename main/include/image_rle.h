@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Run-length coding compatible with LVGL's compressed image format (lv_rle.c).
+ *
+ * The stream is a sequence of runs over fixed-size blocks (blk bytes, e.g. 2 for RGB565):
+ *   - control byte with bit 7 set: (ctrl & 0x7f) literal blocks follow
+ *   - control byte with bit 7 clear: the next block is repeated ctrl times
+ *
+ * This file has no ESP-IDF dependencies so it can be reused by host tools.
+ */
+
+#define RLE_MAX_RUN 127
+
+/**
+ * @brief Worst-case encoded size for an input of @p len bytes
+ */
+#define RLE_MAX_ENCODED_SIZE(len, blk) ((len) + ((len) / ((blk) * RLE_MAX_RUN)) + 1)
+
+/**
+ * @brief Encode a buffer
+ *
+ * @param in Input data, length must be a multiple of @p blk
+ * @param len Input length in bytes
+ * @param out Output buffer
+ * @param out_cap Capacity of the output buffer
+ * @param blk Block size in bytes (1-4)
+ * @return Encoded length, or 0 if the output buffer is too small
+ */
+size_t rle_encode(const uint8_t *in, size_t len, uint8_t *out, size_t out_cap, uint8_t blk);
+
+/**
+ * @brief Decode a buffer
+ *
+ * @param in Encoded data
+ * @param in_len Encoded length in bytes
+ * @param out Output buffer
+ * @param out_cap Capacity of the output buffer
+ * @param blk Block size in bytes used when encoding
+ * @return Decoded length, or 0 on malformed input or overflow
+ */
+size_t rle_decode(const uint8_t *in, size_t in_len, uint8_t *out, size_t out_cap, uint8_t blk);
+
+/**
+ * @brief Decode a buffer and XOR it into @p dst instead of overwriting it
+ *
+ * Repeated runs of all-zero blocks are skipped without touching @p dst, which
+ * makes applying a sparse XOR delta proportional to the number of changed pixels.
+ *
+ * @return Number of bytes covered, or 0 on malformed input or overflow
+ */
+size_t rle_decode_xor(const uint8_t *in, size_t in_len, uint8_t *dst, size_t dst_len, uint8_t blk);
+
+#ifdef __cplusplus
+}
+#endif
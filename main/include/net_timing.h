@@ -0,0 +1,52 @@
+#pragma once
+
+#include "app_config.h"
+#include "retry_policy.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Where the time of each request goes, per host: DNS lookup, TCP connect, TLS
+ * handshake, time to first byte (from the request sent to the first response
+ * header, i.e. the server's own time) and transfer of the response. Every
+ * attempt made through http_transfer.h is recorded into a per-host window of
+ * the last NET_TIMING_SAMPLES attempts, with the bytes it received.
+ */
+
+typedef enum {
+    NET_PHASE_DNS,              // Host name lookup
+    NET_PHASE_CONNECT,          // TCP connect
+    NET_PHASE_TLS,              // TLS handshake (https only)
+    NET_PHASE_TTFB,             // Request sent to first response header
+    NET_PHASE_TRANSFER,         // First response header to end of body
+    NET_PHASE_COUNT,
+} net_phase_t;
+
+typedef struct {
+    int32_t phase_us[NET_PHASE_COUNT];  // -1 for a phase the attempt did not reach
+    uint32_t bytes;                     // Response bytes received
+} net_timing_sample_t;
+
+/**
+ * @brief Record the phases of one attempt to host
+ */
+void net_timing_record(retry_host_t host, const net_timing_sample_t *sample);
+
+/**
+ * @brief Log p50/p90/max and a histogram of each phase per host
+ *
+ * Also logged as one "NET host=... phase=... n=... p50=... p90=... max=...
+ * hist=..." line per host and phase, in ms, where hist counts the samples
+ * below 1, 2, 4 ... ms and the last bucket the rest; and one "NET host=...
+ * n=... connects=... handshakes=... bytes=... kBps=..." line per host with
+ * the attempts that opened a connection or ran a TLS handshake (the others
+ * reused a kept connection) and the transfer throughput.
+ */
+void net_timing_report(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "esp_err.h"
+#include "http_client.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Time the feed parse and full-screen render hot paths
+ *
+ * Downloads the NHC feed once, parses it PERF_BENCH_ITERATIONS times and
+ * forces as many full-screen renders of the current screen, then prints the
+ * wall-clock averages together with the hot-path probe table (cycles and
+ * I/D stall cycles per call). The header line records whether the hot-path
+ * placement policy (CONFIG_HOT_PATH_IRAM) is built in, so a before/after
+ * comparison is two runs of the same firmware with the option toggled.
+ *
+ * @param disp LVGL display to render (may be NULL to skip the render pass)
+ * @return ESP_OK on success, or the feed download error
+ */
+esp_err_t perf_bench_run(lv_display_t *disp);
+
+/**
+ * @brief Time the feed parse over an already downloaded feed
+ *
+ * Parses @p feed @p iterations times and logs the average together with the
+ * probe table (empty unless CONFIG_PERF_PROBES is set).
+ *
+ * @param feed NHC feed, e.g. from http_copy_cached_feed()
+ * @param iterations Number of parses
+ * @return Average microseconds per parse
+ */
+uint32_t perf_bench_parse(const http_download_t *feed, int iterations);
+
+/**
+ * @brief Time one download of the feed through each kind of response sink
+ *
+ * Fetches NHC_XML_FEED_URL @p runs times into each of the memory, file (if
+ * storage is mounted), streaming XML and hash-only sinks of http_sink.h and
+ * logs one "SINK name=... bytes=... ms=... kBps=..." line per sink with the
+ * average. All go through the same transfer code, so the lines compare what
+ * each sink costs on top of the network, inflating included when the server
+ * compresses (ENABLE_HTTP_COMPRESSION).
+ *
+ * @param runs Downloads per sink
+ * @return ESP_OK, or the first download error
+ */
+esp_err_t perf_bench_sinks(int runs);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "app_config.h"
+#include "esp_err.h"
+#include "lvgl.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Cycle-counter probes around the hot paths that run while the panel scans
+ * out of PSRAM. Each probe accumulates calls, CPU cycles and, on Xtensa,
+ * instruction and data stall cycles from the core's performance counters;
+ * on the S3 those stalls are dominated by external cache misses, since
+ * flash-resident code and PSRAM data wait on the same bus as the LCD DMA.
+ *
+ * With CONFIG_PERF_PROBES off the PERF_PROBE_* macros compile to nothing.
+ */
+
+typedef enum {
+    PERF_PROBE_HTTP_DATA,       // Image HTTP_EVENT_ON_DATA handling
+    PERF_PROBE_XML_PARSE,       // One full feed parse
+    PERF_PROBE_XML_CHAR_DATA,   // Expat character data callback
+    PERF_PROBE_IMAGE_PROCESS,   // Validate, decode, record and compress one slot
+    PERF_PROBE_SLOT_DECODE,     // Slot decoder band (get_area_cb)
+    PERF_PROBE_LVGL_RENDER,     // LVGL render of one refresh, start to ready
+    PERF_PROBE_COUNT,
+} perf_probe_id_t;
+
+typedef struct {
+    uint32_t cycles;
+    uint32_t i_stall;
+    uint32_t d_stall;
+    int core;
+} perf_probe_mark_t;
+
+/**
+ * @brief Start the stall counters on both cores
+ *
+ * @return ESP_OK on success (also when stall counters are unavailable)
+ */
+esp_err_t perf_probe_init(void);
+
+/**
+ * @brief Time LVGL renders of a display under PERF_PROBE_LVGL_RENDER
+ *
+ * Call with the LVGL lock held.
+ */
+void perf_probe_watch_display(lv_display_t *disp);
+
+void perf_probe_begin(perf_probe_mark_t *mark);
+
+/**
+ * @brief Add the cycles since @p mark to a probe
+ *
+ * Samples where the task moved to the other core in between are counted as
+ * migrated and otherwise dropped.
+ */
+void perf_probe_end(perf_probe_id_t id, const perf_probe_mark_t *mark);
+
+/**
+ * @brief Clear all probe totals
+ */
+void perf_probe_reset(void);
+
+/**
+ * @brief Log one line per probe: calls, average and maximum time, average
+ *        stall cycles per call and dropped (migrated) samples
+ */
+void perf_probe_report(void);
+
+#if ENABLE_PERF_PROBES
+#define PERF_PROBE_BEGIN(mark) perf_probe_mark_t mark; perf_probe_begin(&mark)
+#define PERF_PROBE_END(id, mark) perf_probe_end((id), &mark)
+#else
+#define PERF_PROBE_BEGIN(mark) do {} while (0)
+#define PERF_PROBE_END(id, mark) do {} while (0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "app_config.h"
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Retry policy shared by every HTTP client in the firmware. A request that
+ * fails transiently (transport error, 408/429/5xx) is retried up to
+ * RETRY_MAX_ATTEMPTS times inside its stage budget, after an exponential
+ * backoff with jitter, or after the server's Retry-After if that is longer.
+ *
+ * Each host has a circuit breaker. RETRY_BREAKER_FAILURES transient failures
+ * in a row, or a Retry-After, open it: requests to that host fail at once
+ * until the open period ends, then one probe request is let through. A
+ * successful probe closes the breaker; a failed one reopens it for twice as
+ * long, up to RETRY_BREAKER_OPEN_MAX_MS.
+ */
+
+typedef enum {
+    RETRY_HOST_CONVERSION,      // Image conversion API (CONFIG_CONVERSION_API_URL)
+    RETRY_HOST_NHC,             // NHC feed
+    RETRY_HOST_TIME,            // WorldTimeAPI
+    RETRY_HOST_COUNT,
+} retry_host_t;
+
+/**
+ * @brief Short name of a host for logs ("conversion", "nhc", "time")
+ */
+const char *retry_host_name(retry_host_t host);
+
+/**
+ * @brief Whether a failed request is worth repeating
+ *
+ * @param err Result of esp_http_client_perform()
+ * @param status_code HTTP status, 0 if none was received
+ * @return true for transport errors and 408, 425, 429, 500, 502, 503, 504
+ */
+bool retry_transient(esp_err_t err, int status_code);
+
+/**
+ * @brief Parse a Retry-After header value
+ *
+ * @param value Delay in seconds, or an HTTP date (needs a valid clock)
+ * @return Delay in ms, at most RETRY_AFTER_MAX_MS, or 0 if not understood
+ */
+uint32_t retry_parse_after(const char *value);
+
+/**
+ * @brief Exponential backoff with jitter
+ *
+ * @param base_ms Delay before the first retry
+ * @param cap_ms Largest delay
+ * @param attempt Attempts already failed, from 0
+ * @return A delay between half and all of min(cap_ms, base_ms * 2^attempt)
+ */
+uint32_t retry_backoff_ms(uint32_t base_ms, uint32_t cap_ms, int attempt);
+
+/**
+ * @brief Pick when the next attempt of a request may start, if the budget allows
+ *
+ * The next attempt starts after the longer of the backoff (RETRY_BASE_DELAY_MS
+ * doubling up to RETRY_MAX_DELAY_MS) and the server's Retry-After; the
+ * request's http_engine.h job waits for it without holding a connection.
+ *
+ * @param host Host the request goes to, for the retry count
+ * @param attempt Attempts already failed, from 0
+ * @param retry_after_ms Retry-After of the failed response, 0 if none
+ * @param deadline_us esp_timer deadline of the request, 0 for none
+ * @param retry_at_us Set to the esp_timer time of the next attempt
+ * @return false, leaving retry_at_us alone, if the next attempt would start
+ *         past the deadline
+ */
+bool retry_schedule(retry_host_t host, int attempt, uint32_t retry_after_ms, int64_t deadline_us,
+                    int64_t *retry_at_us);
+
+/**
+ * @brief Ask the host's circuit breaker whether a request may go out
+ *
+ * Every call that returns true must be followed by retry_host_result(), or
+ * by retry_host_release() if the request never went out.
+ *
+ * @return false while the breaker is open, or while its probe is running
+ */
+bool retry_host_allow(retry_host_t host);
+
+/**
+ * @brief Give back a request allowed by retry_host_allow() that was not sent
+ */
+void retry_host_release(retry_host_t host);
+
+/**
+ * @brief Record how a request to a host ended
+ *
+ * @param host Host the request went to
+ * @param ok false only for transient failures; a 4xx means the host is up
+ * @param retry_after_ms Retry-After of the response, 0 if none. A non-zero
+ *        value keeps the breaker open at least that long.
+ */
+void retry_host_result(retry_host_t host, bool ok, uint32_t retry_after_ms);
+
+/**
+ * @brief Milliseconds until the host's breaker lets a request through, 0 if it does now
+ */
+uint32_t retry_host_wait_ms(retry_host_t host);
+
+/**
+ * @brief Log the breaker state, retries and blocked requests per host
+ *
+ * One "RETRY host=... state=... retries=... blocked=... trips=..." line per
+ * host, with counts since boot.
+ */
+void retry_report(void);
+
+#ifdef __cplusplus
+}
+#endif
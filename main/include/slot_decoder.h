@@ -0,0 +1,109 @@
+#pragma once
+
+#include "esp_err.h"
+#include "lvgl.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Row-streaming LVGL image decoder for image slots that are not stored as
+ * plain RGB565: palette-indexed slots, RGB565 slots kept RLE-compressed in
+ * bands of rows, and slots still being downloaded. LVGL asks for the image
+ * band by band while drawing, and each band is decoded into a small cache in
+ * internal RAM, so a full-screen image is shown without a decompressed copy
+ * in PSRAM.
+ *
+ * A slot is handed to LVGL through an lv_image_dsc_t made by
+ * slot_decoder_make_dsc(): header flag LV_IMAGE_FLAGS_USER1 marks it, and its
+ * data points at the slot_stream_t describing the pixels.
+ */
+
+typedef enum {
+    SLOT_STREAM_INDEXED,    // Palette indices expanded through an RGB565 LUT
+    SLOT_STREAM_RLE,        // RGB565 rows, RLE-compressed per band (image_rle.h, 2-byte blocks)
+    SLOT_STREAM_RAW,        // Uncompressed RGB565 rows (used while downloading)
+} slot_stream_kind_t;
+
+typedef struct {
+    slot_stream_kind_t kind;
+    uint32_t id;                    // Unique per stream, keys the band cache
+    uint16_t width;
+    uint16_t height;
+    uint16_t rows_ready;            // Rows below this are drawn black; height once complete
+
+    // SLOT_STREAM_INDEXED and SLOT_STREAM_RAW
+    const uint8_t *rows;            // Start of the index or pixel rows
+    size_t stride;
+    uint8_t bpp;
+    const uint16_t *lut;
+
+    // SLOT_STREAM_RLE
+    uint8_t *rle;                   // band_count + 1 offsets followed by the bands (owned)
+    size_t rle_size;
+    uint16_t band_rows;
+    uint16_t band_count;
+} slot_stream_t;
+
+/**
+ * @brief Register the decoder with LVGL and allocate its band cache
+ *
+ * Call with the LVGL lock held, after LVGL has been initialised.
+ *
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the cache could not be allocated
+ */
+esp_err_t slot_decoder_init(void);
+
+/**
+ * @brief Describe an indexed image as a stream; the image and LUT must outlive it
+ *
+ * @param stream Stream to fill in
+ * @param indexed Indexed image (data points at the palette followed by the indices)
+ * @param lut RGB565 table from image_codec_build_palette_lut()
+ */
+void slot_stream_init_indexed(slot_stream_t *stream, const lv_image_dsc_t *indexed, const uint16_t *lut);
+
+/**
+ * @brief Describe RGB565 rows that are still arriving as a stream
+ *
+ * rows_ready starts at 0; raise it (under the LVGL lock) as rows arrive.
+ *
+ * @param stream Stream to fill in
+ * @param pixels First pixel row, must outlive the stream
+ * @param width Image width
+ * @param height Image height
+ */
+void slot_stream_init_raw(slot_stream_t *stream, const uint8_t *pixels, uint32_t width, uint32_t height);
+
+/**
+ * @brief Compress RGB565 pixels into a banded RLE stream in PSRAM
+ *
+ * @param stream Stream to fill in; release with slot_stream_free()
+ * @param pixels width * height RGB565 pixels
+ * @param width Image width
+ * @param height Image height
+ * @return ESP_OK on success, ESP_ERR_INVALID_SIZE if compression would not
+ *         save at least a quarter of the raw size, ESP_ERR_NO_MEM otherwise
+ */
+esp_err_t slot_stream_compress(slot_stream_t *stream, const uint16_t *pixels, uint32_t width, uint32_t height);
+
+/**
+ * @brief Free a stream's compressed data (no-op for indexed streams)
+ */
+void slot_stream_free(slot_stream_t *stream);
+
+/**
+ * @brief Fill in an LVGL image descriptor that draws a stream through this decoder
+ *
+ * @param stream Stream, must stay valid while LVGL may draw the descriptor
+ * @param dsc Descriptor to pass to lv_image_set_src()
+ */
+void slot_decoder_make_dsc(const slot_stream_t *stream, lv_image_dsc_t *dsc);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "app_config.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Time budgets for the update pipeline. A cycle has a hard deadline
+ * (BUDGET_CYCLE_MS from budget_cycle_begin()); each stage started inside it
+ * gets its own budget, cut short by the cycle deadline. HTTP requests carry
+ * their stage deadline: socket timeouts are clipped to the time left and the
+ * request is cancelled from its own event handler once the deadline passes,
+ * and no new image download starts after the cycle deadline.
+ */
+
+typedef enum {
+    BUDGET_STAGE_FEED,          // NHC feed download (BUDGET_FEED_MS)
+    BUDGET_STAGE_IMAGE,         // One conversion request (BUDGET_IMAGE_MS)
+    BUDGET_STAGE_CYCLE,         // Whole update cycle (BUDGET_CYCLE_MS)
+    BUDGET_STAGE_COUNT,
+} budget_stage_t;
+
+/**
+ * @brief Start the cycle deadline; call when an update cycle begins
+ */
+void budget_cycle_begin(void);
+
+/**
+ * @brief Close the cycle, counting an overrun if it ended past its deadline
+ */
+void budget_cycle_end(void);
+
+/**
+ * @brief Deadline for a stage starting now
+ *
+ * @param stage BUDGET_STAGE_FEED or BUDGET_STAGE_IMAGE
+ * @return esp_timer time (us) by which the stage must finish, no later than
+ *         the cycle deadline while a cycle is running
+ */
+int64_t budget_deadline(budget_stage_t stage);
+
+/**
+ * @brief Milliseconds left until a deadline, at most cap_ms and at least 1
+ */
+int budget_remaining_ms(int64_t deadline_us, int cap_ms);
+
+/**
+ * @brief Whether the running cycle has passed its deadline
+ */
+bool budget_cycle_expired(void);
+
+/**
+ * @brief Count a stage that ran over its budget
+ *
+ * @param stage Stage that overran
+ * @param slot Image slot for BUDGET_STAGE_IMAGE, -1 otherwise
+ */
+void budget_overrun(budget_stage_t stage, int slot);
+
+/**
+ * @brief Log the last cycle's duration and overruns per stage
+ *
+ * Also logged as one "BUDGET cycle_ms=... feed=... image=... cycle=..." line
+ * with overrun counts since boot.
+ */
+void budget_report(void);
+
+#ifdef __cplusplus
+}
+#endif
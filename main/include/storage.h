@@ -0,0 +1,29 @@
+#pragma once
+
+#include "esp_err.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Mount the LittleFS filesystem on the "storage" data partition
+ *
+ * Mounts at STORAGE_BASE_PATH, formatting the partition if it does not
+ * contain a valid filesystem (e.g. first boot or after the storage benchmark).
+ *
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t storage_init(void);
+
+/**
+ * @brief Check whether the storage filesystem is mounted
+ *
+ * @return true if storage_init() succeeded
+ */
+bool storage_is_mounted(void);
+
+#ifdef __cplusplus
+}
+#endif
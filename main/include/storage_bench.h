@@ -0,0 +1,30 @@
+#pragma once
+
+#include "esp_err.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Benchmark the candidate storage backends on the data partition
+ *
+ * Runs the same image-sized workload against SPIFFS, LittleFS, FAT on
+ * wear levelling and a raw partition log, all on the "storage" partition.
+ * For each backend it measures sequential write/read throughput, random
+ * 4 KB reads, mmap read bandwidth (raw log only), rewrite and erase cost,
+ * and LVGL render time while the panel is being redrawn, since flash and
+ * PSRAM share the same SPI bus. Results are printed as a table.
+ *
+ * The partition is reformatted by every backend, so anything stored on it
+ * is lost.
+ *
+ * @param disp LVGL display used to generate concurrent redraw load (may be NULL)
+ * @return ESP_OK if every backend ran, ESP_FAIL if any of them failed
+ */
+esp_err_t storage_bench_run(lv_display_t *disp);
+
+#ifdef __cplusplus
+}
+#endif
@@ -10,7 +10,9 @@ extern "C" {
  * @brief Initialize time synchronization using WorldTimeAPI
  * 
  * This function attempts to get the current time from WorldTimeAPI and set the system time.
- * It will retry up to 3 times on failure.
+ * The response runs as an HTTP engine transfer into a streaming JSON sink that keeps only
+ * "unixtime". Up to 10 attempts, with backoff, while the time host's breaker stays closed,
+ * all within 60 s: a Retry-After that runs past that gives up rather than stall the boot.
  * 
  * @return ESP_OK on success, ESP_FAIL on failure
  */
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "app_config.h"
+#include "esp_err.h"
+#include "lvgl.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Timeline tracing. TRACE_BEGIN/TRACE_END record a timestamped begin or end
+ * event for the calling task into a ring owned by the current core; each
+ * core only ever writes its own ring, with interrupts masked for the few
+ * stores involved, so no lock is shared between cores. The rings keep the
+ * most recent TRACE_RING_EVENTS events per core and are exported as Chrome
+ * trace event JSON, which chrome://tracing and ui.perfetto.dev open
+ * directly: one track per task, with the core of each event in its args.
+ *
+ * Names must be string literals (only the pointer is stored). With
+ * CONFIG_TRACE off the macros compile to nothing.
+ */
+
+/**
+ * @brief Called with successive pieces of the JSON export
+ */
+typedef void (*trace_write_fn)(const char *data, size_t len, void *arg);
+
+/**
+ * @brief Record a begin ('B') or end ('E') event; use the macros instead
+ */
+void trace_event(const char *name, char phase);
+
+/**
+ * @brief Trace LVGL renders and flushes of a display as "lvgl_render" and
+ *        "lvgl_flush" spans
+ *
+ * Call with the LVGL lock held.
+ */
+void trace_watch_display(lv_display_t *disp);
+
+/**
+ * @brief Export the recorded events as Chrome trace JSON and clear them
+ *
+ * Recording is paused while the rings are read.
+ *
+ * @param write Output callback
+ * @param arg Passed to @p write
+ * @return ESP_OK, or ESP_ERR_NOT_SUPPORTED when tracing is compiled out
+ */
+esp_err_t trace_export(trace_write_fn write, void *arg);
+
+/**
+ * @brief Print the trace to the console between "TRACE BEGIN" and
+ *        "TRACE END" marker lines for tools/trace/extract_trace.py
+ */
+void trace_dump_serial(void);
+
+#if ENABLE_TRACE
+#define TRACE_BEGIN(name) trace_event((name), 'B')
+#define TRACE_END(name) trace_event((name), 'E')
+#else
+#define TRACE_BEGIN(name) do {} while (0)
+#define TRACE_END(name) do {} while (0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
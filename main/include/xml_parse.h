@@ -1,7 +1,9 @@
 #ifndef XML_PARSE_H
 #define XML_PARSE_H
 
+#include <stdbool.h>
 #include <stdio.h>
+#include <time.h>
 
 /**
  * @brief Parses the National Hurricane Center XML feed and prints storm graphics URLs.
@@ -48,6 +50,61 @@ char *xml_parse_cone_image_url(const char *buf, size_t len);
  */
 char **xml_parse_all_cone_image_urls(const char *buf, size_t len, int *count);
 
+/**
+ * @brief Parses the National Hurricane Center XML feed and extracts all cone image URLs
+ *        with the publication time of the advisory each one belongs to.
+ *
+ * Same as xml_parse_all_cone_image_urls(), and also reads each item's RSS <pubDate>.
+ *
+ * @param buf Buffer containing XML data.
+ * @param len Length of the buffer.
+ * @param count Pointer to store the number of URLs found.
+ * @param pub_dates If not NULL, receives an array of count UTC times parallel to the
+ *        returned URLs (0 where an item had no readable pubDate). Caller must free it.
+ * @param outlook_pub_date If not NULL, receives the pubDate of the first Tropical Weather
+ *        Outlook item, or of the channel if there is none (0 if neither is present).
+ * @return Array of allocated strings containing cone image URLs, or NULL if none found.
+ *         Caller must free it with xml_parse_free_urls().
+ */
+char **xml_parse_cone_images(const char *buf, size_t len, int *count, time_t **pub_dates, time_t *outlook_pub_date);
+
+/**
+ * @brief Incremental form of xml_parse_cone_images(), for a feed parsed as it downloads.
+ */
+typedef struct xml_stream xml_stream_t;
+
+/**
+ * @brief Starts an incremental parse.
+ *
+ * @return The parse, or NULL if out of memory. End it with xml_stream_end().
+ */
+xml_stream_t *xml_stream_begin(void);
+
+/**
+ * @brief Parses the next piece of the feed.
+ *
+ * Pieces may split the document anywhere, inside a tag or a UTF-8 sequence included.
+ *
+ * @param stream Incremental parse.
+ * @param buf Next bytes of the feed (may be NULL if len is 0).
+ * @param len Number of bytes.
+ * @param final True for the last piece, which checks the document is complete.
+ * @return False once the feed is found to be malformed; later calls do nothing.
+ */
+bool xml_stream_feed(xml_stream_t *stream, const char *buf, size_t len, bool final);
+
+/**
+ * @brief Ends an incremental parse and frees it.
+ *
+ * Takes the same outputs as xml_parse_cone_images(). Call xml_stream_feed() with
+ * final set first to check the document was complete; after a parse error
+ * nothing is returned.
+ *
+ * @return Array of cone image URLs, or NULL if none were found or the feed was malformed.
+ *         Caller must free it with xml_parse_free_urls().
+ */
+char **xml_stream_end(xml_stream_t *stream, int *count, time_t **pub_dates, time_t *outlook_pub_date);
+
 /**
  * @brief Frees the array of URLs returned by xml_parse_all_cone_image_urls.
  *
@@ -56,4 +113,12 @@ char **xml_parse_all_cone_image_urls(const char *buf, size_t len, int *count);
  */
 void xml_parse_free_urls(char **urls, int count);
 
+/**
+ * @brief Parses an RFC 822 date, as in an RSS <pubDate> or an HTTP date header.
+ *
+ * @param s Date such as "Tue, 15 Oct 2024 20:51:07 GMT" ("+0000" and US zone names also accepted).
+ * @return UTC seconds, or 0 if the string is not understood.
+ */
+time_t xml_parse_date(const char *s);
+
 #endif // XML_PARSE_H
@@ -40,13 +40,17 @@
 #include "esp_tls.h"
 #include "esp_crt_bundle.h"
 #include "nvs_flash.h"
+#include "esp_rom_crc.h"
 #include "cJSON.h"
+#include <stdatomic.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/time.h>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
+#include "freertos/queue.h"
 #include "freertos/event_groups.h"
 #include "driver/gpio.h"
 
@@ -62,6 +66,24 @@
 #include "time_sync.h"
 #include "wifi_manager.h"
 #include "http_client.h"
+#include "storage_bench.h"
+#include "codec_bench.h"
+#include "perf_probe.h"
+#include "perf_bench.h"
+#include "binlog.h"
+#include "trace.h"
+#include "boot_profile.h"
+#include "freshness.h"
+#include "stage_budget.h"
+#include "retry_policy.h"
+#include "net_timing.h"
+#include "http_inflate.h"
+#include "http_transfer.h"
+#include "app_console.h"
+#include "storage.h"
+#include "advisory_history.h"
+#include "image_codec.h"
+#include "slot_decoder.h"
 
 // Include the pre-converted image data
 extern const lv_image_dsc_t error_image;
@@ -90,23 +112,34 @@ static const char TAG[] = APP_NAME;
 // Globals accessed by http_client module
 char* image_urls[MAX_IMAGES] = {NULL}; // Dynamic array of URLs
 char* image_names[MAX_IMAGES] = {NULL}; // Dynamic array of storm names
+time_t image_pub_dates[MAX_IMAGES] = {0}; // NHC pubDate of each image's advisory, 0 if unknown
 int active_image_count = 0; // Number of active storm images
 
-// Function to check if current time matches NHC update times
-static bool is_nhc_update_time(void) {
+// Function to check if an NHC update time has passed since the last cycle
+// started. Comparing against the last cycle rather than matching the current
+// minute means a cycle that runs past a scheduled minute does not skip it.
+static bool is_nhc_update_time(time_t last_cycle) {
     static const char* nhc_update_times[NHC_UPDATE_TIMES_COUNT] = NHC_UPDATE_TIMES;
     
     time_t now;
-    struct tm timeinfo;
     time(&now);
-    gmtime_r(&now, &timeinfo);  // Use UTC time
-    
-    char current_time[6];
-    strftime(current_time, sizeof(current_time), "%H:%M", &timeinfo);
+    if (last_cycle < CLOCK_VALID_EPOCH || last_cycle > now) {
+        // Clock was not set when the last cycle started; only look at this minute
+        last_cycle = now - 60;
+    }
     
+    time_t midnight = now - now % 86400;  // UTC
     for (int i = 0; i < NHC_UPDATE_TIMES_COUNT; i++) {
-        if (strcmp(current_time, nhc_update_times[i]) == 0) {
-            ESP_LOGI(TAG, "Current time %s matches NHC update time", current_time);
+        int hour, minute;
+        if (sscanf(nhc_update_times[i], "%d:%d", &hour, &minute) != 2) {
+            continue;
+        }
+        time_t scheduled = midnight + hour * 3600 + minute * 60;
+        if (scheduled > now) {
+            scheduled -= 86400;     // Yesterday's occurrence
+        }
+        if (scheduled > last_cycle) {
+            ESP_LOGI(TAG, "NHC update time %s reached", nhc_update_times[i]);
             return true;
         }
     }
@@ -120,13 +153,36 @@ typedef struct {
     size_t buffer_size;
     size_t buffer_allocated;
     lv_img_dsc_t img_dsc;
+    uint16_t *palette_lut;      // RGB565 palette for indexed images, NULL otherwise
+    slot_stream_t stream;       // Indexed or RLE-compressed pixels, drawn by the slot decoder
+    lv_image_dsc_t stream_dsc;  // What LVGL draws when is_streamed is set
+    bool is_streamed;
     bool is_valid;
     time_t download_timestamp;  // When this image was downloaded/processed
+    time_t pub_date;            // NHC pubDate of the advisory shown, 0 if unknown
+    uint32_t url_crc;           // CRC32 of the source URL the image came from
+    bool refresh_missed;        // Kept from an earlier cycle because this one did not replace it
+    uint32_t payload_crc;       // CRC32 of the last downloaded payload, kept across downloads
 } image_data_t;
 
 static image_data_t s_images[MAX_IMAGES];
+
 static int s_current_image_index = 0;
 static TimerHandle_t s_image_cycle_timer = NULL;
+static uint32_t s_dwell_ms = IMAGE_DISPLAY_INTERVAL_MS;    // Time each image stays up, changeable from the console
+
+#if ENABLE_PROGRESSIVE_DISPLAY
+// The first slot of each download batch is drawn while it arrives. The stream
+// points into the slot's download buffer and is advanced from the HTTP event
+// handler; the LVGL objects are only touched under the LVGL lock.
+static volatile int s_progress_index = -1;     // Slot being shown as it downloads, -1 if none
+static bool s_progress_started = false;
+static size_t s_progress_offset = 0;           // Header (and palette) bytes before the first row
+static slot_stream_t s_progress_stream;
+static lv_image_dsc_t s_progress_dsc;
+static lv_obj_t *s_progress_img = NULL;
+static lv_obj_t *s_progress_label = NULL;
+#endif
 
 // Image buffer management functions (called from http_client.c)
 esp_err_t get_image_buffer_info(int image_index, char **buffer, size_t *buffer_size, size_t *buffer_allocated)
@@ -155,14 +211,44 @@ void set_image_buffer_info(int image_index, char *buffer, size_t buffer_size, si
 void reset_image_buffer(int image_index)
 {
     if (image_index >= 0 && image_index < MAX_IMAGES) {
+        // The slot may be on screen. As in compress_image_slot(), its
+        // descriptors are swapped in place under the LVGL lock, so anything
+        // still drawing it shows the error image until the next rotation,
+        // before the pixels are freed.
+        lvgl_port_lock(0);
+#if ENABLE_PROGRESSIVE_DISPLAY
+        // The progressive view draws from this buffer; it starts over from the
+        // header if the slot is downloaded again
+        if (image_index == s_progress_index && s_progress_started) {
+            if (s_progress_img != NULL) {
+                lv_image_set_src(s_progress_img, NULL);
+            }
+            s_progress_started = false;
+        }
+#endif
+        s_images[image_index].img_dsc = error_image;
+        s_images[image_index].stream_dsc = error_image;
+        lv_image_cache_drop(&s_images[image_index].img_dsc);
+        lv_image_cache_drop(&s_images[image_index].stream_dsc);
         if (s_images[image_index].buffer != NULL) {
             free(s_images[image_index].buffer);
         }
         s_images[image_index].buffer = NULL;
         s_images[image_index].buffer_size = 0;
         s_images[image_index].buffer_allocated = 0;
+        if (s_images[image_index].palette_lut != NULL) {
+            free(s_images[image_index].palette_lut);
+        }
+        s_images[image_index].palette_lut = NULL;
+        if (s_images[image_index].is_streamed) {
+            slot_stream_free(&s_images[image_index].stream);
+            s_images[image_index].is_streamed = false;
+        }
         s_images[image_index].is_valid = false;
         s_images[image_index].download_timestamp = 0;
+        s_images[image_index].pub_date = 0;
+        s_images[image_index].refresh_missed = false;
+        lvgl_port_unlock();
     }
 }
 
@@ -255,6 +341,160 @@ static void touch_event_cb(lv_event_t *e)
 
 
 
+#if DISPLAY_ROTATION
+// LVGL works in panel (landscape) coordinates. Put a w x h object where a
+// viewer of the portrait-mounted panel expects it and rotate it to read upright.
+static void place_rotated(lv_obj_t *obj, int32_t w, int32_t h, lv_align_t align, int32_t x_ofs, int32_t y_ofs)
+{
+    const int32_t vw = BSP_LCD_V_RES;   // Screen as the viewer sees it
+    const int32_t vh = BSP_LCD_H_RES;
+
+    int32_t cu = vw / 2;
+    int32_t cv = vh - h / 2;
+    if (align == LV_ALIGN_BOTTOM_LEFT) {
+        cu = w / 2;
+    } else if (align == LV_ALIGN_BOTTOM_RIGHT) {
+        cu = vw - w / 2;
+    } else if (align == LV_ALIGN_CENTER) {
+        cv = vh / 2;
+    }
+    cu += x_ofs;
+    cv += y_ofs;
+
+    int32_t x = (DISPLAY_ROTATION == 90) ? vh - 1 - cv : cv;
+    int32_t y = (DISPLAY_ROTATION == 90) ? cu : vw - 1 - cu;
+    lv_obj_set_size(obj, w, h);
+    lv_obj_set_pos(obj, x - w / 2, y - h / 2);
+    lv_obj_set_style_transform_pivot_x(obj, w / 2, 0);
+    lv_obj_set_style_transform_pivot_y(obj, h / 2, 0);
+    lv_obj_set_style_transform_rotation(obj, DISPLAY_ROTATION * 10, 0);
+}
+#endif
+
+// Image area above the caption strip, as the viewer sees it
+static void place_image_area(lv_obj_t *obj)
+{
+#if DISPLAY_ROTATION
+    // Slots are rotated at load time, so this is a plain panel rectangle
+    lv_obj_set_size(obj, BSP_LCD_H_RES - CAPTION_HEIGHT, BSP_LCD_V_RES);
+    lv_obj_set_align(obj, (DISPLAY_ROTATION == 90) ? LV_ALIGN_RIGHT_MID : LV_ALIGN_LEFT_MID);
+#else
+    lv_obj_set_align(obj, LV_ALIGN_TOP_MID);
+    lv_obj_set_size(obj, BSP_LCD_H_RES, BSP_LCD_V_RES - CAPTION_HEIGHT);
+#endif
+}
+
+// Caption label centred along the bottom edge, as the viewer sees it
+static void place_caption(lv_obj_t *label)
+{
+#if DISPLAY_ROTATION
+    place_rotated(label, BSP_LCD_V_RES, CAPTION_HEIGHT, LV_ALIGN_BOTTOM_MID, 0, 0);
+#else
+    lv_obj_align(label, LV_ALIGN_BOTTOM_MID, 0, 0);
+#endif
+}
+
+#if DISPLAY_ROTATION
+// Turn a slot a quarter turn for the portrait mount, so drawing it stays a
+// plain copy. I8 indices rotate as bytes; sub-byte indices are expanded first.
+static esp_err_t rotate_image_slot(int image_index)
+{
+    image_data_t *img_data = &s_images[image_index];
+    lv_image_dsc_t *dsc = &img_data->img_dsc;
+    uint32_t w = dsc->header.w;
+    uint32_t h = dsc->header.h;
+
+    if (image_codec_is_indexed(dsc->header.cf) && dsc->header.cf != LV_COLOR_FORMAT_I8) {
+        size_t size = 0;
+        uint8_t *rgb565 = image_codec_alloc_rgb565(w, h, &size);
+        if (rgb565 == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+        uint16_t lut[16];
+        image_codec_build_palette_lut(dsc->data, image_codec_palette_entries(dsc->header.cf), lut);
+        image_codec_expand_indexed(dsc, lut, (uint16_t *)(rgb565 + IMAGE_HEADER_SIZE));
+        free(img_data->buffer);
+        img_data->buffer = (char *)rgb565;
+        img_data->buffer_size = size;
+        img_data->buffer_allocated = size;
+        dsc->header.cf = LV_COLOR_FORMAT_RGB565;
+        dsc->header.stride = w * sizeof(uint16_t);
+        dsc->data = rgb565 + IMAGE_HEADER_SIZE;
+        dsc->data_size = size - IMAGE_HEADER_SIZE;
+    }
+
+    const bool indexed = dsc->header.cf == LV_COLOR_FORMAT_I8;
+    const uint32_t px_size = indexed ? 1 : sizeof(uint16_t);
+    const size_t palette = image_codec_palette_entries(dsc->header.cf) * PALETTE_ENTRY_SIZE;
+    const size_t src_stride = indexed ? w : (dsc->header.stride ? dsc->header.stride : w * px_size);
+    const size_t size = IMAGE_HEADER_SIZE + palette + (size_t)w * h * px_size;
+
+    uint8_t *rotated = heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+    if (rotated == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate %zu bytes to rotate image %d", size, image_index);
+        return ESP_ERR_NO_MEM;
+    }
+
+    int64_t start = esp_timer_get_time();
+    memcpy(rotated, img_data->buffer, IMAGE_HEADER_SIZE + palette);
+    image_codec_rotate(dsc->data + palette, w, h, src_stride, px_size, DISPLAY_ROTATION == 90,
+                       rotated + IMAGE_HEADER_SIZE + palette);
+    BINLOG(BL_IMG_ROTATED, image_index, w, h, esp_timer_get_time() - start);
+
+    // Keep the buffer's own header in step with the descriptor
+    uint16_t *header = (uint16_t *)rotated;
+    header[2] = h;
+    header[3] = w;
+    header[4] = h * px_size;
+
+    free(img_data->buffer);
+    img_data->buffer = (char *)rotated;
+    img_data->buffer_size = size;
+    img_data->buffer_allocated = size;
+    dsc->header.w = h;
+    dsc->header.h = w;
+    dsc->header.stride = h * px_size;
+    dsc->data = rotated + IMAGE_HEADER_SIZE;
+    dsc->data_size = size - IMAGE_HEADER_SIZE;
+    return ESP_OK;
+}
+#endif
+
+// Replace a slot's pixels with an RGB565 copy; the slot's descriptor must
+// already describe the source image
+static esp_err_t normalize_image_slot(int image_index)
+{
+    image_data_t *img_data = &s_images[image_index];
+    lv_image_dsc_t *dsc = &img_data->img_dsc;
+
+    size_t size = 0;
+    uint8_t *rgb565 = image_codec_alloc_rgb565(dsc->header.w, dsc->header.h, &size);
+    if (rgb565 == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate %zu bytes to normalize image %d", size, image_index);
+        return ESP_ERR_NO_MEM;
+    }
+
+    int64_t start = esp_timer_get_time();
+    esp_err_t err = image_codec_normalize(dsc, (uint16_t *)(rgb565 + IMAGE_HEADER_SIZE));
+    if (err != ESP_OK) {
+        free(rgb565);
+        return err;
+    }
+    BINLOG(BL_IMG_NORMALIZED, image_index, dsc->header.cf, esp_timer_get_time() - start, size);
+
+    free(img_data->buffer);
+    img_data->buffer = (char *)rgb565;
+    img_data->buffer_size = size;
+    img_data->buffer_allocated = size;
+
+    dsc->header.cf = LV_COLOR_FORMAT_RGB565;
+    dsc->header.flags = 0;
+    dsc->header.stride = dsc->header.w * sizeof(uint16_t);
+    dsc->data = rgb565 + IMAGE_HEADER_SIZE;
+    dsc->data_size = size - IMAGE_HEADER_SIZE;
+    return ESP_OK;
+}
+
 // Function to initialize an LVGL image descriptor from the downloaded buffer
 static esp_err_t process_downloaded_image(int image_index)
 {
@@ -266,14 +506,32 @@ static esp_err_t process_downloaded_image(int image_index)
     image_data_t *img_data = &s_images[image_index];
     
     if (img_data->buffer != NULL && img_data->buffer_size > 0) {
-        ESP_LOGI(TAG, "Processing downloaded image %d", image_index);
+        BINLOG(BL_IMG_PROCESSING, image_index, img_data->buffer_size);
         
         // Check if the buffer is large enough to contain at least a valid header
         if (img_data->buffer_size < 8) {
             ESP_LOGE(TAG, "Downloaded buffer too small to be a valid image for image %d", image_index);
             return ESP_FAIL;
         }
-        
+
+        // JPEG transfers are decoded straight into a new RGB565 slot buffer, which
+        // then goes through the same header parsing as a converted .bin
+        if (image_codec_is_jpeg((const uint8_t *)img_data->buffer, img_data->buffer_size)) {
+            uint8_t *decoded = NULL;
+            size_t decoded_size = 0;
+            uint32_t decode_us = 0;
+            if (image_codec_decode_jpeg((const uint8_t *)img_data->buffer, img_data->buffer_size,
+                                        &decoded, &decoded_size, &decode_us) != ESP_OK) {
+                ESP_LOGE(TAG, "Failed to decode JPEG for image %d", image_index);
+                return ESP_FAIL;
+            }
+            BINLOG(BL_IMG_JPEG, image_index, img_data->buffer_size, decoded_size, decode_us);
+            free(img_data->buffer);
+            img_data->buffer = (char *)decoded;
+            img_data->buffer_size = decoded_size;
+            img_data->buffer_allocated = decoded_size;
+        }
+
         // Set up the image descriptor using the downloaded buffer
         // Your API uses this custom binary format:
         // byte 0: magic number (0x19 for LVGL v9)
@@ -299,22 +557,22 @@ static esp_err_t process_downloaded_image(int image_index)
         uint16_t stride = *(uint16_t*)(img_data->buffer + 8);
         uint16_t reserved = *(uint16_t*)(img_data->buffer + 10);
         
-        ESP_LOGI(TAG, "Parsed custom header for image %d: magic=0x%02x, cf=%d, flags=%d, w=%d, h=%d, stride=%d", 
-                 image_index, magic, color_format, flags, width, height, stride);
+        BINLOG(BL_IMG_HEADER, image_index, color_format, width, height);
         
         // Verify magic number
         if (magic != 0x19) {
-            ESP_LOGW(TAG, "Unexpected magic number: 0x%02x (expected 0x19) for image %d", magic, image_index);
+            BINLOG(BL_IMG_BAD_MAGIC, magic, image_index);
         }
         
         img_data->img_dsc.header.w = width;
         img_data->img_dsc.header.h = height;
+        img_data->img_dsc.header.stride = stride;
+        img_data->img_dsc.header.flags = 0;
         
         // Check if the width and height seem reasonable
         if (img_data->img_dsc.header.w > 4096 || img_data->img_dsc.header.h > 4096 ||
             img_data->img_dsc.header.w == 0 || img_data->img_dsc.header.h == 0) {
-            ESP_LOGW(TAG, "Image dimensions invalid: %dx%d for image %d", 
-                    img_data->img_dsc.header.w, img_data->img_dsc.header.h, image_index);
+            BINLOG(BL_IMG_BAD_SIZE, img_data->img_dsc.header.w, img_data->img_dsc.header.h, image_index);
             img_data->is_valid = false;
             return ESP_FAIL;
         }
@@ -323,35 +581,34 @@ static esp_err_t process_downloaded_image(int image_index)
         switch (color_format) {
             case 0x12: // RGB565
                 img_data->img_dsc.header.cf = LV_COLOR_FORMAT_RGB565;
-                ESP_LOGI(TAG, "Using RGB565 format for image %d", image_index);
                 break;
             case 0x0F: // RGB888
                 img_data->img_dsc.header.cf = LV_COLOR_FORMAT_RGB888;
-                ESP_LOGI(TAG, "Using RGB888 format for image %d", image_index);
                 break;
             case 0x10: // ARGB8888
                 img_data->img_dsc.header.cf = LV_COLOR_FORMAT_ARGB8888;
-                ESP_LOGI(TAG, "Using ARGB8888 format for image %d", image_index);
                 break;
             case 0x14: // RGB565A8 (RGB565 with alpha channel)
                 img_data->img_dsc.header.cf = LV_COLOR_FORMAT_RGB565A8;
-                ESP_LOGI(TAG, "Using RGB565A8 format for image %d", image_index);
                 break;
             case 0x13: // ARGB8565
                 img_data->img_dsc.header.cf = LV_COLOR_FORMAT_ARGB8565;
-                ESP_LOGI(TAG, "Using ARGB8565 format for image %d", image_index);
                 break;
             case 0x11: // XRGB8888
                 img_data->img_dsc.header.cf = LV_COLOR_FORMAT_XRGB8888;
-                ESP_LOGI(TAG, "Using XRGB8888 format for image %d", image_index);
                 break;
             case 0x06: // L8 (grayscale)
                 img_data->img_dsc.header.cf = LV_COLOR_FORMAT_L8;
-                ESP_LOGI(TAG, "Using L8 format for image %d", image_index);
+                break;
+            case 0x09: // I4 (16-colour palette)
+                img_data->img_dsc.header.cf = LV_COLOR_FORMAT_I4;
+                break;
+            case 0x0A: // I8 (256-colour palette)
+                img_data->img_dsc.header.cf = LV_COLOR_FORMAT_I8;
                 break;
             default:
                 // Default to RGB565 if format is unknown
-                ESP_LOGW(TAG, "Unknown color format 0x%02x, defaulting to RGB565 for image %d", color_format, image_index);
+                BINLOG(BL_IMG_UNKNOWN_CF, color_format, image_index);
                 img_data->img_dsc.header.cf = LV_COLOR_FORMAT_RGB565;
                 break;
         }
@@ -388,10 +645,17 @@ static esp_err_t process_downloaded_image(int image_index)
         
         size_t expected_size = img_data->img_dsc.header.w * img_data->img_dsc.header.h * bytes_per_pixel;
         
+        // Indexed images: palette (4 bytes per entry) followed by packed indices
+        lv_color_format_t cf = img_data->img_dsc.header.cf;
+        size_t palette_entries = image_codec_palette_entries(cf);
+        if (image_codec_is_indexed(cf)) {
+            expected_size = palette_entries * PALETTE_ENTRY_SIZE +
+                            image_codec_indexed_stride(cf, img_data->img_dsc.header.w) * img_data->img_dsc.header.h;
+        }
+        
         // Check if the buffer contains enough data for the image
         if (img_data->buffer_size < expected_size + 12) {
-            ESP_LOGW(TAG, "Downloaded buffer size (%u) is smaller than expected for image %d (%u + 12 byte header)",
-                     img_data->buffer_size, image_index, expected_size);
+            BINLOG(BL_IMG_SHORT, img_data->buffer_size, image_index, expected_size);
             
             img_data->is_valid = false;
             return ESP_FAIL;
@@ -399,9 +663,49 @@ static esp_err_t process_downloaded_image(int image_index)
         
         img_data->img_dsc.data_size = expected_size;
         
-        ESP_LOGI(TAG, "Created LVGL image %d: %dx%d, format: %d, data size: %u bytes",
-                 image_index, img_data->img_dsc.header.w, img_data->img_dsc.header.h, 
-                 img_data->img_dsc.header.cf, img_data->img_dsc.data_size);
+        // Any other non-native format is converted to opaque RGB565 once here, so
+        // LVGL draws every image with the same plain copy instead of converting
+        // and blending it on each redraw
+        if (image_codec_needs_normalize(cf)) {
+            img_data->img_dsc.header.flags = flags & LV_IMAGE_FLAGS_PREMULTIPLIED;
+            if (normalize_image_slot(image_index) != ESP_OK) {
+                img_data->is_valid = false;
+                return ESP_FAIL;
+            }
+            cf = LV_COLOR_FORMAT_RGB565;
+        }
+        
+#if DISPLAY_ROTATION
+        // Portrait mount: rotate once here rather than on every flush
+        if (rotate_image_slot(image_index) != ESP_OK) {
+            img_data->is_valid = false;
+            return ESP_FAIL;
+        }
+        cf = img_data->img_dsc.header.cf;
+        expected_size = img_data->img_dsc.data_size;
+#endif
+        
+        // Pixels stay indexed in the slot; only the palette is converted now
+        if (image_codec_is_indexed(cf)) {
+            if (img_data->palette_lut == NULL) {
+                img_data->palette_lut = heap_caps_malloc(256 * sizeof(uint16_t), MALLOC_CAP_INTERNAL);
+            }
+            if (img_data->palette_lut == NULL) {
+                ESP_LOGE(TAG, "Failed to allocate palette for image %d", image_index);
+                img_data->is_valid = false;
+                return ESP_FAIL;
+            }
+            image_codec_build_palette_lut(img_data->img_dsc.data, palette_entries, img_data->palette_lut);
+            img_data->img_dsc.header.stride = image_codec_indexed_stride(cf, img_data->img_dsc.header.w);
+            slot_stream_init_indexed(&img_data->stream, &img_data->img_dsc, img_data->palette_lut);
+            slot_decoder_make_dsc(&img_data->stream, &img_data->stream_dsc);
+            img_data->is_streamed = true;
+            BINLOG(BL_IMG_INDEXED, image_index, expected_size,
+                   img_data->img_dsc.header.w * img_data->img_dsc.header.h * 2);
+        }
+        
+        BINLOG(BL_IMG_CREATED, image_index, img_data->img_dsc.header.w, img_data->img_dsc.header.h,
+               img_data->img_dsc.header.cf);
         
         img_data->is_valid = true;
         
@@ -434,7 +738,7 @@ static const lv_img_dsc_t* get_next_valid_image(void)
     }
     
     // If no valid images found, return error image
-    ESP_LOGW(TAG, "No valid images available, using error image");
+    BINLOG(BL_DISP_NO_VALID);
     return &error_image;
 }
 
@@ -538,16 +842,414 @@ static esp_err_t app_lvgl_init(esp_lcd_panel_handle_t lp, esp_lcd_touch_handle_t
     return ESP_OK;
 }
 
-// Simplified display function that uses the global pointer
-static void display_image_from_global_pointer(void)
+// Descriptor LVGL should draw for a slot. Indexed and compressed slots go through
+// the slot decoder, which expands them band by band while drawing.
+static const lv_image_dsc_t *slot_display_image(int image_index)
+{
+    image_data_t *img_data = &s_images[image_index];
+    return img_data->is_streamed ? &img_data->stream_dsc : &img_data->img_dsc;
+}
+
+#if ENABLE_SLOT_COMPRESSION
+// Swap a processed RGB565 slot for a banded RLE copy and free the raw pixels
+static void compress_image_slot(int image_index)
 {
+    image_data_t *img_data = &s_images[image_index];
+    if (!img_data->is_valid || img_data->is_streamed ||
+        img_data->img_dsc.header.cf != LV_COLOR_FORMAT_RGB565) {
+        return;
+    }
+
+    slot_stream_t stream;
+    int64_t start = esp_timer_get_time();
+    esp_err_t err = slot_stream_compress(&stream, (const uint16_t *)img_data->img_dsc.data,
+                                         img_data->img_dsc.header.w, img_data->img_dsc.header.h);
+    if (err != ESP_OK) {
+        BINLOG(BL_IMG_UNCOMPRESSED, image_index, err);
+        return;
+    }
+    BINLOG(BL_IMG_COMPRESSED, image_index, img_data->img_dsc.data_size, stream.rle_size,
+           esp_timer_get_time() - start);
+
+    // The slot may be on screen. Swapping the descriptor in place under the LVGL
+    // lock means anything drawing it switches to the decoder before the raw
+    // pixels are freed.
+    lvgl_port_lock(0);
+    img_data->stream = stream;
+    slot_decoder_make_dsc(&img_data->stream, &img_data->stream_dsc);
+    img_data->img_dsc = img_data->stream_dsc;
+    img_data->is_streamed = true;
+    lv_image_cache_drop(&img_data->img_dsc);
+#if ENABLE_PROGRESSIVE_DISPLAY
+    // The progressive view draws straight from the download buffer
+    if (s_progress_img != NULL && s_progress_stream.rows == (const uint8_t *)img_data->buffer + s_progress_offset) {
+        lv_image_set_src(s_progress_img, &img_data->img_dsc);
+    }
+#endif
+    free(img_data->buffer);
+    img_data->buffer = NULL;
+    img_data->buffer_size = 0;
+    img_data->buffer_allocated = 0;
+    lvgl_port_unlock();
+}
+#endif
+
+// Set while the advisory history view owns the screen; the display task skips rotations
+static volatile bool s_history_active = false;
+
+#if ENABLE_TOUCHSCREEN && ENABLE_ADVISORY_HISTORY
+// History playback state, only touched from the LVGL task
+static history_player_t *s_history_player = NULL;
+static lv_timer_t *s_history_timer = NULL;
+static lv_obj_t *s_history_img = NULL;
+static lv_obj_t *s_history_slider = NULL;
+static lv_obj_t *s_history_label = NULL;
+static int s_history_index = 0;
+static bool s_history_playing = true;
+static int64_t s_history_last_input_us = 0;
+static char s_history_storm[HISTORY_STORM_ID_LEN];
+
+static void history_show(int index)
+{
+    const lv_image_dsc_t *frame = history_player_seek(s_history_player, index);
+    if (frame == NULL) {
+        ESP_LOGW(TAG, "Failed to seek %s history to advisory %d", s_history_storm, index);
+        return;
+    }
+    s_history_index = index;
+
+    // Pixels change in place, so drop any cached copy before redrawing
+    lv_image_cache_drop(frame);
+    lv_image_set_src(s_history_img, frame);
+    lv_obj_invalidate(s_history_img);
+    lv_slider_set_value(s_history_slider, index, LV_ANIM_OFF);
+
+    struct tm timeinfo;
+    time_t ts = history_player_timestamp(s_history_player, index);
+    gmtime_r(&ts, &timeinfo);
+    lv_label_set_text_fmt(s_history_label, "%s advisory %d/%d\n%04d-%02d-%02d %02d:%02d UTC%s",
+                          s_history_storm, index + 1, history_player_count(s_history_player),
+                          timeinfo.tm_year + 1900, timeinfo.tm_mon + 1, timeinfo.tm_mday,
+                          timeinfo.tm_hour, timeinfo.tm_min,
+                          s_history_playing ? "" : " (paused)");
+}
+
+static void history_exit(void *arg)
+{
+    if (s_history_timer != NULL) {
+        lv_timer_delete(s_history_timer);
+        s_history_timer = NULL;
+    }
+    lv_obj_clean(lv_screen_active());
+    history_player_close(s_history_player);
+    s_history_player = NULL;
+    s_history_active = false;
+
+    ESP_LOGI(TAG, "Leaving %s history view", s_history_storm);
+
+    // Resume the normal rotation
+    if (s_image_cycle_timer != NULL) {
+        xTimerStart(s_image_cycle_timer, 0);
+    }
+    if (s_display_task_handle != NULL) {
+        xTaskNotifyGive(s_display_task_handle);
+    }
+}
+
+static void history_timer_cb(lv_timer_t *timer)
+{
+    if (esp_timer_get_time() - s_history_last_input_us > (int64_t)HISTORY_VIEW_TIMEOUT_MS * 1000) {
+        history_exit(NULL);
+        return;
+    }
+    if (s_history_playing) {
+        history_show((s_history_index + 1) % history_player_count(s_history_player));
+    }
+}
+
+static void history_event_cb(lv_event_t *e)
+{
+    s_history_last_input_us = esp_timer_get_time();
+
+    switch (lv_event_get_code(e)) {
+        case LV_EVENT_SHORT_CLICKED:
+            s_history_playing = !s_history_playing;
+            history_show(s_history_index);
+            break;
+        case LV_EVENT_VALUE_CHANGED:
+            s_history_playing = false;
+            history_show(lv_slider_get_value(s_history_slider));
+            break;
+        case LV_EVENT_LONG_PRESSED:
+            // Deleting the target inside its own event is unsafe; defer
+            lv_async_call(history_exit, NULL);
+            break;
+        default:
+            break;
+    }
+}
+
+static void history_enter(void *arg)
+{
+    int image_index = (int)(intptr_t)arg;
+    if (s_history_active || image_index < 0 || image_index >= active_image_count ||
+        !history_storm_id_from_url(image_urls[image_index], s_history_storm, sizeof(s_history_storm))) {
+        return;
+    }
+
+    s_history_player = history_player_open(s_history_storm);
+    if (s_history_player == NULL || history_player_count(s_history_player) < 2) {
+        ESP_LOGI(TAG, "Not enough history for %s", s_history_storm);
+        history_player_close(s_history_player);
+        s_history_player = NULL;
+        return;
+    }
+
+    ESP_LOGI(TAG, "Entering %s history view (%d advisories)", s_history_storm,
+             history_player_count(s_history_player));
+    s_history_active = true;
+    if (s_image_cycle_timer != NULL) {
+        xTimerStop(s_image_cycle_timer, 0);
+    }
+
+    lv_obj_t *scr = lv_screen_active();
+    lv_obj_clean(scr);
+    lv_obj_set_style_bg_color(scr, lv_color_black(), 0);
+
+    s_history_img = lv_image_create(scr);
+    place_image_area(s_history_img);
+    lv_obj_add_flag(s_history_img, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_add_event_cb(s_history_img, history_event_cb, LV_EVENT_SHORT_CLICKED, NULL);
+    lv_obj_add_event_cb(s_history_img, history_event_cb, LV_EVENT_LONG_PRESSED, NULL);
+    lv_obj_add_event_cb(s_history_img, touch_event_cb, LV_EVENT_PRESSED, NULL);
+
+    s_history_slider = lv_slider_create(scr);
+#if DISPLAY_ROTATION
+    place_rotated(s_history_slider, BSP_LCD_V_RES / 2, 12, LV_ALIGN_BOTTOM_LEFT, 20, -14);
+#else
+    lv_obj_set_size(s_history_slider, BSP_LCD_H_RES / 2, 12);
+    lv_obj_align(s_history_slider, LV_ALIGN_BOTTOM_LEFT, 20, -14);
+#endif
+    lv_slider_set_range(s_history_slider, 0, history_player_count(s_history_player) - 1);
+    lv_obj_add_event_cb(s_history_slider, history_event_cb, LV_EVENT_VALUE_CHANGED, NULL);
+    lv_obj_add_event_cb(s_history_slider, touch_event_cb, LV_EVENT_PRESSED, NULL);
+
+    s_history_label = lv_label_create(scr);
+#if DISPLAY_ROTATION
+    place_rotated(s_history_label, BSP_LCD_V_RES / 2 - 40, CAPTION_HEIGHT, LV_ALIGN_BOTTOM_RIGHT, -20, 0);
+#else
+    lv_obj_align(s_history_label, LV_ALIGN_BOTTOM_RIGHT, -20, 0);
+#endif
+    lv_obj_set_style_text_color(s_history_label, lv_color_white(), 0);
+    lv_obj_set_style_text_align(s_history_label, LV_TEXT_ALIGN_RIGHT, 0);
+
+    s_history_playing = true;
+    s_history_last_input_us = esp_timer_get_time();
+    history_show(0);
+    s_history_timer = lv_timer_create(history_timer_cb, 1000 / HISTORY_PLAYBACK_FPS, NULL);
+}
+
+// Long-press on a cone in the rotation opens its history
+static void history_long_press_cb(lv_event_t *e)
+{
+    lv_async_call(history_enter, lv_event_get_user_data(e));
+}
+#endif
+
+#if ENABLE_PROGRESSIVE_DISPLAY
+static void progress_img_delete_cb(lv_event_t *e)
+{
+    s_progress_img = NULL;
+    s_progress_label = NULL;
+}
+
+// Same layout as the rotation view, with download progress in the caption
+static void progress_show(void)
+{
+    lv_obj_t *scr = lv_screen_active();
+    lv_obj_clean(scr);
+    lv_obj_set_style_bg_color(scr, lv_color_black(), 0);
+    lv_obj_set_style_border_width(scr, 0, 0);
+    lv_obj_set_style_pad_all(scr, 0, 0);
+
+    s_progress_img = lv_image_create(scr);
+    lv_image_set_src(s_progress_img, &s_progress_dsc);
+    lv_obj_clear_flag(s_progress_img, LV_OBJ_FLAG_SCROLLABLE);
+    place_image_area(s_progress_img);
+    lv_obj_set_style_img_opa(s_progress_img, LV_OPA_COVER, 0);
+    lv_obj_add_event_cb(s_progress_img, progress_img_delete_cb, LV_EVENT_DELETE, NULL);
+#if ENABLE_TOUCHSCREEN
+    lv_obj_add_event_cb(s_progress_img, touch_event_cb, LV_EVENT_PRESSED, NULL);
+#endif
+
+    s_progress_label = lv_label_create(scr);
+    place_caption(s_progress_label);
+    lv_obj_set_style_text_color(s_progress_label, lv_color_white(), 0);
+    lv_obj_set_style_text_align(s_progress_label, LV_TEXT_ALIGN_CENTER, 0);
+}
+
+// Set up the stream once the header (and palette) has arrived. Returns false
+// if the slot cannot be shown before it is processed.
+static bool progress_start(image_data_t *img_data)
+{
+    const uint8_t *buf = (const uint8_t *)img_data->buffer;
+    uint8_t cf = buf[1];
+    uint16_t width = *(const uint16_t *)(buf + 4);
+    uint16_t height = *(const uint16_t *)(buf + 6);
+
+    // JPEG, compressed and non-native slots only exist as RGB565 after processing,
+    // and in portrait rows only line up with the screen once the slot is rotated
+    if (DISPLAY_ROTATION != 0 || buf[0] != LVGL_MAGIC_NUMBER || (*(const uint16_t *)(buf + 2) & LV_IMAGE_FLAGS_COMPRESSED) ||
+        (cf != LV_COLOR_FORMAT_RGB565 && !image_codec_is_indexed(cf)) ||
+        width == 0 || height == 0 || width > SLOT_DECODER_MAX_WIDTH) {
+        return false;
+    }
+
+    size_t palette_entries = image_codec_palette_entries(cf);
+    s_progress_offset = IMAGE_HEADER_SIZE + palette_entries * PALETTE_ENTRY_SIZE;
+    if (img_data->buffer_size < s_progress_offset) {
+        return true;    // Wait for the rest of the palette
+    }
+
+    if (image_codec_is_indexed(cf)) {
+        // Built into the slot, so processing reuses the allocation
+        if (img_data->palette_lut == NULL) {
+            img_data->palette_lut = heap_caps_malloc(256 * sizeof(uint16_t), MALLOC_CAP_INTERNAL);
+        }
+        if (img_data->palette_lut == NULL) {
+            return false;
+        }
+        image_codec_build_palette_lut(buf + IMAGE_HEADER_SIZE, palette_entries, img_data->palette_lut);
+        lv_image_dsc_t indexed = {
+            .header = { .cf = cf, .w = width, .h = height },
+            .data = buf + IMAGE_HEADER_SIZE,
+        };
+        slot_stream_init_indexed(&s_progress_stream, &indexed, img_data->palette_lut);
+        s_progress_stream.rows_ready = 0;
+    } else {
+        slot_stream_init_raw(&s_progress_stream, buf + IMAGE_HEADER_SIZE, width, height);
+    }
+    slot_decoder_make_dsc(&s_progress_stream, &s_progress_dsc);
+    s_progress_started = true;
+
+    lvgl_port_lock(0);
+    if (!s_history_active) {
+        progress_show();
+    }
+    lvgl_port_unlock();
+    return true;
+}
+
+// Called from the image HTTP event handler after each chunk is stored
+void image_download_progress(int image_index)
+{
+    if (image_index != s_progress_index) {
+        return;
+    }
+
+    image_data_t *img_data = &s_images[image_index];
+    if (img_data->buffer == NULL || img_data->buffer_size < IMAGE_HEADER_SIZE) {
+        return;
+    }
+
+    if (!s_progress_started) {
+        if (!progress_start(img_data)) {
+            s_progress_index = -1;
+            return;
+        }
+        if (!s_progress_started) {
+            return;
+        }
+    }
+
+    size_t received = img_data->buffer_size - s_progress_offset;
+    uint16_t rows = LV_MIN(received / s_progress_stream.stride, s_progress_stream.height);
+
+    // Redraw a band at a time rather than on every network chunk
+    if (rows < s_progress_stream.height && rows - s_progress_stream.rows_ready < SLOT_BAND_ROWS) {
+        return;
+    }
+
+    lvgl_port_lock(0);
+    if (s_progress_img == NULL) {
+        // The screen moved on (history view); stop tracking this download
+        s_progress_index = -1;
+    } else if (rows > s_progress_stream.rows_ready) {
+        // The image is centred in its object, so rows map to a fixed screen offset
+        lv_area_t coords;
+        lv_obj_get_coords(s_progress_img, &coords);
+        int32_t top = coords.y1 + (lv_area_get_height(&coords) - s_progress_stream.height) / 2;
+        lv_area_t band = {
+            .x1 = coords.x1,
+            .x2 = coords.x2,
+            .y1 = top + s_progress_stream.rows_ready,
+            .y2 = top + rows - 1,
+        };
+        s_progress_stream.rows_ready = rows;
+        lv_obj_invalidate_area(s_progress_img, &band);
+        boot_profile_mark_next_frame(BOOT_PHASE_FIRST_PIXEL);
+
+        const char *name = (image_index < active_image_count && image_names[image_index] != NULL) ?
+                           image_names[image_index] : "Hurricane Tracking Image";
+        lv_label_set_text_fmt(s_progress_label, "%s\nDownloading... %d%%", name,
+                              rows * 100 / s_progress_stream.height);
+    }
+    lvgl_port_unlock();
+}
+
+// True while the progressive view owns the screen; the display task skips rotations
+static bool progress_active(void)
+{
+    return s_progress_index >= 0 && s_progress_started;
+}
+#endif
+
+// True while the history or the progressive view owns the screen. Only
+// conclusive under the LVGL lock, since both take the screen under it.
+static bool screen_taken(void)
+{
+#if ENABLE_PROGRESSIVE_DISPLAY
+    if (progress_active()) {
+        return true;
+    }
+#endif
+    return s_history_active;
+}
+
+// Simplified display function that uses the global pointer. Returns false,
+// leaving the screen alone, if another view has taken it.
+static bool display_image_from_global_pointer(void)
+{
+    TRACE_BEGIN("display_image");
     if (s_current_display_image == NULL) {
-        ESP_LOGW(TAG, "No image to display, using error image");
+        BINLOG(BL_DISP_NO_IMAGE);
         s_current_display_image = &error_image;
     }
     
+#if ENABLE_TOUCHSCREEN && ENABLE_ADVISORY_HISTORY
+    // Looked up before taking the LVGL lock: history_count() reads flash, and
+    // waits while an advisory is being written
+    bool has_history = false;
+    for (int i = 0; i < active_image_count; i++) {
+        char storm_id[HISTORY_STORM_ID_LEN];
+        if (s_current_display_image == &s_images[i].img_dsc) {
+            has_history = history_storm_id_from_url(image_urls[i], storm_id, sizeof(storm_id)) &&
+                          history_count(storm_id) > 1;
+            break;
+        }
+    }
+#endif
+    
     lvgl_port_lock(0);
     
+    // The history view may have been built while this task waited for the
+    // lock; cleaning the screen now would delete objects its timer still uses
+    if (screen_taken()) {
+        lvgl_port_unlock();
+        TRACE_END("display_image");
+        return false;
+    }
+    
     // Clear the screen first
     lv_obj_clean(lv_screen_active());
     
@@ -581,14 +1283,27 @@ static void display_image_from_global_pointer(void)
     lv_obj_add_event_cb(img_obj, touch_event_cb, LV_EVENT_PRESSED, NULL);
 #endif
     
-    // Set the image source from global pointer
-    lv_image_set_src(img_obj, s_current_display_image);
+    // Find which image is currently being displayed
+    int current_img_idx = -1;
+    for (int i = 0; i < active_image_count; i++) {
+        if (s_images[i].is_valid && s_current_display_image == &s_images[i].img_dsc) {
+            current_img_idx = i;
+            break;
+        }
+    }
+    
+    // Set the image source from global pointer (through the slot decoder if indexed or compressed)
+    lv_image_set_src(img_obj, current_img_idx >= 0 ? slot_display_image(current_img_idx) : s_current_display_image);
     
     // Configure image display
     lv_obj_clear_flag(img_obj, LV_OBJ_FLAG_SCROLLABLE);
-    lv_obj_set_align(img_obj, LV_ALIGN_TOP_MID);
-    lv_obj_set_pos(img_obj, 0, 0);
-    lv_obj_set_size(img_obj, BSP_LCD_H_RES, BSP_LCD_V_RES - 40);
+    place_image_area(img_obj);
+#if DISPLAY_ROTATION
+    // Slots are rotated at load time; the small built-in error image is turned while drawing
+    if (s_current_display_image == &error_image) {
+        lv_image_set_rotation(img_obj, DISPLAY_ROTATION * 10);
+    }
+#endif
     
     lv_obj_set_style_img_recolor_opa(img_obj, LV_OPA_TRANSP, 0);
     lv_obj_set_style_img_opa(img_obj, LV_OPA_COVER, 0);
@@ -602,52 +1317,78 @@ static void display_image_from_global_pointer(void)
     lv_obj_t *timestamp = lv_label_create(cont);
     
     // Get timestamp info
-    char time_str[128];
+    char time_str[160];
     time_t display_timestamp;
     struct tm timeinfo;
     
-    // Find which image is currently being displayed
-    int current_img_idx = -1;
-    for (int i = 0; i < active_image_count; i++) {
-        if (s_images[i].is_valid && s_current_display_image == &s_images[i].img_dsc) {
-            current_img_idx = i;
-            break;
-        }
-    }
-    
     // Use the download timestamp from the image, or current time as fallback
     if (current_img_idx >= 0 && s_images[current_img_idx].download_timestamp > 0) {
         display_timestamp = s_images[current_img_idx].download_timestamp;
-        ESP_LOGD(TAG, "Using stored timestamp for image %d", current_img_idx);
+        BINLOG(BL_DISP_TIMESTAMP, current_img_idx, 1);
     } else {
         // Fallback to current time if no stored timestamp available (error image case)
         time(&display_timestamp);
-        ESP_LOGD(TAG, "Using current time as fallback timestamp");
+        BINLOG(BL_DISP_TIMESTAMP, current_img_idx, 0);
     }
     
     gmtime_r(&display_timestamp, &timeinfo);  // Use UTC time for consistency
     
+    // Offer the history view for cones with more than one stored advisory
+    const char *history_hint = "";
+#if ENABLE_TOUCHSCREEN && ENABLE_ADVISORY_HISTORY
+    if (current_img_idx >= 0 && has_history) {
+        history_hint = " (hold for history)";
+        lv_obj_add_flag(img_obj, LV_OBJ_FLAG_CLICKABLE);
+        lv_obj_add_event_cb(img_obj, history_long_press_cb, LV_EVENT_LONG_PRESSED,
+                            (void *)(intptr_t)current_img_idx);
+    }
+#endif
+    
+    // Time from NHC publication to this screen; flag advisories that took too long
+    char stale_str[32] = "";
+    bool stale = false;
+    if (current_img_idx >= 0) {
+        freshness_product_t product = current_img_idx < STATIC_IMAGE_COUNT ? FRESHNESS_PRODUCT_OUTLOOK
+                                                                           : FRESHNESS_PRODUCT_CONE;
+        int32_t delay_s;
+        stale = freshness_slot_shown(product, current_img_idx, s_images[current_img_idx].pub_date, &delay_s);
+        if (stale) {
+            snprintf(stale_str, sizeof(stale_str), "  STALE +%ldh%02ldm",
+                     delay_s / 3600, (delay_s / 60) % 60);
+        } else if (s_images[current_img_idx].refresh_missed) {
+            // The last update ran out of time before refreshing this one
+            stale = true;
+            snprintf(stale_str, sizeof(stale_str), "  STALE (timed out)");
+        }
+    }
+    
     // Format timestamp with dynamic image name
     if (current_img_idx >= 0 && current_img_idx < active_image_count && image_names[current_img_idx] != NULL) {
-        snprintf(time_str, sizeof(time_str), "%s\nLast updated: %04d-%02d-%02d %02d:%02d:%02d UTC", 
-                    image_names[current_img_idx], 
+        snprintf(time_str, sizeof(time_str), "%s%s\nLast updated: %04d-%02d-%02d %02d:%02d:%02d UTC%s", 
+                    image_names[current_img_idx], history_hint,
                     timeinfo.tm_year + 1900, timeinfo.tm_mon + 1, timeinfo.tm_mday,
-                    timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
+                    timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec, stale_str);
     } else {
         // Fallback if no name is available
-        snprintf(time_str, sizeof(time_str), "Hurricane Tracking Image\nLast updated: %04d-%02d-%02d %02d:%02d:%02d UTC", 
+        snprintf(time_str, sizeof(time_str), "Hurricane Tracking Image\nLast updated: %04d-%02d-%02d %02d:%02d:%02d UTC%s", 
                     timeinfo.tm_year + 1900, timeinfo.tm_mon + 1, timeinfo.tm_mday,
-                    timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
+                    timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec, stale_str);
     }
     
     if (current_img_idx >= 0 || active_image_count == 0) {
     
         lv_label_set_text(timestamp, time_str);
-        lv_obj_align(timestamp, LV_ALIGN_BOTTOM_MID, 0, 0);
-        lv_obj_set_style_text_color(timestamp, lv_color_white(), 0);
+        place_caption(timestamp);
+        lv_obj_set_style_text_color(timestamp, stale ? lv_palette_main(LV_PALETTE_ORANGE) : lv_color_white(), 0);
         lv_obj_set_style_text_align(timestamp, LV_TEXT_ALIGN_CENTER, 0);
     }
+    if (current_img_idx >= 0) {
+        boot_profile_mark_next_frame(BOOT_PHASE_FIRST_PIXEL);
+        boot_profile_mark_next_frame(BOOT_PHASE_FIRST_SHOWN);
+    }
     lvgl_port_unlock();
+    TRACE_END("display_image");
+    return true;
 }
 
 // New display task that handles all LVGL operations
@@ -657,13 +1398,26 @@ static void display_image_task(void *pvParameters)
         // Wait for notification from timer or update task
         if (ulTaskNotifyTake(pdTRUE, portMAX_DELAY) > 0) {
             
+            // The history view owns the screen until it exits
+            if (s_history_active) {
+                continue;
+            }
+#if ENABLE_PROGRESSIVE_DISPLAY
+            // The first slot is still on screen as it downloads
+            if (progress_active()) {
+                continue;
+            }
+#endif
+            
             // Update the global pointer to the current valid image
             s_current_display_image = get_next_valid_image();
             
-            ESP_LOGI(TAG, "Displaying image %d", s_current_image_index);
+            BINLOG(BL_DISP_SHOW, s_current_image_index);
             
             // Now do the actual display work with the global pointer
-            display_image_from_global_pointer();
+            if (!display_image_from_global_pointer()) {
+                continue;
+            }
             
             // Move to next image for next cycle (after displaying current one)
             int images_to_cycle = (active_image_count > 0) ? active_image_count : MAX_IMAGES;
@@ -672,100 +1426,456 @@ static void display_image_task(void *pvParameters)
     }
 }
 
+#if ENABLE_ADVISORY_HISTORY
+// Keep a processed cone in its storm's history; indexed slots are expanded first
+static void record_advisory_history(int image_index)
+{
+    char storm_id[HISTORY_STORM_ID_LEN];
+    image_data_t *img_data = &s_images[image_index];
+    if (!storage_is_mounted() || image_index >= active_image_count ||
+        !history_storm_id_from_url(image_urls[image_index], storm_id, sizeof(storm_id))) {
+        return;
+    }
+
+    if (!image_codec_is_indexed(img_data->img_dsc.header.cf)) {
+        history_record(storm_id, &img_data->img_dsc, img_data->download_timestamp);
+        return;
+    }
+
+    size_t frame_size = (size_t)img_data->img_dsc.header.w * img_data->img_dsc.header.h * sizeof(uint16_t);
+    uint16_t *frame = heap_caps_malloc(frame_size, MALLOC_CAP_SPIRAM);
+    if (frame == NULL) {
+        ESP_LOGW(TAG, "No memory to record history for image %d", image_index);
+        return;
+    }
+    image_codec_expand_indexed(&img_data->img_dsc, img_data->palette_lut, frame);
+    lv_image_dsc_t rgb = {
+        .header = {
+            .magic = LV_IMAGE_HEADER_MAGIC,
+            .cf = LV_COLOR_FORMAT_RGB565,
+            .w = img_data->img_dsc.header.w,
+            .h = img_data->img_dsc.header.h,
+            .stride = img_data->img_dsc.header.w * sizeof(uint16_t),
+        },
+        .data_size = frame_size,
+        .data = (const uint8_t *)frame,
+    };
+    history_record(storm_id, &rgb, img_data->download_timestamp);
+    free(frame);
+}
+#endif
+
+// Start or restart the rotation from the current image
+static void restart_image_cycle_timer(void)
+{
+    if (s_image_cycle_timer != NULL) {
+        xTimerStop(s_image_cycle_timer, 0);
+        xTimerStart(s_image_cycle_timer, 0);
+        return;
+    }
+
+    // Create the image cycling timer
+    s_image_cycle_timer = xTimerCreate(
+        "image_cycle_timer",
+        pdMS_TO_TICKS(s_dwell_ms),
+        pdTRUE,  // Auto-reload timer
+        NULL,    // Timer ID
+        image_cycle_timer_callback
+    );
+
+    if (s_image_cycle_timer != NULL) {
+        xTimerStart(s_image_cycle_timer, 0);
+        ESP_LOGI(TAG, "Started image cycling timer with %lu ms interval", s_dwell_ms);
+    } else {
+        ESP_LOGE(TAG, "Failed to create image cycling timer");
+    }
+}
+
+// Download -> process -> publish pipeline. The download engine queues each slot as
+// soon as it arrives; the process task validates, hashes and publishes it while
+// the next downloads continue. PROCESS_BATCH_END closes a batch.
+#define PROCESS_BATCH_END (-1)
+
+static QueueHandle_t s_process_queue = NULL;
+static TaskHandle_t s_update_task_handle = NULL;
+
+// Updates asked for from the console, outside NHC_UPDATE_TIMES
+static SemaphoreHandle_t s_update_request = NULL;
+static volatile bool s_update_requested = false;
+static volatile bool s_feed_requested = false;
+
+// Slots that failed in the last batch are downloaded again on their own,
+// RETRY_SLOT_DELAY_MS after it and backing off on each further pass
+static atomic_uint s_failed_slots;
+static uint32_t s_retry_slots = 0;
+static int s_retry_pass = 0;
+static int64_t s_retry_at_us = 0;
+static volatile bool s_retry_batch = false;     // The batch running is a retry pass
+
+// Called on the update task, from the download engine, when a slot's transfer finishes
+static void image_download_done(int image_index, esp_err_t err, void *arg)
+{
+    if (err != ESP_OK && err != ESP_ERR_INVALID_RESPONSE) {
+        atomic_fetch_or(&s_failed_slots, 1u << image_index);
+    }
+    if (err != ESP_OK) {
+        // A slot is only replaced once a new body begins. If it still holds its
+        // previous image (skipped at the cycle deadline, breaker open, or failed
+        // before any body), keep showing it marked stale, unless the slot now
+        // holds a different product. A partial body stays for the retry pass.
+        image_data_t *img_data = &s_images[image_index];
+        const char *url = image_urls[image_index];
+        if (!img_data->is_valid) {
+            return;
+        }
+        if (url != NULL && img_data->url_crc == esp_rom_crc32_le(0, (const uint8_t *)url, strlen(url))) {
+            img_data->refresh_missed = true;
+        } else {
+            reset_image_buffer(image_index);
+        }
+        return;
+    }
+    xQueueSend(s_process_queue, &image_index, portMAX_DELAY);
+}
+
+// Validate, hash and decode one downloaded slot. Returns true if it can be shown.
+static bool process_stage(int image_index)
+{
+    image_data_t *img_data = &s_images[image_index];
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t *)img_data->buffer, img_data->buffer_size);
+    bool unchanged = img_data->payload_crc == crc;
+    img_data->payload_crc = crc;
+
+    TRACE_BEGIN("process_downloaded_image");
+    esp_err_t err = process_downloaded_image(image_index);
+    TRACE_END("process_downloaded_image");
+    if (err != ESP_OK) {
+        BINLOG(BL_IMG_PROCESS_FAILED, image_index);
+        img_data->is_valid = false;
+        return false;
+    }
+    BINLOG(BL_IMG_PROCESSED, image_index, crc, unchanged);
+    img_data->pub_date = image_pub_dates[image_index];
+    img_data->refresh_missed = false;
+    if (image_urls[image_index] != NULL) {
+        img_data->url_crc = esp_rom_crc32_le(0, (const uint8_t *)image_urls[image_index],
+                                             strlen(image_urls[image_index]));
+    }
+#if ENABLE_ADVISORY_HISTORY
+    // An identical payload decodes to the advisory already on record
+    if (!unchanged) {
+        record_advisory_history(image_index);
+    }
+#endif
+#if ENABLE_SLOT_COMPRESSION
+    compress_image_slot(image_index);
+#endif
+    return true;
+}
+
+// Make a processed slot visible. The first slot of a batch (or the one shown
+// while downloading) goes on screen at once; the rest join the rotation as
+// they become valid.
+static void publish_stage(int image_index, bool first)
+{
+    bool show = first;
+#if ENABLE_PROGRESSIVE_DISPLAY
+    if (image_index == s_progress_index) {
+        s_progress_index = -1;
+        show = true;
+    }
+#endif
+    if (!show) {
+        return;
+    }
+
+    s_current_image_index = image_index;
+    s_current_display_image = &s_images[image_index].img_dsc;
+    if (s_display_task_handle != NULL) {
+        xTaskNotifyGive(s_display_task_handle);
+    }
+    restart_image_cycle_timer();
+}
+
+static void image_process_task(void *pvParameters)
+{
+    int processed = 0;
+    int image_index;
+
+    while (1) {
+        if (xQueueReceive(s_process_queue, &image_index, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+
+        if (image_index == PROCESS_BATCH_END) {
+            // Report the batch result to the update task
+            xTaskNotify(s_update_task_handle, processed, eSetValueWithOverwrite);
+            processed = 0;
+            continue;
+        }
+
+        TRACE_BEGIN("process_stage");
+        PERF_PROBE_BEGIN(probe);
+        bool ok = process_stage(image_index);
+        PERF_PROBE_END(PERF_PROBE_IMAGE_PROCESS, probe);
+        TRACE_END("process_stage");
+        if (ok) {
+            // A retry pass only takes over the screen from the error image
+            bool first = processed == 0 && (!s_retry_batch || s_current_display_image == &error_image);
+            boot_profile_mark(BOOT_PHASE_FIRST_VALID);
+            publish_stage(image_index, first);
+            processed++;
+        }
+    }
+}
+
+// Where a slot goes in the download order of a batch
+typedef struct {
+    int slot;
+    int rank;           // 0 new cone, 1 new outlook, 2 cone, 3 outlook
+    int distance;       // Rotation steps until the slot is on screen
+    time_t shown;       // pubDate of the image the slot holds, 0 if none
+} download_rank_t;
+
+static int compare_download_rank(const void *a, const void *b)
+{
+    const download_rank_t *x = a;
+    const download_rank_t *y = b;
+    if (x->rank != y->rank) {
+        return x->rank - y->rank;
+    }
+    if (x->distance != y->distance) {
+        return x->distance - y->distance;
+    }
+    return (x->shown > y->shown) - (x->shown < y->shown);
+}
+
+// Whether the feed has something the slot is not showing yet
+static bool slot_has_new_advisory(int image_index)
+{
+    const image_data_t *img_data = &s_images[image_index];
+    const char *url = image_urls[image_index];
+    if (!img_data->is_valid || url == NULL) {
+        return true;
+    }
+    if (img_data->url_crc != esp_rom_crc32_le(0, (const uint8_t *)url, strlen(url))) {
+        return true;
+    }
+    return image_pub_dates[image_index] != 0 && image_pub_dates[image_index] != img_data->pub_date;
+}
+
+// Order the slots of a batch so that a partial failure or a cycle cut short
+// loses the least: new advisories before unchanged ones and cones before
+// outlooks, then the slot due on screen soonest, then the stalest one.
+// Returns the number of slots written to order.
+static int build_download_order(uint32_t slots, int *order)
+{
+    download_rank_t ranks[MAX_IMAGES];
+    int count = active_image_count;
+    int current = s_current_image_index < count ? s_current_image_index : -1;
+    int n = 0;
+
+    for (int i = 0; i < count; i++) {
+        if (!(slots & (1u << i))) {
+            continue;
+        }
+        download_rank_t *r = &ranks[n++];
+        r->slot = i;
+        r->rank = (slot_has_new_advisory(i) ? 0 : 2) + (i < STATIC_IMAGE_COUNT ? 1 : 0);
+        r->distance = (i - current - 1 + count) % count;
+        r->shown = s_images[i].is_valid ? s_images[i].pub_date : 0;
+    }
+    qsort(ranks, n, sizeof(ranks[0]), compare_download_rank);
+    for (int k = 0; k < n; k++) {
+        order[k] = ranks[k].slot;
+    }
+    return n;
+}
+
+// Download the given slots, most important first, and wait for the process
+// task to drain them. Returns how many became valid.
+static uint32_t download_and_process(uint32_t slots, bool show_progress)
+{
+    int order[MAX_IMAGES];
+    int count = build_download_order(slots, order);
+#if ENABLE_PROGRESSIVE_DISPLAY
+    // The slot downloaded first is the one drawn as it arrives
+    if (show_progress && count > 0) {
+        s_progress_started = false;
+        s_progress_index = order[0];
+    }
+#endif
+
+    TRACE_BEGIN("download_all");
+    http_download_images(order, count, image_download_done, NULL);
+    TRACE_END("download_all");
+    
+    TRACE_BEGIN("process_drain");
+    int batch_end = PROCESS_BATCH_END;
+    xTaskNotifyStateClear(NULL);
+    xQueueSend(s_process_queue, &batch_end, portMAX_DELAY);
+    uint32_t processed_images = 0;
+    xTaskNotifyWait(0, 0, &processed_images, portMAX_DELAY);
+    TRACE_END("process_drain");
+    return processed_images;
+}
+
+// Set up the next retry pass for the slots that failed in the batch just run
+static void schedule_slot_retry(int pass)
+{
+    uint32_t failed = atomic_exchange(&s_failed_slots, 0);
+    s_retry_slots = 0;
+    if (failed == 0) {
+        return;
+    }
+    if (pass >= RETRY_SLOT_PASSES) {
+        ESP_LOGW(TAG, "%d images still failing, left for the next update", __builtin_popcount(failed));
+        return;
+    }
+    
+    // No sooner than the conversion API breaker lets requests through
+    uint32_t delay_ms = retry_backoff_ms(RETRY_SLOT_DELAY_MS, RETRY_SLOT_DELAY_MS * 8, pass);
+    uint32_t breaker_ms = retry_host_wait_ms(RETRY_HOST_CONVERSION);
+    if (breaker_ms > delay_ms) {
+        delay_ms = breaker_ms;
+    }
+    s_retry_slots = failed;
+    s_retry_pass = pass;
+    s_retry_at_us = esp_timer_get_time() + (int64_t)delay_ms * 1000;
+    ESP_LOGI(TAG, "Retrying %d failed images in %lu s", __builtin_popcount(failed), delay_ms / 1000);
+}
+
+static void run_slot_retry(void)
+{
+    int count = __builtin_popcount(s_retry_slots);
+    ESP_LOGI(TAG, "Retry pass %d for %d images...", s_retry_pass + 1, count);
+    TRACE_BEGIN("slot_retry");
+    budget_cycle_begin();
+    s_retry_batch = true;
+    uint32_t recovered = download_and_process(s_retry_slots, false);
+    s_retry_batch = false;
+    budget_cycle_end();
+    TRACE_END("slot_retry");
+    ESP_LOGI(TAG, "Retry pass recovered %lu of %d images", recovered, count);
+    schedule_slot_retry(s_retry_pass + 1);
+    http_transfer_close_idle();
+}
+
 // Remove the old display_image function and replace the update task
 static void update_image_task(void *pvParameters)
 {
     // Flag to track if we've done an initial update
     bool initial_update_done = false;
+    time_t last_cycle = 0;
+#ifdef CONFIG_CODEC_BENCHMARK
+    bool codec_bench_done = false;
+#endif
+#ifdef CONFIG_PERF_BENCHMARK
+    bool perf_bench_done = false;
+#endif
     
     while (1) {
         bool should_update = false;
+        bool refresh_feed = true;
         
         if (!initial_update_done) {
             ESP_LOGI(TAG, "Performing initial image update...");
             should_update = true;
             initial_update_done = true;
-        } else if (is_nhc_update_time()) {
+        } else if (is_nhc_update_time(last_cycle)) {
             ESP_LOGI(TAG, "NHC update time reached, downloading images...");
             should_update = true;
+        } else if (s_update_requested) {
+            // An image refresh reuses the current URLs unless there are none yet
+            refresh_feed = s_feed_requested || active_image_count == 0;
+            s_update_requested = false;
+            s_feed_requested = false;
+            ESP_LOGI(TAG, "Update requested from the console (%s)", refresh_feed ? "feed and images" : "images only");
+            should_update = true;
         } else {
             ESP_LOGD(TAG, "Not NHC update time, skipping download");
         }
         
         if (should_update) {
             ESP_LOGI(TAG, "Starting image update cycle...");
+            TRACE_BEGIN("update_cycle");
+            time(&last_cycle);
+            budget_cycle_begin();
             
             // First, update the image URLs from the NHC XML feed
-            if (http_update_image_urls_from_xml() == ESP_OK) {
-                ESP_LOGI(TAG, "Successfully updated image URLs from XML feed");
-            } else {
-                ESP_LOGW(TAG, "Failed to update URLs from XML, using current URLs");
+            if (refresh_feed) {
+                TRACE_BEGIN("feed_update");
+                if (http_update_image_urls_from_xml() == ESP_OK) {
+                    ESP_LOGI(TAG, "Successfully updated image URLs from XML feed");
+                    boot_profile_mark(BOOT_PHASE_FEED);
+                } else {
+                    ESP_LOGW(TAG, "Failed to update URLs from XML, using current URLs");
+                }
+                TRACE_END("feed_update");
             }
             
-            // Now download images using the updated URLs
+            // Now download images using the updated URLs; each one is processed
+            // and published by the process task as soon as it arrives
             ESP_LOGI(TAG, "Downloading %d images...", active_image_count);
+            int64_t cycle_start = esp_timer_get_time();
             
-            if (http_download_all_images() == ESP_OK) {
-                ESP_LOGI(TAG, "Processing downloaded images...");
-                int processed_images = 0;
-                
-                // Process all downloaded images
-                for (int i = 0; i < MAX_IMAGES; i++) {
-                    if (s_images[i].buffer != NULL && s_images[i].buffer_size > 0) {
-                        if (process_downloaded_image(i) == ESP_OK) {
-                            processed_images++;
-                            ESP_LOGI(TAG, "Successfully processed image %d", i);
-                        } else {
-                            ESP_LOGW(TAG, "Failed to process image %d", i);
-                            s_images[i].is_valid = false;
-                        }
-                    }
+            // A full cycle covers any slots still waiting for a retry pass
+            atomic_store(&s_failed_slots, 0);
+            uint32_t processed_images = download_and_process(UINT32_MAX, true);
+#if ENABLE_PROGRESSIVE_DISPLAY
+            // The slot shown while downloading failed. Hand the screen back to
+            // the rotation even if nothing else was processed, so the partial
+            // frame gives way to the last good image (or the error image).
+            bool progress_failed = progress_active();
+            s_progress_index = -1;
+            if (progress_failed) {
+                if (s_display_task_handle != NULL) {
+                    xTaskNotifyGive(s_display_task_handle);
                 }
-                
-                if (processed_images > 0) {
-                    ESP_LOGI(TAG, "Successfully processed %d images", processed_images);
-                    
-                    // Update global pointer to first valid image
-                    s_current_display_image = get_next_valid_image();
-                    
-                    // Notify display task to show the first image immediately
-                    if (s_display_task_handle != NULL) {
-                        xTaskNotifyGive(s_display_task_handle);
-                    }
-                    
-                    // Start or restart the image cycling timer
-                    if (s_image_cycle_timer != NULL) {
-                        xTimerStop(s_image_cycle_timer, 0);
-                        xTimerStart(s_image_cycle_timer, 0);
-                    } else {
-                        // Create the image cycling timer
-                        s_image_cycle_timer = xTimerCreate(
-                            "image_cycle_timer",
-                            pdMS_TO_TICKS(IMAGE_DISPLAY_INTERVAL_MS),
-                            pdTRUE,  // Auto-reload timer
-                            NULL,    // Timer ID
-                            image_cycle_timer_callback
-                        );
-                        
-                        if (s_image_cycle_timer != NULL) {
-                            xTimerStart(s_image_cycle_timer, 0);
-                            ESP_LOGI(TAG, "Started image cycling timer with %d ms interval", IMAGE_DISPLAY_INTERVAL_MS);
-                        } else {
-                            ESP_LOGE(TAG, "Failed to create image cycling timer");
-                        }
-                    }
-                    
-                } else {
-                    ESP_LOGW(TAG, "No images were processed successfully, using error image");
-                    s_current_display_image = &error_image;
-                    if (s_display_task_handle != NULL) {
-                        xTaskNotifyGive(s_display_task_handle);
-                    }
+                restart_image_cycle_timer();
+            }
+#endif
+            
+            budget_cycle_end();
+            TRACE_END("update_cycle");
+            schedule_slot_retry(0);
+            http_transfer_close_idle();     // Next cycle is past any keep-alive timeout
+            
+            // What deferring the download and display logs saved this cycle
+            binlog_cycle_report();
+            freshness_report();
+            budget_report();
+            retry_report();
+            net_timing_report();
+            http_inflate_cycle_report();
+            if (processed_images == 0) {
+                // Nothing to show this boot; report how far it got
+                boot_profile_report(true);
+            }
+#if ENABLE_TRACE && defined(CONFIG_TRACE_DUMP_EACH_CYCLE)
+            trace_dump_serial();
+#endif
+            
+            if (processed_images > 0) {
+                ESP_LOGI(TAG, "Successfully processed %lu images in %lld ms", processed_images,
+                         (esp_timer_get_time() - cycle_start) / 1000);
+
+#ifdef CONFIG_CODEC_BENCHMARK
+                // Once per boot, on the first set of images from the feed
+                if (!codec_bench_done) {
+                    codec_bench_done = true;
+                    codec_bench_run();
                 }
-                
+#endif
+#ifdef CONFIG_PERF_BENCHMARK
+                if (!perf_bench_done) {
+                    perf_bench_done = true;
+                    perf_bench_run(lvgl_disp);
+                }
+#endif
             } else {
-                // If download fails, fall back to the error image
-                ESP_LOGW(TAG, "Image download failed, using error image");
+                // If nothing could be downloaded or processed, fall back to the error image
+                ESP_LOGW(TAG, "No images were processed successfully, using error image");
                 s_current_display_image = &error_image;
                 if (s_display_task_handle != NULL) {
                     xTaskNotifyGive(s_display_task_handle);
@@ -773,11 +1883,114 @@ static void update_image_task(void *pvParameters)
             }
         }
         
-        // Check every minute to see if it's time to update
-        vTaskDelay(pdMS_TO_TICKS(60000)); // 1 minute
+        if (!should_update && s_retry_slots != 0 && esp_timer_get_time() >= s_retry_at_us) {
+            run_slot_retry();
+        }
+        
+        // Logged once, after the first image has been drawn
+        boot_profile_report(false);
+        
+        // Check every minute to see if it's time to update, or sooner for a
+        // retry pass or if the console asks
+        uint32_t wait_ms = 60000; // 1 minute
+        if (s_retry_slots != 0) {
+            int64_t retry_in_ms = (s_retry_at_us - esp_timer_get_time()) / 1000;
+            if (retry_in_ms < wait_ms) {
+                wait_ms = retry_in_ms > 0 ? (uint32_t)retry_in_ms : 0;
+            }
+        }
+        xSemaphoreTake(s_update_request, pdMS_TO_TICKS(wait_ms));
+    }
+}
+
+// Pipeline control for the serial console (app_console.c)
+void app_request_update(bool refresh_feed)
+{
+    if (refresh_feed) {
+        s_feed_requested = true;
+    }
+    s_update_requested = true;
+    if (s_update_request != NULL) {
+        xSemaphoreGive(s_update_request);
     }
 }
 
+esp_err_t app_set_dwell_ms(uint32_t dwell_ms)
+{
+    if (dwell_ms < IMAGE_DISPLAY_MIN_INTERVAL_MS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_dwell_ms = dwell_ms;
+    if (s_image_cycle_timer != NULL) {
+        xTimerChangePeriod(s_image_cycle_timer, pdMS_TO_TICKS(dwell_ms), portMAX_DELAY);
+    }
+    return ESP_OK;
+}
+
+uint32_t app_get_dwell_ms(void)
+{
+    return s_dwell_ms;
+}
+
+// Time switching to each valid slot: rebuilding the screen plus one full render
+esp_err_t app_rotation_bench(int rounds)
+{
+    int slots[MAX_IMAGES];
+    int count = 0;
+    for (int i = 0; i < active_image_count; i++) {
+        if (s_images[i].is_valid) {
+            slots[count++] = i;
+        }
+    }
+    if (count == 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    // Hold the rotation off the screen while timing. The LVGL lock is only
+    // held for one switch at a time so touch and the LVGL task keep running;
+    // if the history or progressive view takes the screen meanwhile, stop.
+    if (s_image_cycle_timer != NULL) {
+        xTimerStop(s_image_cycle_timer, portMAX_DELAY);
+    }
+    const lv_image_dsc_t *shown = s_current_display_image;
+    uint64_t total_us = 0;
+    uint32_t max_us = 0;
+    uint32_t switches = 0;
+    bool taken = false;
+    for (int r = 0; r < rounds && !taken; r++) {
+        for (int i = 0; i < count && !taken; i++) {
+            lvgl_port_lock(0);
+            int64_t t0 = esp_timer_get_time();
+            s_current_display_image = &s_images[slots[i]].img_dsc;
+            taken = !display_image_from_global_pointer();
+            if (!taken) {
+                lv_refr_now(lvgl_disp);
+                uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+                total_us += us;
+                if (us > max_us) {
+                    max_us = us;
+                }
+                switches++;
+            }
+            lvgl_port_unlock();
+        }
+    }
+    // Put back the image the rotation was showing
+    s_current_display_image = shown;
+    if (!taken) {
+        display_image_from_global_pointer();
+    }
+    restart_image_cycle_timer();
+
+    if (taken) {
+        ESP_LOGW(TAG, "Rotation benchmark stopped after %lu switches: screen taken by another view", switches);
+        return ESP_ERR_INVALID_STATE;
+    }
+    ESP_LOGI(TAG, "Rotation benchmark: %lu switches over %d images, avg %.2f ms, max %.2f ms",
+             switches, count, total_us / 1000.0 / switches, max_us / 1000.0);
+    return ESP_OK;
+}
+
 #if ENABLE_PIR_BACKLIGHT_TIMER
 /**
  * @brief PIR monitoring task for non-touchscreen version
@@ -853,6 +2066,8 @@ static void cleanup_resources(void)
 
 void app_main(void)
 {       
+    boot_profile_init();
+    
     // Initialize NVS
     esp_err_t ret = nvs_flash_init();
     if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
@@ -860,6 +2075,7 @@ void app_main(void)
         ret = nvs_flash_init();
     }
     ESP_ERROR_CHECK(ret);
+    boot_profile_mark(BOOT_PHASE_NVS);
     
     // Initialize synchronization primitives
     backlight_mutex = xSemaphoreCreateMutex();
@@ -886,8 +2102,12 @@ void app_main(void)
         s_images[i].buffer = NULL;
         s_images[i].buffer_size = 0;
         s_images[i].buffer_allocated = 0;
+        s_images[i].palette_lut = NULL;
         s_images[i].is_valid = false;
         s_images[i].download_timestamp = 0;
+        s_images[i].pub_date = 0;
+        s_images[i].url_crc = 0;
+        s_images[i].refresh_missed = false;
         memset(&s_images[i].img_dsc, 0, sizeof(lv_img_dsc_t));
     }
     s_current_image_index = 0;
@@ -895,18 +2115,31 @@ void app_main(void)
     
     ESP_LOGI(TAG, "Initialized %d image slots", MAX_IMAGES);
     
+    // Download and display logs are recorded in a ring and printed by a low-priority task
+    if (binlog_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Deferred logging unavailable, download and display logs are dropped");
+    }
+    
+    // Pixel workers used to expand indexed images on both cores
+    if (image_codec_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Pixel workers unavailable, indexed images will expand on one core");
+    }
+    
     // Initialize LCD
     ESP_ERROR_CHECK(lcd_init(&lcd_panel));
     vTaskDelay(pdMS_TO_TICKS(100)); // Add 100ms delay
+    boot_profile_mark(BOOT_PHASE_LCD);
 
     
 #if ENABLE_TOUCHSCREEN
     ESP_ERROR_CHECK(touch_init(&my_bus, &touch_io_handle, &touch_handle));
+    boot_profile_mark(BOOT_PHASE_TOUCH);
     ESP_ERROR_CHECK(app_lvgl_init(lcd_panel, touch_handle, &lvgl_disp, &lvgl_touch_indev));
 #else
     ESP_LOGI(TAG, "Touchscreen disabled - skipping touch initialization");
     ESP_ERROR_CHECK(app_lvgl_init(lcd_panel, NULL, &lvgl_disp, &lvgl_touch_indev));
 #endif
+    boot_profile_mark(BOOT_PHASE_LVGL);
 
     // Configure backlight GPIO
     const gpio_config_t bk_light = {
@@ -988,16 +2221,54 @@ void app_main(void)
     lv_obj_add_event_cb(loading, touch_event_cb, LV_EVENT_PRESSED, NULL);
 #endif
     
+    // Indexed and compressed slots are drawn band by band by our own decoder
+    if (slot_decoder_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Slot decoder unavailable, indexed images cannot be shown");
+    }
+#if ENABLE_PERF_PROBES
+    perf_probe_init();
+    perf_probe_watch_display(lvgl_disp);
+#endif
+#if ENABLE_TRACE
+    trace_watch_display(lvgl_disp);
+#endif
+    boot_profile_watch_display(lvgl_disp);
+    
     lv_obj_t *loading_label = lv_label_create(loading);
     lv_label_set_text(loading_label, "Loading images...");
+#if DISPLAY_ROTATION
+    lv_obj_set_style_text_align(loading_label, LV_TEXT_ALIGN_CENTER, 0);
+    place_rotated(loading_label, BSP_LCD_V_RES, CAPTION_HEIGHT, LV_ALIGN_CENTER, 0, 0);
+#else
     lv_obj_center(loading_label);
+#endif
     lv_obj_set_style_text_color(loading_label, lv_color_white(), 0);
     lvgl_port_unlock();
     
+#ifdef CONFIG_STORAGE_BENCHMARK
+    // Run with the panel already scanning out so bus contention is part of the numbers
+    ESP_LOGI(TAG, "Running storage backend benchmark...");
+    if (storage_bench_run(lvgl_disp) != ESP_OK) {
+        ESP_LOGW(TAG, "Storage benchmark did not complete for every backend");
+    }
+#endif
+    
+    // Mount the storage partition; the app still runs without it
+    if (storage_init() == ESP_OK) {
+#if ENABLE_ADVISORY_HISTORY
+        if (history_init() != ESP_OK) {
+            ESP_LOGW(TAG, "Advisory history unavailable");
+        }
+#endif
+    } else {
+        ESP_LOGW(TAG, "Storage partition unavailable, advisory history disabled");
+    }
+    
     // Initialize WiFi
     ESP_LOGI(TAG, "Connecting to WiFi...");
     if (wifi_init_sta() == ESP_OK) {
         ESP_LOGI(TAG, "WiFi connected successfully");
+        boot_profile_mark(BOOT_PHASE_WIFI);
         
         // Add delay to allow network stack to fully stabilize
         // This prevents "connection reset by peer" errors on first HTTP requests
@@ -1022,6 +2293,7 @@ void app_main(void)
             ESP_LOGW(TAG, "SNTP initialization failed, time may not be accurate");
         }
 #endif
+        boot_profile_mark(BOOT_PHASE_TIME_SYNC);
         
         if (xTaskCreate(display_image_task, "display_image_task", DISPLAY_TASK_STACK_SIZE, NULL, DISPLAY_TASK_PRIORITY, &s_display_task_handle) != pdPASS) {
             ESP_LOGE(TAG, "Failed to create display task");
@@ -1040,14 +2312,28 @@ void app_main(void)
         }
 #endif
 
+        s_process_queue = xQueueCreate(MAX_IMAGES + 1, sizeof(int));
+        if (s_process_queue == NULL ||
+            xTaskCreate(image_process_task, "image_process_task", PROCESS_TASK_STACK_SIZE, NULL, PROCESS_TASK_PRIORITY, NULL) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create image process task");
+            cleanup_resources();
+            return;
+        }
+
+        s_update_request = xSemaphoreCreateBinary();
         ESP_LOGI(TAG, "Starting image refresh task...");
-        TaskHandle_t update_task_handle = NULL;
-        if (xTaskCreate(update_image_task, "update_image_task", UPDATE_TASK_STACK_SIZE, NULL, UPDATE_TASK_PRIORITY, &update_task_handle) != pdPASS) {
+        if (s_update_request == NULL || xTaskCreate(update_image_task, "update_image_task", UPDATE_TASK_STACK_SIZE, NULL, UPDATE_TASK_PRIORITY, &s_update_task_handle) != pdPASS) {
             ESP_LOGE(TAG, "Failed to create update task");
             cleanup_resources();
             return;
         }
         
+#if ENABLE_SERIAL_CONSOLE
+        if (app_console_start() != ESP_OK) {
+            ESP_LOGW(TAG, "Serial console unavailable");
+        }
+#endif
+        
         ESP_LOGI(TAG, "Application initialized successfully");
     } else {
         ESP_LOGE(TAG, "WiFi connection failed - cleaning up and exiting");
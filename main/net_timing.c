@@ -0,0 +1,131 @@
+#include "net_timing.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char TAG[] = "net_timing";
+
+typedef struct {
+    net_timing_sample_t samples[NET_TIMING_SAMPLES];    // Ring of the most recent attempts
+    uint32_t count;                                     // Attempts ever recorded
+} host_window_t;
+
+static const char *const s_phase_names[NET_PHASE_COUNT] = {
+    [NET_PHASE_DNS] = "dns",
+    [NET_PHASE_CONNECT] = "connect",
+    [NET_PHASE_TLS] = "tls",
+    [NET_PHASE_TTFB] = "ttfb",
+    [NET_PHASE_TRANSFER] = "transfer",
+};
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static host_window_t s_hosts[RETRY_HOST_COUNT];
+
+void net_timing_record(retry_host_t host, const net_timing_sample_t *sample)
+{
+    if (host >= RETRY_HOST_COUNT || sample == NULL) {
+        return;
+    }
+    host_window_t *w = &s_hosts[host];
+    portENTER_CRITICAL(&s_lock);
+    w->samples[w->count % NET_TIMING_SAMPLES] = *sample;
+    w->count++;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+static int compare_int32(const void *a, const void *b)
+{
+    int32_t x = *(const int32_t *)a;
+    int32_t y = *(const int32_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of n sorted samples
+static int32_t percentile(const int32_t *sorted, uint32_t n, uint32_t pct)
+{
+    uint32_t rank = (pct * n + 99) / 100;
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+// Histogram bucket of a duration: <1 ms, <2 ms, <4 ms ..., the last one the rest
+static int bucket_of(int32_t us)
+{
+    int bucket = 0;
+    for (int32_t limit_us = 1000; bucket < NET_TIMING_BUCKETS - 1 && us >= limit_us; limit_us *= 2) {
+        bucket++;
+    }
+    return bucket;
+}
+
+static void report_phase(const char *host, net_phase_t phase, const net_timing_sample_t *samples, uint32_t count)
+{
+    int32_t sorted[NET_TIMING_SAMPLES];
+    uint16_t hist[NET_TIMING_BUCKETS] = { 0 };
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        int32_t us = samples[i].phase_us[phase];
+        if (us >= 0) {
+            sorted[n++] = us;
+            hist[bucket_of(us)]++;
+        }
+    }
+    if (n == 0) {
+        return;
+    }
+    qsort(sorted, n, sizeof(sorted[0]), compare_int32);
+    int32_t p50 = percentile(sorted, n, 50) / 1000;
+    int32_t p90 = percentile(sorted, n, 90) / 1000;
+    int32_t max = sorted[n - 1] / 1000;
+
+    char text[NET_TIMING_BUCKETS * 4];
+    size_t len = 0;
+    for (int b = 0; b < NET_TIMING_BUCKETS && len < sizeof(text); b++) {
+        len += snprintf(text + len, sizeof(text) - len, b > 0 ? ",%u" : "%u", hist[b]);
+    }
+
+    ESP_LOGI(TAG, "%-10s %-8s over last %lu: p50 %ld ms, p90 %ld ms, max %ld ms", host, s_phase_names[phase], n,
+             p50, p90, max);
+    ESP_LOGI(TAG, "NET host=%s phase=%s n=%lu p50=%ld p90=%ld max=%ld hist=%s", host, s_phase_names[phase], n,
+             p50, p90, max, text);
+}
+
+void net_timing_report(void)
+{
+    net_timing_sample_t samples[NET_TIMING_SAMPLES];
+
+    for (int h = 0; h < RETRY_HOST_COUNT; h++) {
+        portENTER_CRITICAL(&s_lock);
+        uint32_t total = s_hosts[h].count;
+        uint32_t n = total < NET_TIMING_SAMPLES ? total : NET_TIMING_SAMPLES;
+        memcpy(samples, s_hosts[h].samples, n * sizeof(samples[0]));
+        portEXIT_CRITICAL(&s_lock);
+
+        if (n == 0) {
+            continue;
+        }
+        const char *host = retry_host_name(h);
+        for (int p = 0; p < NET_PHASE_COUNT; p++) {
+            report_phase(host, p, samples, n);
+        }
+
+        // Throughput over the transfer phase alone, so a slow server does not count against the link
+        uint64_t bytes = 0;
+        int64_t transfer_us = 0;
+        uint32_t connects = 0, handshakes = 0;
+        for (uint32_t i = 0; i < n; i++) {
+            connects += samples[i].phase_us[NET_PHASE_CONNECT] >= 0;
+            handshakes += samples[i].phase_us[NET_PHASE_TLS] >= 0;
+            if (samples[i].phase_us[NET_PHASE_TRANSFER] >= 0) {
+                bytes += samples[i].bytes;
+                transfer_us += samples[i].phase_us[NET_PHASE_TRANSFER];
+            }
+        }
+        uint32_t kbps = transfer_us > 0 ? (uint32_t)(bytes * 1000000 / 1024 / transfer_us) : 0;
+        ESP_LOGI(TAG, "%-10s %llu bytes at %lu kB/s, %lu connects, %lu TLS handshakes over last %lu (%lu total)",
+                 host, bytes, kbps, connects, handshakes, n, total);
+        ESP_LOGI(TAG, "NET host=%s n=%lu connects=%lu handshakes=%lu bytes=%llu kBps=%lu", host, n, connects,
+                 handshakes, bytes, kbps);
+    }
+}
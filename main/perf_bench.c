@@ -0,0 +1,156 @@
+#include "perf_bench.h"
+#include "perf_probe.h"
+#include "app_config.h"
+#include "http_client.h"
+#include "http_sink.h"
+#include "http_transfer.h"
+#include "storage.h"
+#include "xml_parse.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_app_desc.h"
+#include "esp_lvgl_port.h"
+#include "sdkconfig.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static const char TAG[] = "perf_bench";
+
+#ifdef CONFIG_HOT_PATH_IRAM
+#define HOT_PATH_PLACEMENT "internal RAM"
+#else
+#define HOT_PATH_PLACEMENT "flash/PSRAM"
+#endif
+
+static uint32_t bench_parse(const http_download_t *feed, int iterations)
+{
+    uint64_t total_us = 0;
+    for (int i = 0; i < iterations; i++) {
+        int count = 0;
+        int64_t t0 = esp_timer_get_time();
+        char **urls = xml_parse_all_cone_image_urls(feed->buffer, feed->buffer_size, &count);
+        total_us += esp_timer_get_time() - t0;
+        xml_parse_free_urls(urls, count);
+    }
+    return (uint32_t)(total_us / iterations);
+}
+
+// Full-screen redraw of whatever is showing, rendered synchronously
+static uint32_t bench_render(lv_display_t *disp)
+{
+    uint64_t total_us = 0;
+    for (int i = 0; i < PERF_BENCH_ITERATIONS; i++) {
+        lvgl_port_lock(0);
+        lv_obj_invalidate(lv_screen_active());
+        int64_t t0 = esp_timer_get_time();
+        lv_refr_now(disp);
+        total_us += esp_timer_get_time() - t0;
+        lvgl_port_unlock();
+    }
+    return (uint32_t)(total_us / PERF_BENCH_ITERATIONS);
+}
+
+esp_err_t perf_bench_run(lv_display_t *disp)
+{
+    http_download_t feed;
+    esp_err_t err = http_download_xml_feed(NHC_XML_FEED_URL, &feed);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Feed download failed: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    perf_probe_reset();
+    uint32_t parse_us = bench_parse(&feed, PERF_BENCH_ITERATIONS);
+    uint32_t render_us = disp != NULL ? bench_render(disp) : 0;
+
+    const esp_app_desc_t *app = esp_app_get_description();
+    ESP_LOGI(TAG, "Hot-path benchmark, firmware %s (%s %s), hot paths in " HOT_PATH_PLACEMENT,
+             app->version, app->date, app->time);
+    ESP_LOGI(TAG, "Feed parse (%zu bytes): %.2f ms avg over %d runs", feed.buffer_size,
+             parse_us / 1000.0, PERF_BENCH_ITERATIONS);
+    if (disp != NULL) {
+        ESP_LOGI(TAG, "Full-screen render: %.2f ms avg over %d frames", render_us / 1000.0,
+                 PERF_BENCH_ITERATIONS);
+    }
+    perf_probe_report();
+
+    http_download_free(&feed);
+    return ESP_OK;
+}
+
+uint32_t perf_bench_parse(const http_download_t *feed, int iterations)
+{
+    if (iterations <= 0) {
+        return 0;
+    }
+    perf_probe_reset();
+    uint32_t us = bench_parse(feed, iterations);
+    ESP_LOGI(TAG, "Feed parse (%zu bytes): %.2f ms avg over %d runs, hot paths in " HOT_PATH_PLACEMENT,
+             feed->buffer_size, us / 1000.0, iterations);
+    perf_probe_report();
+    return us;
+}
+
+#define SINK_BENCH_FILE STORAGE_BASE_PATH "/bench_feed.xml"
+
+// Average one sink over runs downloads of the feed
+static esp_err_t bench_sink(const char *name, http_sink_t *sink, int runs)
+{
+    uint64_t total_us = 0;
+    for (int i = 0; i < runs; i++) {
+        int status_code = 0;
+        int64_t t0 = esp_timer_get_time();
+        esp_err_t err = http_transfer_get(NHC_XML_FEED_URL, sink, &status_code);
+        total_us += esp_timer_get_time() - t0;
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "%s sink: download failed: %s, status=%d", name, esp_err_to_name(err), status_code);
+            return err;
+        }
+    }
+    uint32_t us = (uint32_t)(total_us / runs);
+    uint32_t kbps = us > 0 ? (uint32_t)((uint64_t)sink->length * 1000 / us) : 0;
+    ESP_LOGI(TAG, "SINK name=%s bytes=%u ms=%.2f kBps=%lu", name, sink->length, us / 1000.0, kbps);
+    return ESP_OK;
+}
+
+esp_err_t perf_bench_sinks(int runs)
+{
+    if (runs <= 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ESP_LOGI(TAG, "Sink benchmark: feed downloaded %d times into each sink", runs);
+
+    http_download_t download = {0};
+    http_mem_sink_t mem;
+    http_mem_sink_init(&mem, &download);
+    esp_err_t err = bench_sink("mem", &mem.base, runs);
+    http_download_free(&download);
+
+    if (err == ESP_OK && storage_is_mounted()) {
+        http_file_sink_t file;
+        http_file_sink_init(&file, SINK_BENCH_FILE);
+        err = bench_sink("file", &file.base, runs);
+        remove(SINK_BENCH_FILE);
+    }
+
+    if (err == ESP_OK) {
+        http_xml_sink_t xml;
+        http_xml_sink_init(&xml);
+        err = bench_sink("xml", &xml.base, runs);
+        if (err == ESP_OK) {
+            ESP_LOGI(TAG, "xml sink: %d cone URLs", xml.url_count);
+        }
+        xml_parse_free_urls(xml.urls, xml.url_count);
+        free(xml.pub_dates);
+    }
+
+    if (err == ESP_OK) {
+        http_hash_sink_t hash;
+        http_hash_sink_init(&hash);
+        err = bench_sink("hash", &hash.base, runs);
+        if (err == ESP_OK) {
+            ESP_LOGI(TAG, "hash sink: crc32 %08lx", hash.crc);
+        }
+    }
+    return err;
+}
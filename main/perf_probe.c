@@ -0,0 +1,173 @@
+#include "perf_probe.h"
+#include "esp_log.h"
+#include "esp_cpu.h"
+#include "esp_ipc.h"
+#include "esp_clk_tree.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+#include <string.h>
+
+#if CONFIG_IDF_TARGET_ARCH_XTENSA
+#include "perfmon.h"
+#include "xtensa/xt_perf_consts.h"
+#define PERF_STALL_COUNTERS 1
+#define PERF_COUNTER_I_STALL 0
+#define PERF_COUNTER_D_STALL 1
+#else
+#define PERF_STALL_COUNTERS 0
+#endif
+
+static const char TAG[] = "perf_probe";
+
+typedef struct {
+    uint32_t calls;
+    uint64_t cycles;
+    uint32_t max_cycles;
+    uint64_t i_stall;
+    uint64_t d_stall;
+    uint32_t migrated;      // Samples dropped because the task changed core
+} probe_stats_t;
+
+static const char *const s_names[PERF_PROBE_COUNT] = {
+    [PERF_PROBE_HTTP_DATA] = "http on_data",
+    [PERF_PROBE_XML_PARSE] = "xml parse",
+    [PERF_PROBE_XML_CHAR_DATA] = "xml char_data",
+    [PERF_PROBE_IMAGE_PROCESS] = "image process",
+    [PERF_PROBE_SLOT_DECODE] = "slot decode",
+    [PERF_PROBE_LVGL_RENDER] = "lvgl render",
+};
+
+static probe_stats_t s_stats[PERF_PROBE_COUNT];
+static portMUX_TYPE s_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+#if PERF_STALL_COUNTERS
+// Runs on each core through esp_ipc; the counters are per core
+static void start_stall_counters(void *arg)
+{
+    xtensa_perfmon_stop();
+    xtensa_perfmon_init(PERF_COUNTER_I_STALL, XTPERF_CNT_I_STALL,
+                        XTPERF_MASK_I_STALL_CACHE_MISS | XTPERF_MASK_I_STALL_BUSY, 0, -1);
+    xtensa_perfmon_init(PERF_COUNTER_D_STALL, XTPERF_CNT_D_STALL,
+                        XTPERF_MASK_D_STALL_CACHE_MISS | XTPERF_MASK_D_STALL_BUSY, 0, -1);
+    xtensa_perfmon_reset(PERF_COUNTER_I_STALL);
+    xtensa_perfmon_reset(PERF_COUNTER_D_STALL);
+    xtensa_perfmon_start();
+}
+#endif
+
+esp_err_t perf_probe_init(void)
+{
+#if PERF_STALL_COUNTERS
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        esp_err_t err = esp_ipc_call_blocking(core, start_stall_counters, NULL);
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "Stall counters unavailable on core %d: %s", core, esp_err_to_name(err));
+            return ESP_OK;
+        }
+    }
+    ESP_LOGI(TAG, "Cycle and stall counters running on %d cores", portNUM_PROCESSORS);
+#else
+    ESP_LOGI(TAG, "Cycle counters only; no stall counters on this target");
+#endif
+    return ESP_OK;
+}
+
+void perf_probe_begin(perf_probe_mark_t *mark)
+{
+    mark->core = esp_cpu_get_core_id();
+#if PERF_STALL_COUNTERS
+    mark->i_stall = xtensa_perfmon_value(PERF_COUNTER_I_STALL);
+    mark->d_stall = xtensa_perfmon_value(PERF_COUNTER_D_STALL);
+#endif
+    mark->cycles = esp_cpu_get_cycle_count();
+}
+
+void perf_probe_end(perf_probe_id_t id, const perf_probe_mark_t *mark)
+{
+    uint32_t cycles = esp_cpu_get_cycle_count() - mark->cycles;
+    uint32_t i_stall = 0;
+    uint32_t d_stall = 0;
+#if PERF_STALL_COUNTERS
+    i_stall = xtensa_perfmon_value(PERF_COUNTER_I_STALL) - mark->i_stall;
+    d_stall = xtensa_perfmon_value(PERF_COUNTER_D_STALL) - mark->d_stall;
+#endif
+    if (id >= PERF_PROBE_COUNT) {
+        return;
+    }
+
+    probe_stats_t *s = &s_stats[id];
+    portENTER_CRITICAL(&s_stats_lock);
+    if (esp_cpu_get_core_id() != mark->core) {
+        // Counters are per core, so the difference is meaningless
+        s->migrated++;
+        portEXIT_CRITICAL(&s_stats_lock);
+        return;
+    }
+    s->calls++;
+    s->cycles += cycles;
+    if (cycles > s->max_cycles) {
+        s->max_cycles = cycles;
+    }
+    s->i_stall += i_stall;
+    s->d_stall += d_stall;
+    portEXIT_CRITICAL(&s_stats_lock);
+}
+
+#if ENABLE_PERF_PROBES
+static perf_probe_mark_t s_render_mark;
+
+static void render_event_cb(lv_event_t *e)
+{
+    if (lv_event_get_code(e) == LV_EVENT_RENDER_START) {
+        perf_probe_begin(&s_render_mark);
+    } else {
+        perf_probe_end(PERF_PROBE_LVGL_RENDER, &s_render_mark);
+    }
+}
+#endif
+
+void perf_probe_watch_display(lv_display_t *disp)
+{
+#if ENABLE_PERF_PROBES
+    if (disp != NULL) {
+        lv_display_add_event_cb(disp, render_event_cb, LV_EVENT_RENDER_START, NULL);
+        lv_display_add_event_cb(disp, render_event_cb, LV_EVENT_RENDER_READY, NULL);
+    }
+#endif
+}
+
+void perf_probe_reset(void)
+{
+    portENTER_CRITICAL(&s_stats_lock);
+    memset(s_stats, 0, sizeof(s_stats));
+    portEXIT_CRITICAL(&s_stats_lock);
+}
+
+void perf_probe_report(void)
+{
+    probe_stats_t stats[PERF_PROBE_COUNT];
+    portENTER_CRITICAL(&s_stats_lock);
+    memcpy(stats, s_stats, sizeof(stats));
+    portEXIT_CRITICAL(&s_stats_lock);
+
+    uint32_t cpu_hz = 0;
+    esp_clk_tree_src_get_freq_hz(SOC_MOD_CLK_CPU, ESP_CLK_TREE_SRC_FREQ_PRECISION_CACHED, &cpu_hz);
+    const double cycles_per_us = cpu_hz ? cpu_hz / 1e6 : 240.0;
+
+    ESP_LOGI(TAG, "| %-14s | %8s | %10s | %10s | %12s | %12s | %8s |",
+             "probe", "calls", "avg us", "max us", "I-stall/call", "D-stall/call", "migrated");
+    for (int i = 0; i < PERF_PROBE_COUNT; i++) {
+        const probe_stats_t *s = &stats[i];
+        if (s->calls == 0) {
+            if (s->migrated > 0) {
+                ESP_LOGI(TAG, "| %-14s | %8s | %10s | %10s | %12s | %12s | %8lu |", s_names[i],
+                         "0", "", "", "", "", s->migrated);
+            }
+            continue;
+        }
+        ESP_LOGI(TAG, "| %-14s | %8lu | %10.1f | %10.1f | %12llu | %12llu | %8lu |", s_names[i], s->calls,
+                 s->cycles / cycles_per_us / s->calls, s->max_cycles / cycles_per_us,
+                 s->i_stall / s->calls, s->d_stall / s->calls, s->migrated);
+    }
+}
@@ -0,0 +1,227 @@
+#include "retry_policy.h"
+#include "xml_parse.h"
+#include "esp_log.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <time.h>
+
+static const char TAG[] = "retry";
+
+typedef enum {
+    BREAKER_CLOSED,
+    BREAKER_OPEN,
+    BREAKER_HALF_OPEN,          // Open period over; one probe request allowed
+} breaker_state_t;
+
+typedef struct {
+    breaker_state_t state;
+    int failures;               // Transient failures in a row
+    bool probing;               // Half-open probe in flight
+    int64_t open_until_us;
+    uint32_t open_ms;           // Length of the next open period
+    uint32_t retries;           // Since boot
+    uint32_t blocked;
+    uint32_t trips;
+} breaker_t;
+
+static const char *const s_host_names[RETRY_HOST_COUNT] = {
+    [RETRY_HOST_CONVERSION] = "conversion",
+    [RETRY_HOST_NHC] = "nhc",
+    [RETRY_HOST_TIME] = "time",
+};
+
+static const char *const s_state_names[] = {
+    [BREAKER_CLOSED] = "closed",
+    [BREAKER_OPEN] = "open",
+    [BREAKER_HALF_OPEN] = "half-open",
+};
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static breaker_t s_breakers[RETRY_HOST_COUNT];
+
+const char *retry_host_name(retry_host_t host)
+{
+    return host < RETRY_HOST_COUNT ? s_host_names[host] : "?";
+}
+
+bool retry_transient(esp_err_t err, int status_code)
+{
+    if (err == ESP_ERR_NO_MEM || err == ESP_ERR_INVALID_ARG) {
+        return false;
+    }
+    if (err != ESP_OK) {
+        return true;
+    }
+    switch (status_code) {
+        case 408: case 425: case 429:
+        case 500: case 502: case 503: case 504:
+            return true;
+        default:
+            return false;
+    }
+}
+
+uint32_t retry_parse_after(const char *value)
+{
+    if (value == NULL) {
+        return 0;
+    }
+    while (isspace((unsigned char)*value)) {
+        value++;
+    }
+
+    int64_t delay_ms;
+    if (isdigit((unsigned char)*value)) {
+        delay_ms = strtoll(value, NULL, 10) * 1000;
+    } else {
+        // An HTTP date only means something once the clock is set
+        time_t at = xml_parse_date(value);
+        time_t now = time(NULL);
+        if (at == 0 || now < CLOCK_VALID_EPOCH) {
+            return 0;
+        }
+        delay_ms = at > now ? (int64_t)(at - now) * 1000 : 0;
+    }
+    if (delay_ms <= 0) {
+        return 0;
+    }
+    return delay_ms < RETRY_AFTER_MAX_MS ? (uint32_t)delay_ms : RETRY_AFTER_MAX_MS;
+}
+
+uint32_t retry_backoff_ms(uint32_t base_ms, uint32_t cap_ms, int attempt)
+{
+    uint32_t delay = base_ms;
+    for (int i = 0; i < attempt && delay < cap_ms; i++) {
+        delay *= 2;
+    }
+    if (delay > cap_ms) {
+        delay = cap_ms;
+    }
+    // Equal jitter: clients that failed together do not retry together
+    return delay / 2 + esp_random() % (delay / 2 + 1);
+}
+
+bool retry_schedule(retry_host_t host, int attempt, uint32_t retry_after_ms, int64_t deadline_us,
+                    int64_t *retry_at_us)
+{
+    uint32_t delay_ms = retry_backoff_ms(RETRY_BASE_DELAY_MS, RETRY_MAX_DELAY_MS, attempt);
+    if (retry_after_ms > delay_ms) {
+        delay_ms = retry_after_ms;
+    }
+    int64_t at = esp_timer_get_time() + (int64_t)delay_ms * 1000;
+    if (deadline_us != 0 && at >= deadline_us) {
+        return false;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    s_breakers[host].retries++;
+    portEXIT_CRITICAL(&s_lock);
+    ESP_LOGI(TAG, "Retrying %s request in %lu ms (attempt %d)", s_host_names[host], delay_ms, attempt + 2);
+    *retry_at_us = at;
+    return true;
+}
+
+bool retry_host_allow(retry_host_t host)
+{
+    breaker_t *b = &s_breakers[host];
+    int64_t now = esp_timer_get_time();
+    bool allowed = true;
+
+    portENTER_CRITICAL(&s_lock);
+    if (b->state == BREAKER_OPEN && now >= b->open_until_us) {
+        b->state = BREAKER_HALF_OPEN;
+        b->probing = false;
+    }
+    if (b->state == BREAKER_OPEN || (b->state == BREAKER_HALF_OPEN && b->probing)) {
+        b->blocked++;
+        allowed = false;
+    } else if (b->state == BREAKER_HALF_OPEN) {
+        b->probing = true;
+    }
+    portEXIT_CRITICAL(&s_lock);
+    return allowed;
+}
+
+void retry_host_release(retry_host_t host)
+{
+    portENTER_CRITICAL(&s_lock);
+    s_breakers[host].probing = false;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void retry_host_result(retry_host_t host, bool ok, uint32_t retry_after_ms)
+{
+    breaker_t *b = &s_breakers[host];
+    int64_t now = esp_timer_get_time();
+    breaker_state_t before, after;
+    uint32_t open_ms = 0;
+
+    portENTER_CRITICAL(&s_lock);
+    before = b->state;
+    if (b->open_ms == 0) {
+        b->open_ms = RETRY_BREAKER_OPEN_MS;
+    }
+    if (ok && retry_after_ms == 0) {
+        b->state = BREAKER_CLOSED;
+        b->failures = 0;
+        b->open_ms = RETRY_BREAKER_OPEN_MS;
+    } else {
+        if (!ok) {
+            b->failures++;
+        }
+        bool trip = before == BREAKER_HALF_OPEN || b->failures >= RETRY_BREAKER_FAILURES;
+        if (trip || retry_after_ms > 0) {
+            open_ms = trip ? b->open_ms : 0;
+            if (retry_after_ms > open_ms) {
+                open_ms = retry_after_ms;
+            }
+            int64_t until = now + (int64_t)open_ms * 1000;
+            if (b->state != BREAKER_OPEN || until > b->open_until_us) {
+                b->open_until_us = until;
+            }
+            b->state = BREAKER_OPEN;
+            if (trip) {
+                // Each failed probe doubles the next open period
+                b->trips++;
+                b->failures = 0;
+                b->open_ms = b->open_ms < RETRY_BREAKER_OPEN_MAX_MS / 2 ? b->open_ms * 2
+                                                                         : RETRY_BREAKER_OPEN_MAX_MS;
+            }
+        }
+    }
+    b->probing = false;
+    after = b->state;
+    portEXIT_CRITICAL(&s_lock);
+
+    if (after == BREAKER_OPEN && (before != BREAKER_OPEN || open_ms > 0)) {
+        ESP_LOGW(TAG, "%s breaker open for %lu s", s_host_names[host], open_ms / 1000);
+    } else if (after == BREAKER_CLOSED && before != BREAKER_CLOSED) {
+        ESP_LOGI(TAG, "%s breaker closed", s_host_names[host]);
+    }
+}
+
+uint32_t retry_host_wait_ms(retry_host_t host)
+{
+    breaker_t *b = &s_breakers[host];
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_lock);
+    int64_t until = b->state == BREAKER_OPEN ? b->open_until_us : 0;
+    portEXIT_CRITICAL(&s_lock);
+    return until > now ? (uint32_t)((until - now) / 1000) : 0;
+}
+
+void retry_report(void)
+{
+    for (int h = 0; h < RETRY_HOST_COUNT; h++) {
+        portENTER_CRITICAL(&s_lock);
+        breaker_t b = s_breakers[h];
+        portEXIT_CRITICAL(&s_lock);
+
+        ESP_LOGI(TAG, "RETRY host=%s state=%s retries=%lu blocked=%lu trips=%lu", s_host_names[h],
+                 s_state_names[b.state], b.retries, b.blocked, b.trips);
+    }
+}
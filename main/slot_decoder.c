@@ -0,0 +1,256 @@
+#include "slot_decoder.h"
+#include "app_config.h"
+#include "image_codec.h"
+#include "image_rle.h"
+#include "perf_probe.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char TAG[] = "slot_decoder";
+
+// Band cache in internal RAM, used only from the LVGL task. One extra row of
+// slack lets a band be handed out at a horizontal offset into the cache.
+static uint16_t *s_cache = NULL;
+static size_t s_cache_bytes = 0;
+static uint32_t s_cache_id = 0;         // Stream whose band is in the cache, 0 if none
+static int s_cache_band = -1;
+static lv_draw_buf_t s_draw_buf;
+static uint32_t s_next_id = 1;
+
+static lv_result_t slot_info_cb(lv_image_decoder_t *decoder, lv_image_decoder_dsc_t *dsc, lv_image_header_t *header)
+{
+    if (dsc->src_type != LV_IMAGE_SRC_VARIABLE) {
+        return LV_RESULT_INVALID;
+    }
+
+    const lv_image_dsc_t *img = dsc->src;
+    if (!(img->header.flags & LV_IMAGE_FLAGS_USER1) || img->data_size != sizeof(slot_stream_t)) {
+        return LV_RESULT_INVALID;
+    }
+
+    *header = img->header;
+    return LV_RESULT_OK;
+}
+
+static lv_result_t slot_open_cb(lv_image_decoder_t *decoder, lv_image_decoder_dsc_t *dsc)
+{
+    const lv_image_dsc_t *img = dsc->src;
+    dsc->user_data = (void *)img->data;
+    // Nothing is decoded up front; LVGL pulls bands through get_area_cb
+    dsc->decoded = NULL;
+    return LV_RESULT_OK;
+}
+
+static void slot_close_cb(lv_image_decoder_t *decoder, lv_image_decoder_dsc_t *dsc)
+{
+    dsc->decoded = NULL;
+    dsc->user_data = NULL;
+}
+
+static bool decode_rle_band(const slot_stream_t *stream, int band)
+{
+    if (s_cache_id == stream->id && s_cache_band == band) {
+        return true;
+    }
+
+    const uint32_t *offsets = (const uint32_t *)stream->rle;
+    int row0 = band * stream->band_rows;
+    int rows = LV_MIN(stream->band_rows, stream->height - row0);
+    size_t bytes = (size_t)rows * stream->width * sizeof(uint16_t);
+
+    size_t out = rle_decode(stream->rle + offsets[band], offsets[band + 1] - offsets[band],
+                            (uint8_t *)s_cache, bytes, 2);
+    if (out != bytes) {
+        ESP_LOGE(TAG, "Corrupt band %d in stream %lu", band, stream->id);
+        s_cache_id = 0;
+        return false;
+    }
+    s_cache_id = stream->id;
+    s_cache_band = band;
+    return true;
+}
+
+static lv_result_t slot_get_area_cb(lv_image_decoder_t *decoder, lv_image_decoder_dsc_t *dsc,
+                                    const lv_area_t *full_area, lv_area_t *decoded_area)
+{
+    const slot_stream_t *stream = dsc->user_data;
+    if (stream == NULL || s_cache == NULL) {
+        return LV_RESULT_INVALID;
+    }
+
+    int32_t y1 = (decoded_area->y1 == LV_COORD_MIN) ? full_area->y1 : decoded_area->y2 + 1;
+    if (y1 > full_area->y2) {
+        return LV_RESULT_INVALID;
+    }
+    PERF_PROBE_BEGIN(probe);
+
+    int32_t x1 = full_area->x1;
+    int32_t w = lv_area_get_width(full_area);
+    int32_t y2;
+    size_t stride;
+    uint8_t *data;
+
+    if (stream->kind == SLOT_STREAM_RLE) {
+        // Whole band decoded once; partial-width requests index into it
+        int band = y1 / stream->band_rows;
+        if (!decode_rle_band(stream, band)) {
+            PERF_PROBE_END(PERF_PROBE_SLOT_DECODE, probe);
+            return LV_RESULT_INVALID;
+        }
+        int32_t band_y1 = band * stream->band_rows;
+        y2 = LV_MIN(band_y1 + stream->band_rows - 1, full_area->y2);
+        stride = stream->width * sizeof(uint16_t);
+        data = (uint8_t *)s_cache + (y1 - band_y1) * stride + x1 * sizeof(uint16_t);
+    } else {
+        // Only the requested span of each row is converted; rows not yet received are black
+        stride = w * sizeof(uint16_t);
+        y2 = LV_MIN(y1 + SLOT_BAND_ROWS - 1, full_area->y2);
+        for (int32_t y = y1; y <= y2; y++) {
+            uint16_t *dst = s_cache + (y - y1) * w;
+            const uint8_t *row = stream->rows + (size_t)y * stream->stride;
+            if (y >= stream->rows_ready) {
+                memset(dst, 0, stride);
+            } else if (stream->kind == SLOT_STREAM_RAW) {
+                memcpy(dst, row + x1 * sizeof(uint16_t), stride);
+            } else {
+                image_codec_expand_indexed_span(row, stream->bpp, x1, w, stream->lut, dst);
+            }
+        }
+        s_cache_id = 0;
+        data = (uint8_t *)s_cache;
+    }
+
+    int32_t h = y2 - y1 + 1;
+    lv_draw_buf_init(&s_draw_buf, w, h, LV_COLOR_FORMAT_RGB565, stride, data,
+                     s_cache_bytes - (data - (uint8_t *)s_cache));
+    dsc->decoded = &s_draw_buf;
+
+    decoded_area->x1 = x1;
+    decoded_area->x2 = full_area->x2;
+    decoded_area->y1 = y1;
+    decoded_area->y2 = y2;
+    PERF_PROBE_END(PERF_PROBE_SLOT_DECODE, probe);
+    return LV_RESULT_OK;
+}
+
+esp_err_t slot_decoder_init(void)
+{
+    if (s_cache != NULL) {
+        return ESP_OK;
+    }
+
+    s_cache_bytes = (SLOT_BAND_ROWS + 1) * SLOT_DECODER_MAX_WIDTH * sizeof(uint16_t);
+    s_cache = heap_caps_malloc(s_cache_bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (s_cache == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate %u byte band cache", s_cache_bytes);
+        return ESP_ERR_NO_MEM;
+    }
+
+    lv_image_decoder_t *dec = lv_image_decoder_create();
+    if (dec == NULL) {
+        free(s_cache);
+        s_cache = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    lv_image_decoder_set_info_cb(dec, slot_info_cb);
+    lv_image_decoder_set_open_cb(dec, slot_open_cb);
+    lv_image_decoder_set_get_area_cb(dec, slot_get_area_cb);
+    lv_image_decoder_set_close_cb(dec, slot_close_cb);
+
+    ESP_LOGI(TAG, "Slot decoder registered, %d-row band cache (%u bytes internal)", SLOT_BAND_ROWS, s_cache_bytes);
+    return ESP_OK;
+}
+
+void slot_stream_init_indexed(slot_stream_t *stream, const lv_image_dsc_t *indexed, const uint16_t *lut)
+{
+    memset(stream, 0, sizeof(*stream));
+    stream->kind = SLOT_STREAM_INDEXED;
+    stream->id = s_next_id++;
+    stream->width = indexed->header.w;
+    stream->height = indexed->header.h;
+    stream->rows_ready = indexed->header.h;
+    stream->rows = indexed->data + image_codec_palette_entries(indexed->header.cf) * PALETTE_ENTRY_SIZE;
+    stream->stride = image_codec_indexed_stride(indexed->header.cf, indexed->header.w);
+    stream->bpp = image_codec_indexed_bpp(indexed->header.cf);
+    stream->lut = lut;
+}
+
+void slot_stream_init_raw(slot_stream_t *stream, const uint8_t *pixels, uint32_t width, uint32_t height)
+{
+    memset(stream, 0, sizeof(*stream));
+    stream->kind = SLOT_STREAM_RAW;
+    stream->id = s_next_id++;
+    stream->width = width;
+    stream->height = height;
+    stream->rows = pixels;
+    stream->stride = width * sizeof(uint16_t);
+}
+
+esp_err_t slot_stream_compress(slot_stream_t *stream, const uint16_t *pixels, uint32_t width, uint32_t height)
+{
+    if (width > SLOT_DECODER_MAX_WIDTH) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    const size_t raw = (size_t)width * height * sizeof(uint16_t);
+    const uint16_t bands = (height + SLOT_BAND_ROWS - 1) / SLOT_BAND_ROWS;
+    const size_t table = (bands + 1) * sizeof(uint32_t);
+    const size_t limit = raw - raw / 4;     // Not worth a decode per draw for less than 25%
+
+    uint8_t *buf = heap_caps_malloc(table + limit, MALLOC_CAP_SPIRAM);
+    if (buf == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    uint32_t *offsets = (uint32_t *)buf;
+    size_t used = table;
+    for (uint16_t band = 0; band < bands; band++) {
+        uint32_t row0 = band * SLOT_BAND_ROWS;
+        uint32_t rows = LV_MIN(SLOT_BAND_ROWS, height - row0);
+        size_t n = rle_encode((const uint8_t *)(pixels + (size_t)row0 * width), (size_t)rows * width * 2,
+                              buf + used, table + limit - used, 2);
+        if (n == 0) {
+            free(buf);
+            return ESP_ERR_INVALID_SIZE;
+        }
+        offsets[band] = used;
+        used += n;
+    }
+    offsets[bands] = used;
+
+    uint8_t *shrunk = heap_caps_realloc(buf, used, MALLOC_CAP_SPIRAM);
+    memset(stream, 0, sizeof(*stream));
+    stream->kind = SLOT_STREAM_RLE;
+    stream->id = s_next_id++;
+    stream->width = width;
+    stream->height = height;
+    stream->rows_ready = height;
+    stream->rle = shrunk != NULL ? shrunk : buf;
+    stream->rle_size = used;
+    stream->band_rows = SLOT_BAND_ROWS;
+    stream->band_count = bands;
+    return ESP_OK;
+}
+
+void slot_stream_free(slot_stream_t *stream)
+{
+    if (stream->kind == SLOT_STREAM_RLE) {
+        free(stream->rle);
+    }
+    memset(stream, 0, sizeof(*stream));
+}
+
+void slot_decoder_make_dsc(const slot_stream_t *stream, lv_image_dsc_t *dsc)
+{
+    memset(dsc, 0, sizeof(*dsc));
+    dsc->header.magic = LV_IMAGE_HEADER_MAGIC;
+    dsc->header.cf = LV_COLOR_FORMAT_RGB565;
+    dsc->header.flags = LV_IMAGE_FLAGS_USER1;
+    dsc->header.w = stream->width;
+    dsc->header.h = stream->height;
+    dsc->header.stride = stream->width * sizeof(uint16_t);
+    dsc->data = (const uint8_t *)stream;
+    dsc->data_size = sizeof(slot_stream_t);
+}
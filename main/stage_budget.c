@@ -0,0 +1,114 @@
+#include "stage_budget.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+static const char TAG[] = "budget";
+
+static const char *const s_stage_names[BUDGET_STAGE_COUNT] = {
+    [BUDGET_STAGE_FEED] = "feed",
+    [BUDGET_STAGE_IMAGE] = "image",
+    [BUDGET_STAGE_CYCLE] = "cycle",
+};
+
+static const int s_stage_budget_ms[BUDGET_STAGE_COUNT] = {
+    [BUDGET_STAGE_FEED] = BUDGET_FEED_MS,
+    [BUDGET_STAGE_IMAGE] = BUDGET_IMAGE_MS,
+    [BUDGET_STAGE_CYCLE] = BUDGET_CYCLE_MS,
+};
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static int64_t s_cycle_start_us = 0;
+static int64_t s_cycle_deadline_us = 0;     // 0 outside a cycle
+static uint32_t s_last_cycle_ms = 0;
+static uint32_t s_cycle_overruns[BUDGET_STAGE_COUNT];  // Last cycle
+static uint32_t s_total_overruns[BUDGET_STAGE_COUNT];  // Since boot
+
+// 64-bit, so read under the lock from other tasks
+static int64_t cycle_deadline(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    int64_t deadline = s_cycle_deadline_us;
+    portEXIT_CRITICAL(&s_lock);
+    return deadline;
+}
+
+void budget_cycle_begin(void)
+{
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&s_lock);
+    s_cycle_start_us = now;
+    s_cycle_deadline_us = now + (int64_t)BUDGET_CYCLE_MS * 1000;
+    for (int i = 0; i < BUDGET_STAGE_COUNT; i++) {
+        s_cycle_overruns[i] = 0;
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void budget_cycle_end(void)
+{
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&s_lock);
+    bool over = s_cycle_deadline_us != 0 && now > s_cycle_deadline_us;
+    s_last_cycle_ms = (uint32_t)((now - s_cycle_start_us) / 1000);
+    s_cycle_deadline_us = 0;
+    portEXIT_CRITICAL(&s_lock);
+    if (over) {
+        budget_overrun(BUDGET_STAGE_CYCLE, -1);
+    }
+}
+
+int64_t budget_deadline(budget_stage_t stage)
+{
+    int64_t deadline = esp_timer_get_time() + (int64_t)s_stage_budget_ms[stage] * 1000;
+    int64_t cycle = cycle_deadline();
+    return (cycle != 0 && cycle < deadline) ? cycle : deadline;
+}
+
+int budget_remaining_ms(int64_t deadline_us, int cap_ms)
+{
+    int64_t left_ms = (deadline_us - esp_timer_get_time()) / 1000;
+    if (left_ms < 1) {
+        return 1;
+    }
+    return left_ms < cap_ms ? (int)left_ms : cap_ms;
+}
+
+bool budget_cycle_expired(void)
+{
+    int64_t cycle = cycle_deadline();
+    return cycle != 0 && esp_timer_get_time() >= cycle;
+}
+
+void budget_overrun(budget_stage_t stage, int slot)
+{
+    portENTER_CRITICAL(&s_lock);
+    s_cycle_overruns[stage]++;
+    s_total_overruns[stage]++;
+    portEXIT_CRITICAL(&s_lock);
+
+    if (slot >= 0) {
+        ESP_LOGW(TAG, "%s %d over its %d ms budget, cancelled", s_stage_names[stage], slot,
+                 s_stage_budget_ms[stage]);
+    } else {
+        ESP_LOGW(TAG, "%s over its %d ms budget", s_stage_names[stage], s_stage_budget_ms[stage]);
+    }
+}
+
+void budget_report(void)
+{
+    uint32_t cycle[BUDGET_STAGE_COUNT];
+    uint32_t total[BUDGET_STAGE_COUNT];
+    portENTER_CRITICAL(&s_lock);
+    for (int i = 0; i < BUDGET_STAGE_COUNT; i++) {
+        cycle[i] = s_cycle_overruns[i];
+        total[i] = s_total_overruns[i];
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    ESP_LOGI(TAG, "Last cycle %lu ms of %d ms; overruns this cycle: feed %lu, image %lu, cycle %lu",
+             s_last_cycle_ms, BUDGET_CYCLE_MS, cycle[BUDGET_STAGE_FEED], cycle[BUDGET_STAGE_IMAGE],
+             cycle[BUDGET_STAGE_CYCLE]);
+    ESP_LOGI(TAG, "BUDGET cycle_ms=%lu feed=%lu image=%lu cycle=%lu", s_last_cycle_ms,
+             total[BUDGET_STAGE_FEED], total[BUDGET_STAGE_IMAGE], total[BUDGET_STAGE_CYCLE]);
+}
@@ -0,0 +1,39 @@
+#include "storage.h"
+#include "app_config.h"
+#include "esp_log.h"
+#include "esp_littlefs.h"
+
+static const char TAG[] = "storage";
+
+static bool s_mounted = false;
+
+esp_err_t storage_init(void)
+{
+    if (s_mounted) {
+        return ESP_OK;
+    }
+
+    const esp_vfs_littlefs_conf_t conf = {
+        .base_path = STORAGE_BASE_PATH,
+        .partition_label = STORAGE_PARTITION_LABEL,
+        .format_if_mount_failed = true,
+    };
+
+    esp_err_t err = esp_vfs_littlefs_register(&conf);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to mount LittleFS on '%s': %s", STORAGE_PARTITION_LABEL, esp_err_to_name(err));
+        return err;
+    }
+    s_mounted = true;
+
+    size_t total = 0, used = 0;
+    if (esp_littlefs_info(STORAGE_PARTITION_LABEL, &total, &used) == ESP_OK) {
+        ESP_LOGI(TAG, "Mounted %s: %zu of %zu bytes used", STORAGE_BASE_PATH, used, total);
+    }
+    return ESP_OK;
+}
+
+bool storage_is_mounted(void)
+{
+    return s_mounted;
+}
@@ -0,0 +1,456 @@
+#include "storage_bench.h"
+#include "app_config.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "esp_random.h"
+#include "esp_heap_caps.h"
+#include "esp_partition.h"
+#include "esp_spiffs.h"
+#include "esp_littlefs.h"
+#include "esp_vfs_fat.h"
+#include "wear_levelling.h"
+#include "diskio_impl.h"
+#include "diskio_wl.h"
+#include "esp_lvgl_port.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+static const char TAG[] = "storage_bench";
+
+#define BENCH_CHUNK_SIZE (16 * 1024)
+#define BENCH_READ_SIZE 4096
+#ifdef CONFIG_STORAGE_BENCHMARK_RECORDS
+#define BENCH_RECORDS CONFIG_STORAGE_BENCHMARK_RECORDS
+#else
+#define BENCH_RECORDS 4
+#endif
+
+// One row of the results table
+typedef struct {
+    const char *name;
+    bool ok;
+    float seq_write_mbps;
+    float seq_read_mbps;
+    float rand_read_per_s;      // 4 KB reads per second
+    float mmap_read_mbps;       // 0 when the backend cannot be mapped
+    float rewrite_ms;           // Overwrite of one record in place, includes GC/erase
+    float erase_4k_ms;          // Raw log only
+    float erase_64k_ms;         // Raw log only
+    float render_mean_ms;       // LVGL render time while the backend was running
+    float render_max_ms;
+    uint32_t frames;
+} bench_result_t;
+
+// LVGL render timing, updated from the LVGL task
+typedef struct {
+    int64_t start_us;
+    uint32_t frames;
+    uint64_t total_us;
+    uint32_t max_us;
+} render_stats_t;
+
+static render_stats_t s_render;
+static uint8_t *s_chunk = NULL;
+
+static void render_event_cb(lv_event_t *e)
+{
+    int64_t now = esp_timer_get_time();
+    if (lv_event_get_code(e) == LV_EVENT_RENDER_START) {
+        s_render.start_us = now;
+    } else if (s_render.start_us != 0) {
+        uint32_t elapsed = (uint32_t)(now - s_render.start_us);
+        s_render.frames++;
+        s_render.total_us += elapsed;
+        if (elapsed > s_render.max_us) {
+            s_render.max_us = elapsed;
+        }
+        s_render.start_us = 0;
+    }
+}
+
+// Invalidate the whole screen so the panel is redrawn continuously while flash is busy
+static void redraw_timer_cb(lv_timer_t *timer)
+{
+    lv_obj_invalidate(lv_screen_active());
+}
+
+static void render_stats_reset(void)
+{
+    lvgl_port_lock(0);
+    memset(&s_render, 0, sizeof(s_render));
+    lvgl_port_unlock();
+}
+
+static void render_stats_collect(bench_result_t *res)
+{
+    lvgl_port_lock(0);
+    res->frames = s_render.frames;
+    res->render_mean_ms = s_render.frames ? (s_render.total_us / 1000.0f) / s_render.frames : 0;
+    res->render_max_ms = s_render.max_us / 1000.0f;
+    lvgl_port_unlock();
+}
+
+static float mbps(size_t bytes, int64_t elapsed_us)
+{
+    return elapsed_us > 0 ? (float)bytes / (float)elapsed_us : 0;
+}
+
+/* ---- Filesystem backends (SPIFFS, LittleFS, FAT) share one VFS workload ---- */
+
+static void record_path(char *path, size_t len, int record)
+{
+    snprintf(path, len, STORAGE_BENCH_BASE_PATH "/r%02d.bin", record);
+}
+
+static esp_err_t vfs_write_record(int record)
+{
+    char path[32];
+    record_path(path, sizeof(path), record);
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        ESP_LOGE(TAG, "Failed to create %s", path);
+        return ESP_FAIL;
+    }
+    size_t remaining = STORAGE_BENCH_RECORD_SIZE;
+    while (remaining > 0) {
+        size_t n = remaining < BENCH_CHUNK_SIZE ? remaining : BENCH_CHUNK_SIZE;
+        if (write(fd, s_chunk, n) != (ssize_t)n) {
+            ESP_LOGE(TAG, "Short write to %s", path);
+            close(fd);
+            return ESP_FAIL;
+        }
+        remaining -= n;
+    }
+    fsync(fd);
+    close(fd);
+    return ESP_OK;
+}
+
+static esp_err_t bench_vfs(bench_result_t *res)
+{
+    char path[32];
+    size_t total = (size_t)STORAGE_BENCH_RECORD_SIZE * BENCH_RECORDS;
+
+    // Sequential write of every record
+    int64_t t0 = esp_timer_get_time();
+    for (int r = 0; r < BENCH_RECORDS; r++) {
+        ESP_RETURN_ON_ERROR(vfs_write_record(r), TAG, "%s: write failed", res->name);
+    }
+    res->seq_write_mbps = mbps(total, esp_timer_get_time() - t0);
+
+    // Sequential read back; a record that comes back short fails the run
+    t0 = esp_timer_get_time();
+    for (int r = 0; r < BENCH_RECORDS; r++) {
+        record_path(path, sizeof(path), r);
+        int fd = open(path, O_RDONLY);
+        ESP_RETURN_ON_FALSE(fd >= 0, ESP_FAIL, TAG, "%s: open %s failed", res->name, path);
+        size_t got = 0;
+        ssize_t n;
+        while ((n = read(fd, s_chunk, BENCH_CHUNK_SIZE)) > 0) {
+            got += n;
+        }
+        close(fd);
+        ESP_RETURN_ON_FALSE(n == 0 && got == STORAGE_BENCH_RECORD_SIZE, ESP_FAIL, TAG,
+                            "%s: read %zu of %d bytes from %s", res->name, got, STORAGE_BENCH_RECORD_SIZE, path);
+    }
+    res->seq_read_mbps = mbps(total, esp_timer_get_time() - t0);
+
+    // Random 4 KB reads spread across all records
+    int fds[BENCH_RECORDS];
+    for (int r = 0; r < BENCH_RECORDS; r++) {
+        record_path(path, sizeof(path), r);
+        fds[r] = open(path, O_RDONLY);
+    }
+    int short_reads = 0;
+    t0 = esp_timer_get_time();
+    for (int i = 0; i < STORAGE_BENCH_RANDOM_READS; i++) {
+        int r = esp_random() % BENCH_RECORDS;
+        off_t off = (esp_random() % (STORAGE_BENCH_RECORD_SIZE / BENCH_READ_SIZE)) * BENCH_READ_SIZE;
+        if (fds[r] < 0 || lseek(fds[r], off, SEEK_SET) != off ||
+            read(fds[r], s_chunk, BENCH_READ_SIZE) != BENCH_READ_SIZE) {
+            short_reads++;
+        }
+    }
+    int64_t elapsed = esp_timer_get_time() - t0;
+    res->rand_read_per_s = elapsed > 0 ? STORAGE_BENCH_RANDOM_READS * 1e6f / elapsed : 0;
+    for (int r = 0; r < BENCH_RECORDS; r++) {
+        if (fds[r] >= 0) {
+            close(fds[r]);
+        }
+    }
+    ESP_RETURN_ON_FALSE(short_reads == 0, ESP_FAIL, TAG, "%s: %d of %d random reads came back short",
+                        res->name, short_reads, STORAGE_BENCH_RANDOM_READS);
+
+    // Rewrite the first record in place; this is where GC and erase show up
+    t0 = esp_timer_get_time();
+    for (int i = 0; i < STORAGE_BENCH_REWRITES; i++) {
+        ESP_RETURN_ON_ERROR(vfs_write_record(0), TAG, "%s: rewrite failed", res->name);
+    }
+    res->rewrite_ms = (esp_timer_get_time() - t0) / 1000.0f / STORAGE_BENCH_REWRITES;
+
+    return ESP_OK;
+}
+
+static esp_err_t bench_spiffs(bench_result_t *res)
+{
+    const esp_vfs_spiffs_conf_t conf = {
+        .base_path = STORAGE_BENCH_BASE_PATH,
+        .partition_label = STORAGE_PARTITION_LABEL,
+        .max_files = BENCH_RECORDS + 1,
+        .format_if_mount_failed = true,
+    };
+    ESP_RETURN_ON_ERROR(esp_vfs_spiffs_register(&conf), TAG, "SPIFFS mount failed");
+    esp_err_t err = esp_spiffs_format(STORAGE_PARTITION_LABEL);
+    if (err == ESP_OK) {
+        err = bench_vfs(res);
+    }
+    esp_vfs_spiffs_unregister(STORAGE_PARTITION_LABEL);
+    return err;
+}
+
+static esp_err_t bench_littlefs(bench_result_t *res)
+{
+    ESP_RETURN_ON_ERROR(esp_littlefs_format(STORAGE_PARTITION_LABEL), TAG, "LittleFS format failed");
+    const esp_vfs_littlefs_conf_t conf = {
+        .base_path = STORAGE_BENCH_BASE_PATH,
+        .partition_label = STORAGE_PARTITION_LABEL,
+        .format_if_mount_failed = true,
+    };
+    ESP_RETURN_ON_ERROR(esp_vfs_littlefs_register(&conf), TAG, "LittleFS mount failed");
+    esp_err_t err = bench_vfs(res);
+    esp_vfs_littlefs_unregister(STORAGE_PARTITION_LABEL);
+    return err;
+}
+
+// The storage partition is typed spiffs, so esp_vfs_fat_spiflash_mount_rw_wl() will not
+// accept it. Mount FAT by hand on top of the wear-levelling layer instead.
+static esp_err_t bench_fat(const esp_partition_t *part, bench_result_t *res)
+{
+    wl_handle_t wl = WL_INVALID_HANDLE;
+    BYTE pdrv = 0xFF;
+    FATFS *fs = NULL;
+    char drv[3] = {0};
+    void *work = NULL;
+    esp_err_t ret = ESP_OK;
+
+    ESP_RETURN_ON_ERROR(wl_mount(part, &wl), TAG, "wl_mount failed");
+    if (ff_diskio_get_drive(&pdrv) != ESP_OK || pdrv == 0xFF) {
+        wl_unmount(wl);
+        return ESP_ERR_NO_MEM;
+    }
+    ff_diskio_register_wl_partition(pdrv, wl);
+    drv[0] = (char)('0' + pdrv);
+    drv[1] = ':';
+
+    ESP_GOTO_ON_ERROR(esp_vfs_fat_register(STORAGE_BENCH_BASE_PATH, drv, BENCH_RECORDS + 1, &fs),
+                      cleanup, TAG, "FAT VFS register failed");
+
+    work = malloc(FF_MAX_SS);
+    ESP_GOTO_ON_FALSE(work != NULL, ESP_ERR_NO_MEM, cleanup, TAG, "No memory for mkfs");
+    const MKFS_PARM opt = {(BYTE)(FM_ANY | FM_SFD), 0, 0, 0, CONFIG_WL_SECTOR_SIZE};
+    ESP_GOTO_ON_FALSE(f_mkfs(drv, &opt, work, FF_MAX_SS) == FR_OK, ESP_FAIL, cleanup, TAG, "f_mkfs failed");
+    ESP_GOTO_ON_FALSE(f_mount(fs, drv, 1) == FR_OK, ESP_FAIL, cleanup, TAG, "f_mount failed");
+
+    ret = bench_vfs(res);
+    f_mount(NULL, drv, 0);
+
+cleanup:
+    free(work);
+    esp_vfs_fat_unregister_path(STORAGE_BENCH_BASE_PATH);
+    ff_diskio_unregister(pdrv);
+    wl_unmount(wl);
+    return ret;
+}
+
+/* ---- Raw partition log: records appended back to back, sector aligned ---- */
+
+static size_t raw_record_stride(void)
+{
+    return (STORAGE_BENCH_RECORD_SIZE + SPI_FLASH_SEC_SIZE - 1) & ~(SPI_FLASH_SEC_SIZE - 1);
+}
+
+static esp_err_t raw_write_record(const esp_partition_t *part, size_t offset)
+{
+    size_t remaining = STORAGE_BENCH_RECORD_SIZE;
+    while (remaining > 0) {
+        size_t n = remaining < BENCH_CHUNK_SIZE ? remaining : BENCH_CHUNK_SIZE;
+        ESP_RETURN_ON_ERROR(esp_partition_write(part, offset, s_chunk, n), TAG, "raw write failed");
+        offset += n;
+        remaining -= n;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t bench_raw(const esp_partition_t *part, bench_result_t *res)
+{
+    size_t stride = raw_record_stride();
+    size_t log_size = stride * BENCH_RECORDS;
+    size_t total = (size_t)STORAGE_BENCH_RECORD_SIZE * BENCH_RECORDS;
+    ESP_RETURN_ON_FALSE(log_size <= part->size, ESP_ERR_INVALID_SIZE, TAG, "Log does not fit partition");
+
+    // Erase cost: single sectors, then 64 KB blocks
+    int64_t t0 = esp_timer_get_time();
+    for (int i = 0; i < 16; i++) {
+        ESP_RETURN_ON_ERROR(esp_partition_erase_range(part, i * SPI_FLASH_SEC_SIZE, SPI_FLASH_SEC_SIZE),
+                            TAG, "sector erase failed");
+    }
+    res->erase_4k_ms = (esp_timer_get_time() - t0) / 1000.0f / 16;
+
+    size_t blocks = (log_size + 0xFFFF) / 0x10000;
+    t0 = esp_timer_get_time();
+    ESP_RETURN_ON_ERROR(esp_partition_erase_range(part, 0, blocks * 0x10000), TAG, "block erase failed");
+    res->erase_64k_ms = (esp_timer_get_time() - t0) / 1000.0f / blocks;
+
+    // Append every record to the pre-erased log
+    t0 = esp_timer_get_time();
+    for (int r = 0; r < BENCH_RECORDS; r++) {
+        ESP_RETURN_ON_ERROR(raw_write_record(part, r * stride), TAG, "raw append failed");
+    }
+    res->seq_write_mbps = mbps(total, esp_timer_get_time() - t0);
+
+    t0 = esp_timer_get_time();
+    for (int r = 0; r < BENCH_RECORDS; r++) {
+        for (size_t off = 0; off < STORAGE_BENCH_RECORD_SIZE; off += BENCH_CHUNK_SIZE) {
+            size_t n = STORAGE_BENCH_RECORD_SIZE - off;
+            n = n < BENCH_CHUNK_SIZE ? n : BENCH_CHUNK_SIZE;
+            ESP_RETURN_ON_ERROR(esp_partition_read(part, r * stride + off, s_chunk, n), TAG, "raw read failed");
+        }
+    }
+    res->seq_read_mbps = mbps(total, esp_timer_get_time() - t0);
+
+    t0 = esp_timer_get_time();
+    for (int i = 0; i < STORAGE_BENCH_RANDOM_READS; i++) {
+        size_t off = (esp_random() % (log_size / BENCH_READ_SIZE)) * BENCH_READ_SIZE;
+        ESP_RETURN_ON_ERROR(esp_partition_read(part, off, s_chunk, BENCH_READ_SIZE), TAG, "raw read failed");
+    }
+    int64_t elapsed = esp_timer_get_time() - t0;
+    res->rand_read_per_s = elapsed > 0 ? STORAGE_BENCH_RANDOM_READS * 1e6f / elapsed : 0;
+
+    // mmap one record at a time and touch every word through the cache
+    int64_t mmap_us = 0;
+    for (int r = 0; r < BENCH_RECORDS; r++) {
+        const void *ptr = NULL;
+        esp_partition_mmap_handle_t handle;
+        ESP_RETURN_ON_ERROR(esp_partition_mmap(part, r * stride, stride, ESP_PARTITION_MMAP_DATA, &ptr, &handle),
+                            TAG, "mmap failed");
+        const volatile uint32_t *words = ptr;
+        uint32_t sum = 0;
+        t0 = esp_timer_get_time();
+        for (size_t i = 0; i < STORAGE_BENCH_RECORD_SIZE / sizeof(uint32_t); i++) {
+            sum += words[i];
+        }
+        mmap_us += esp_timer_get_time() - t0;
+        esp_partition_munmap(handle);
+        ESP_LOGD(TAG, "mmap checksum %08lx", sum);
+    }
+    res->mmap_read_mbps = mbps(total, mmap_us);
+
+    // Rewrite = erase the record's sectors and write it again
+    t0 = esp_timer_get_time();
+    for (int i = 0; i < STORAGE_BENCH_REWRITES; i++) {
+        ESP_RETURN_ON_ERROR(esp_partition_erase_range(part, 0, stride), TAG, "rewrite erase failed");
+        ESP_RETURN_ON_ERROR(raw_write_record(part, 0), TAG, "rewrite failed");
+    }
+    res->rewrite_ms = (esp_timer_get_time() - t0) / 1000.0f / STORAGE_BENCH_REWRITES;
+
+    return ESP_OK;
+}
+
+static void print_results(const bench_result_t *baseline, const bench_result_t *results, int count)
+{
+    ESP_LOGI(TAG, "Record size %d bytes x %d records, %d random %d-byte reads, %d rewrites",
+             STORAGE_BENCH_RECORD_SIZE, BENCH_RECORDS, STORAGE_BENCH_RANDOM_READS,
+             BENCH_READ_SIZE, STORAGE_BENCH_REWRITES);
+    ESP_LOGI(TAG, "Render with idle flash: %.2f ms mean, %.2f ms max over %lu frames",
+             baseline->render_mean_ms, baseline->render_max_ms, baseline->frames);
+    ESP_LOGI(TAG, "%-9s %8s %8s %8s %8s %10s %8s %8s %14s",
+             "backend", "wr MB/s", "rd MB/s", "4K rd/s", "mmap", "rewrite ms", "er4K ms", "er64K ms", "render ms");
+    for (int i = 0; i < count; i++) {
+        const bench_result_t *r = &results[i];
+        if (!r->ok) {
+            ESP_LOGI(TAG, "%-9s failed", r->name);
+            continue;
+        }
+        ESP_LOGI(TAG, "%-9s %8.2f %8.2f %8.0f %8.2f %10.1f %8.1f %8.1f %6.2f / %6.2f",
+                 r->name, r->seq_write_mbps, r->seq_read_mbps, r->rand_read_per_s, r->mmap_read_mbps,
+                 r->rewrite_ms, r->erase_4k_ms, r->erase_64k_ms, r->render_mean_ms, r->render_max_ms);
+    }
+}
+
+esp_err_t storage_bench_run(lv_display_t *disp)
+{
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                           ESP_PARTITION_SUBTYPE_ANY,
+                                                           STORAGE_PARTITION_LABEL);
+    if (part == NULL) {
+        ESP_LOGE(TAG, "Partition '%s' not found", STORAGE_PARTITION_LABEL);
+        return ESP_ERR_NOT_FOUND;
+    }
+    ESP_LOGI(TAG, "Benchmarking '%s' partition: %lu bytes at 0x%lx", part->label, part->size, part->address);
+
+    s_chunk = heap_caps_malloc(BENCH_CHUNK_SIZE, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (s_chunk == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate %d byte chunk buffer", BENCH_CHUNK_SIZE);
+        return ESP_ERR_NO_MEM;
+    }
+    esp_fill_random(s_chunk, BENCH_CHUNK_SIZE);
+
+    // Keep the panel busy so every backend is measured against live PSRAM traffic
+    lv_timer_t *redraw_timer = NULL;
+    if (disp != NULL) {
+        lvgl_port_lock(0);
+        lv_display_add_event_cb(disp, render_event_cb, LV_EVENT_RENDER_START, NULL);
+        lv_display_add_event_cb(disp, render_event_cb, LV_EVENT_RENDER_READY, NULL);
+        redraw_timer = lv_timer_create(redraw_timer_cb, STORAGE_BENCH_REDRAW_PERIOD_MS, NULL);
+        lvgl_port_unlock();
+    }
+
+    bench_result_t baseline = { .name = "idle" };
+    render_stats_reset();
+    vTaskDelay(pdMS_TO_TICKS(2000));
+    render_stats_collect(&baseline);
+
+    bench_result_t results[] = {
+        { .name = "raw-log" },
+        { .name = "spiffs" },
+        { .name = "littlefs" },
+        { .name = "fat-wl" },
+    };
+    const int count = sizeof(results) / sizeof(results[0]);
+    bool all_ok = true;
+
+    for (int i = 0; i < count; i++) {
+        ESP_LOGI(TAG, "Running %s...", results[i].name);
+        render_stats_reset();
+        esp_err_t err;
+        switch (i) {
+            case 0: err = bench_raw(part, &results[i]); break;
+            case 1: err = bench_spiffs(&results[i]); break;
+            case 2: err = bench_littlefs(&results[i]); break;
+            default: err = bench_fat(part, &results[i]); break;
+        }
+        render_stats_collect(&results[i]);
+        results[i].ok = (err == ESP_OK);
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "%s failed: %s", results[i].name, esp_err_to_name(err));
+            all_ok = false;
+        }
+    }
+
+    if (disp != NULL) {
+        lvgl_port_lock(0);
+        lv_timer_delete(redraw_timer);
+        lv_display_remove_event_cb_with_user_data(disp, render_event_cb, NULL);
+        lvgl_port_unlock();
+    }
+    free(s_chunk);
+    s_chunk = NULL;
+
+    print_results(&baseline, results, count);
+    return all_ok ? ESP_OK : ESP_FAIL;
+}
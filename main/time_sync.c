@@ -1,77 +1,126 @@
 #include "time_sync.h"
 #include "app_config.h"
+#include "retry_policy.h"
+#include "http_engine.h"
+#include "http_transfer.h"
 #include "esp_log.h"
 #include "esp_http_client.h"
+#include "esp_timer.h"
 #include "esp_sntp.h"
-#include "esp_crt_bundle.h"
-#include "cJSON.h"
+#include <stdlib.h>
 #include <string.h>
 #include <sys/time.h>
 #include <time.h>
 
 static const char TAG[] = "time_sync";
 
-// Generic HTTP response structure for time synchronization downloads
+#define WORLDTIME_ATTEMPTS 10
+#define WORLDTIME_BUDGET_MS 60000   // Runs before the tasks start; past this the boot goes on unsynced
+
+// WorldTimeAPI request: only "unixtime" is read from the response
 typedef struct {
-    char *buffer;
-    size_t buffer_size;
-    size_t buffer_allocated;
-} http_response_t;
+    http_transfer_t transfer;   // First, so an engine job is its request
+    http_json_sink_t sink;
+    http_json_field_t unixtime;
+} worldtime_request_t;
+
+static esp_err_t worldtime_attempt_start(http_job_t *job)
+{
+    worldtime_request_t *request = (worldtime_request_t *)job;
+    
+    // A dead time source is not worth holding up the boot for
+    if (!retry_host_allow(RETRY_HOST_TIME)) {
+        ESP_LOGW(TAG, "WorldTimeAPI breaker open, giving up");
+        return ESP_ERR_NOT_ALLOWED;
+    }
+    ESP_LOGI(TAG, "Attempting to get time from WorldTimeAPI... (%d/%d)", job->attempt + 1, WORLDTIME_ATTEMPTS);
+    
+    // Configure HTTP client
+    esp_http_client_config_t config = {
+        .url = "http://worldtimeapi.org/api/timezone/America/New_York",
+    };
+    if (http_transfer_client(&request->transfer, &config) == NULL) {
+        ESP_LOGE(TAG, "Failed to initialize HTTP client for WorldTimeAPI");
+        retry_host_release(RETRY_HOST_TIME);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
 
-static esp_err_t worldtime_http_event_handler(esp_http_client_event_t *evt)
+// Set the clock from a response; ESP_ERR_INVALID_RESPONSE if it has no usable time
+static esp_err_t worldtime_apply(worldtime_request_t *request)
 {
-    http_response_t *response = (http_response_t*)evt->user_data;
-    
-    switch (evt->event_id) {
-        case HTTP_EVENT_ERROR:
-            ESP_LOGI(TAG, "WorldTimeAPI HTTP_EVENT_ERROR");
-            break;
-        case HTTP_EVENT_ON_CONNECTED:
-            ESP_LOGI(TAG, "WorldTimeAPI HTTP_EVENT_ON_CONNECTED");
-            break;
-        case HTTP_EVENT_HEADER_SENT:
-            ESP_LOGI(TAG, "WorldTimeAPI HTTP_EVENT_HEADER_SENT");
-            break;
-        case HTTP_EVENT_ON_HEADER:
-            ESP_LOGI(TAG, "WorldTimeAPI HTTP_EVENT_ON_HEADER, key=%s, value=%s", evt->header_key, evt->header_value);
-            // Pre-allocate buffer based on content length
-            if (strcasecmp(evt->header_key, "Content-Length") == 0) {
-                size_t content_length = atoi(evt->header_value);
-                if (content_length > 0 && response->buffer == NULL) {
-                    response->buffer = malloc(content_length + 1); // +1 for null terminator
-                    response->buffer_allocated = content_length + 1;
-                    if (response->buffer == NULL) {
-                        ESP_LOGE(TAG, "Failed to allocate memory for WorldTimeAPI response");
-                        return ESP_FAIL;
-                    }
-                    response->buffer_size = 0;
-                }
-            }
-            break;
-        case HTTP_EVENT_ON_DATA:
-            ESP_LOGD(TAG, "WorldTimeAPI HTTP_EVENT_ON_DATA, len=%d", evt->data_len);
-            if (evt->data_len > 0 && response->buffer != NULL) {
-                // Ensure we don't overflow the buffer
-                if (response->buffer_size + evt->data_len < response->buffer_allocated) {
-                    memcpy(response->buffer + response->buffer_size, evt->data, evt->data_len);
-                    response->buffer_size += evt->data_len;
-                    response->buffer[response->buffer_size] = '\0'; // Null terminate
-                }
-            }
-            break;
-        case HTTP_EVENT_ON_FINISH:
-            ESP_LOGI(TAG, "WorldTimeAPI HTTP_EVENT_ON_FINISH");
-            break;
-        case HTTP_EVENT_DISCONNECTED:
-            ESP_LOGI(TAG, "WorldTimeAPI HTTP_EVENT_DISCONNECTED");
-            break;
-        case HTTP_EVENT_REDIRECT:
-            ESP_LOGI(TAG, "WorldTimeAPI HTTP_EVENT_REDIRECT");
-            break;
+    ESP_LOGI(TAG, "WorldTimeAPI response received: %zu bytes", request->sink.base.length);
+    
+    char *end = NULL;
+    long long unixtime = strtoll(request->unixtime.value, &end, 10);
+    if (!request->unixtime.found || end == request->unixtime.value) {
+        ESP_LOGE(TAG, "Failed to find 'unixtime' field in WorldTimeAPI response");
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    
+    // Get the unix timestamp
+    time_t unix_time = (time_t)unixtime;
+    ESP_LOGI(TAG, "Extracted unix timestamp: %lld", unixtime);
+    
+    // Set system time
+    struct timeval tv = {
+        .tv_sec = unix_time,
+        .tv_usec = 0
+    };
+    if (settimeofday(&tv, NULL) != 0) {
+        ESP_LOGE(TAG, "Failed to set system time");
+        return ESP_FAIL;
     }
+    ESP_LOGI(TAG, "System time set successfully via WorldTimeAPI");
+    
+    // Verify the time was set correctly
+    time_t now;
+    struct tm timeinfo;
+    time(&now);
+    localtime_r(&now, &timeinfo);
+    
+    char strftime_buf[64];
+    strftime(strftime_buf, sizeof(strftime_buf), "%c", &timeinfo);
+    ESP_LOGI(TAG, "The current date/time is: %s", strftime_buf);
     return ESP_OK;
 }
 
+static bool worldtime_attempt_end(http_job_t *job, esp_err_t err)
+{
+    worldtime_request_t *request = (worldtime_request_t *)job;
+    http_transfer_t *transfer = &request->transfer;
+    
+    // A body that is not one JSON object fails here, in the sink
+    err = http_transfer_attempt_end(transfer, err);
+    int status_code = transfer->status_code;
+    if (http_transfer_retry_fresh(transfer, err)) {
+        return true;
+    }
+    retry_host_result(RETRY_HOST_TIME, !retry_transient(err, status_code), transfer->retry_after_ms);
+    
+    if (err == ESP_OK && status_code == 200) {
+        job->err = worldtime_apply(request);
+        if (job->err == ESP_OK) {
+            return false;
+        }
+    } else {
+        ESP_LOGE(TAG, "WorldTimeAPI request failed: err=%s, status=%d", esp_err_to_name(err), status_code);
+        job->err = ESP_FAIL;
+    }
+    
+    // Back off before the next attempt, or wait as long as the server asked,
+    // unless that runs past the boot budget
+    return job->attempt < WORLDTIME_ATTEMPTS &&
+           retry_schedule(RETRY_HOST_TIME, job->attempt - 1, transfer->retry_after_ms, job->deadline_us,
+                          &job->retry_at_us);
+}
+
+static const http_job_ops_t s_worldtime_job_ops = {
+    .attempt_start = worldtime_attempt_start,
+    .attempt_end = worldtime_attempt_end,
+};
+
 // SNTP (Simple Network Time Protocol) functions for time synchronization
 static void sntp_time_sync_notification_cb(struct timeval *tv)
 {
@@ -88,113 +137,21 @@ esp_err_t initialize_worldtime_api(void)
     tzset();
     ESP_LOGI(TAG, "Timezone set to: %s", TIMEZONE_CONFIG);
     
-    http_response_t response = {0};
-    esp_err_t err = ESP_FAIL;
-    int retry = 0;
-    const int retry_count = 10;
+    worldtime_request_t request = {
+        .unixtime = { .key = "unixtime" },
+    };
+    http_json_sink_init(&request.sink, &request.unixtime, 1);
+    http_transfer_init(&request.transfer, &s_worldtime_job_ops, &request.sink.base);
+    request.transfer.job.idle_timeout_ms = 10000;
+    request.transfer.job.deadline_us = esp_timer_get_time() + (int64_t)WORLDTIME_BUDGET_MS * 1000;
+    request.transfer.host = RETRY_HOST_TIME;
     
-    while (retry < retry_count) {
-        ESP_LOGI(TAG, "Attempting to get time from WorldTimeAPI... (%d/%d)", retry + 1, retry_count);
-        
-        // Reset response buffer for each retry
-        if (response.buffer != NULL) {
-            free(response.buffer);
-            response.buffer = NULL;
-        }
-        response.buffer_size = 0;
-        response.buffer_allocated = 0;
-        
-        // Configure HTTP client
-        esp_http_client_config_t config = {
-            .url = "http://worldtimeapi.org/api/timezone/America/New_York",
-            .event_handler = worldtime_http_event_handler,
-            .user_data = &response,
-            .timeout_ms = 10000,
-        };
-        
-        esp_http_client_handle_t client = esp_http_client_init(&config);
-        if (client == NULL) {
-            ESP_LOGE(TAG, "Failed to initialize HTTP client for WorldTimeAPI");
-            retry++;
-            continue;
-        }
-        
-        // Perform HTTP GET request
-        err = esp_http_client_perform(client);
-        int status_code = esp_http_client_get_status_code(client);
-        esp_http_client_cleanup(client);
-        
-        if (err == ESP_OK && status_code == 200 && response.buffer != NULL && response.buffer_size > 0) {
-            ESP_LOGI(TAG, "WorldTimeAPI response received: %d bytes", response.buffer_size);
-            ESP_LOGD(TAG, "WorldTimeAPI JSON response: %s", response.buffer);
-            
-            // Parse JSON response
-            cJSON *json = cJSON_Parse(response.buffer);
-            if (json == NULL) {
-                ESP_LOGE(TAG, "Failed to parse WorldTimeAPI JSON response");
-                retry++;
-                continue;
-            }
-            
-            // Extract unixtime field
-            cJSON *unixtime_json = cJSON_GetObjectItem(json, "unixtime");
-            if (unixtime_json == NULL || !cJSON_IsNumber(unixtime_json)) {
-                ESP_LOGE(TAG, "Failed to find 'unixtime' field in WorldTimeAPI response");
-                cJSON_Delete(json);
-                retry++;
-                continue;
-            }
-            
-            // Get the unix timestamp
-            time_t unix_time = (time_t)cJSON_GetNumberValue(unixtime_json);
-            ESP_LOGI(TAG, "Extracted unix timestamp: %ld", unix_time);
-            
-            // Set system time
-            struct timeval tv = {
-                .tv_sec = unix_time,
-                .tv_usec = 0
-            };
-            
-            if (settimeofday(&tv, NULL) == 0) {
-                ESP_LOGI(TAG, "System time set successfully via WorldTimeAPI");
-                
-                // Verify the time was set correctly
-                time_t now;
-                struct tm timeinfo;
-                time(&now);
-                localtime_r(&now, &timeinfo);
-                
-                char strftime_buf[64];
-                strftime(strftime_buf, sizeof(strftime_buf), "%c", &timeinfo);
-                ESP_LOGI(TAG, "The current date/time is: %s", strftime_buf);
-                
-                err = ESP_OK;
-                cJSON_Delete(json);
-                break;
-            } else {
-                ESP_LOGE(TAG, "Failed to set system time");
-                cJSON_Delete(json);
-                retry++;
-                continue;
-            }
-        } else {
-            ESP_LOGE(TAG, "WorldTimeAPI request failed: err=%s, status=%d", esp_err_to_name(err), status_code);
-            retry++;
-        }
-        
-        // Wait before retry
-        if (retry < retry_count) {
-            vTaskDelay(pdMS_TO_TICKS(5000));
-        }
-    }
-    
-    // Clean up response buffer
-    if (response.buffer != NULL) {
-        free(response.buffer);
-    }
+    http_job_t *job = &request.transfer.job;
+    http_engine_run(&job, 1, 1);
+    esp_err_t err = job->err;
     
     if (err != ESP_OK) {
-        ESP_LOGW(TAG, "Failed to synchronize time with WorldTimeAPI after %d attempts", retry_count);
+        ESP_LOGW(TAG, "Failed to synchronize time with WorldTimeAPI after %d attempts", job->attempt);
     }
     
     return err;
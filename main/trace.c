@@ -0,0 +1,167 @@
+#include "trace.h"
+#include "esp_log.h"
+#include "esp_cpu.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char TAG[] = "trace";
+
+typedef struct {
+    int64_t timestamp_us;
+    const char *name;
+    TaskHandle_t task;
+    char phase;
+} trace_event_t;
+
+typedef struct {
+    TaskHandle_t task;
+    char name[configMAX_TASK_NAME_LEN];
+} trace_task_t;
+
+// Written only by its own core. head counts every event recorded, so the
+// ring holds the last TRACE_RING_EVENTS of them.
+typedef struct {
+    trace_event_t events[TRACE_RING_EVENTS];
+    uint32_t head;
+    // Names of the tasks seen on this core, copied because workers exit
+    trace_task_t tasks[TRACE_MAX_TASKS];
+    int task_count;
+} trace_ring_t;
+
+#if ENABLE_TRACE
+static trace_ring_t s_rings[portNUM_PROCESSORS];
+static volatile bool s_paused = false;
+
+static void note_task(trace_ring_t *ring, TaskHandle_t task)
+{
+    for (int i = 0; i < ring->task_count; i++) {
+        if (ring->tasks[i].task == task) {
+            return;
+        }
+    }
+    if (ring->task_count < TRACE_MAX_TASKS) {
+        trace_task_t *t = &ring->tasks[ring->task_count++];
+        t->task = task;
+        strlcpy(t->name, pcTaskGetName(task), sizeof(t->name));
+    }
+}
+
+void trace_event(const char *name, char phase)
+{
+    if (s_paused) {
+        return;
+    }
+
+    // Masking interrupts keeps this task on the core whose ring it writes
+    UBaseType_t state = portSET_INTERRUPT_MASK_FROM_ISR();
+    trace_ring_t *ring = &s_rings[esp_cpu_get_core_id()];
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    trace_event_t *ev = &ring->events[ring->head % TRACE_RING_EVENTS];
+    ev->timestamp_us = esp_timer_get_time();
+    ev->name = name;
+    ev->task = task;
+    ev->phase = phase;
+    ring->head++;
+    note_task(ring, task);
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(state);
+}
+
+static void display_event_cb(lv_event_t *e)
+{
+    switch (lv_event_get_code(e)) {
+        case LV_EVENT_RENDER_START:  trace_event("lvgl_render", 'B'); break;
+        case LV_EVENT_RENDER_READY:  trace_event("lvgl_render", 'E'); break;
+        case LV_EVENT_FLUSH_START:   trace_event("lvgl_flush", 'B'); break;
+        case LV_EVENT_FLUSH_FINISH:  trace_event("lvgl_flush", 'E'); break;
+        default: break;
+    }
+}
+#else
+void trace_event(const char *name, char phase)
+{
+}
+#endif
+
+void trace_watch_display(lv_display_t *disp)
+{
+#if ENABLE_TRACE
+    if (disp != NULL) {
+        lv_display_add_event_cb(disp, display_event_cb, LV_EVENT_RENDER_START, NULL);
+        lv_display_add_event_cb(disp, display_event_cb, LV_EVENT_RENDER_READY, NULL);
+        lv_display_add_event_cb(disp, display_event_cb, LV_EVENT_FLUSH_START, NULL);
+        lv_display_add_event_cb(disp, display_event_cb, LV_EVENT_FLUSH_FINISH, NULL);
+    }
+#endif
+}
+
+esp_err_t trace_export(trace_write_fn write, void *arg)
+{
+#if ENABLE_TRACE
+    // Let any event being recorded on the other core finish before reading
+    s_paused = true;
+    vTaskDelay(1);
+
+    char line[160];
+    int n;
+#define EMIT(...) do { \
+        n = snprintf(line, sizeof(line), __VA_ARGS__); \
+        write(line, n < (int)sizeof(line) ? n : sizeof(line) - 1, arg); \
+    } while (0)
+
+    // The process_name record goes first so every later record starts with a comma
+    EMIT("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+         "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"%s\"}}", APP_NAME);
+
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        trace_ring_t *ring = &s_rings[core];
+        for (int i = 0; i < ring->task_count; i++) {
+            EMIT(",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%" PRIuPTR ",\"args\":{\"name\":\"%s\"}}",
+                 (uintptr_t)ring->tasks[i].task, ring->tasks[i].name);
+        }
+    }
+
+    uint32_t total = 0;
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        trace_ring_t *ring = &s_rings[core];
+        uint32_t count = ring->head < TRACE_RING_EVENTS ? ring->head : TRACE_RING_EVENTS;
+        for (uint32_t k = ring->head - count; k != ring->head; k++) {
+            const trace_event_t *ev = &ring->events[k % TRACE_RING_EVENTS];
+            EMIT(",\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%" PRId64 ",\"pid\":1,\"tid\":%" PRIuPTR
+                 ",\"args\":{\"core\":%d}}", ev->name, ev->phase, ev->timestamp_us,
+                 (uintptr_t)ev->task, core);
+        }
+        total += count;
+        if (ring->head > TRACE_RING_EVENTS) {
+            ESP_LOGW(TAG, "Core %d ring wrapped, %lu oldest events lost", core, ring->head - TRACE_RING_EVENTS);
+        }
+        ring->head = 0;
+        ring->task_count = 0;
+    }
+    EMIT("\n]}\n");
+#undef EMIT
+
+    s_paused = false;
+    ESP_LOGI(TAG, "Exported %lu trace events", total);
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+static void serial_write(const char *data, size_t len, void *arg)
+{
+    fwrite(data, 1, len, stdout);
+}
+
+void trace_dump_serial(void)
+{
+    printf("=== TRACE BEGIN ===\n");
+    trace_export(serial_write, NULL);
+    fflush(stdout);
+    printf("=== TRACE END ===\n");
+}
@@ -1,5 +1,8 @@
 #include "xml_parse.h"
+#include "perf_probe.h"
+#include "trace.h"
 #include <expat.h>
+#include <stdbool.h>
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -9,7 +12,9 @@ typedef struct {
     int in_item;
     int in_title;
     int in_description;
+    int in_pub_date;
     char title[256];
+    char pub_date[64];     // RFC 822 pubDate of the current item (or of the channel)
     char *description;     // Now dynamically allocated
     size_t description_size;
     size_t description_capacity;
@@ -17,13 +22,75 @@ typedef struct {
     char **all_urls;  // Store all found URLs
     int url_count;    // Number of URLs found
     int url_capacity; // Capacity of the all_urls array
+    time_t *pub_dates;      // Parallel to all_urls when requested, 0 if an item had none
+    time_t channel_pub_date;
+    time_t outlook_pub_date;
 } ctx_t;
 
+// Parse an RSS pubDate ("Tue, 15 Oct 2024 20:51:07 GMT", "+0000" or a US zone
+// name) into UTC seconds. Returns 0 if the string is not understood.
+time_t xml_parse_date(const char *s)
+{
+    static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+    static const struct { const char *name; int offset_min; } zones[] = {
+        { "GMT", 0 }, { "UTC", 0 }, { "UT", 0 }, { "Z", 0 },
+        { "EDT", -240 }, { "EST", -300 }, { "CDT", -300 }, { "CST", -360 },
+        { "MDT", -360 }, { "MST", -420 }, { "PDT", -420 }, { "PST", -480 },
+        { "AST", -240 }, { "HST", -600 },
+    };
+
+    const char *comma = strchr(s, ',');
+    if (comma) {
+        s = comma + 1;
+    }
+
+    int day, year, hour, min, sec = 0;
+    char mon[4], zone[8] = "GMT";
+    if (sscanf(s, "%d %3s %d %d:%d:%d %7s", &day, mon, &year, &hour, &min, &sec, zone) < 5) {
+        return 0;
+    }
+    const char *m = strstr(months, mon);
+    if (m == NULL || (m - months) % 3 != 0) {
+        return 0;
+    }
+    int month = (m - months) / 3 + 1;
+    if (year < 100) {
+        year += 2000;
+    }
+
+    int offset_min = 0;
+    if (zone[0] == '+' || zone[0] == '-') {
+        int hhmm = atoi(zone + 1);
+        offset_min = (hhmm / 100) * 60 + hhmm % 100;
+        if (zone[0] == '-') {
+            offset_min = -offset_min;
+        }
+    } else {
+        for (size_t i = 0; i < sizeof(zones) / sizeof(zones[0]); i++) {
+            if (strcmp(zone, zones[i].name) == 0) {
+                offset_min = zones[i].offset_min;
+                break;
+            }
+        }
+    }
+
+    // Days since 1970-01-01 for a proleptic Gregorian date (newlib has no timegm)
+    int y = year - (month <= 2);
+    int era = (y >= 0 ? y : y - 399) / 400;
+    int yoe = y - era * 400;
+    int doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    int64_t days = (int64_t)era * 146097 + doe - 719468;
+
+    return (time_t)(days * 86400 + hour * 3600 + min * 60 + sec - offset_min * 60);
+}
+
 static void start_elem(void *data, const char *el, const char **attr) {
     ctx_t *c = data;
     if (strcmp(el, "item") == 0) {
         c->in_item = 1;
         c->title[0] = '\0';
+        c->pub_date[0] = '\0';
         
         // Initialize description buffer if not already allocated
         if (!c->description) {
@@ -40,10 +107,14 @@ static void start_elem(void *data, const char *el, const char **attr) {
         c->in_title = 1;
     } else if (c->in_item && strcmp(el, "description") == 0) {
         c->in_description = 1;
+    } else if (strcmp(el, "pubDate") == 0) {
+        // Inside an item it dates the item, otherwise the whole channel
+        c->in_pub_date = 1;
+        c->pub_date[0] = '\0';
     }
 }
 
-static void add_url_to_array(ctx_t *c, const char *url) {
+static void add_url_to_array(ctx_t *c, const char *url, time_t pub_date) {
     // Expand array if needed
     if (c->url_count >= c->url_capacity) {
         int new_capacity = c->url_capacity == 0 ? 4 : c->url_capacity * 2;
@@ -53,12 +124,23 @@ static void add_url_to_array(ctx_t *c, const char *url) {
             return;
         }
         c->all_urls = new_array;
+        if (c->pub_dates) {
+            time_t *new_dates = realloc(c->pub_dates, new_capacity * sizeof(time_t));
+            if (!new_dates) {
+                fprintf(stderr, "Memory allocation failed for pubDate array\n");
+                return;
+            }
+            c->pub_dates = new_dates;
+        }
         c->url_capacity = new_capacity;
     }
     
     // Add the URL
     c->all_urls[c->url_count] = strdup(url);
     if (c->all_urls[c->url_count]) {
+        if (c->pub_dates) {
+            c->pub_dates[c->url_count] = pub_date;
+        }
         c->url_count++;
     } else {
         fprintf(stderr, "Memory allocation failed for URL string\n");
@@ -68,6 +150,10 @@ static void add_url_to_array(ctx_t *c, const char *url) {
 static void end_elem(void *data, const char *el) {
     ctx_t *c = data;
     if (strcmp(el, "item") == 0) {
+        time_t pub_date = xml_parse_date(c->pub_date);
+        if (strstr(c->title, "Outlook") && c->outlook_pub_date == 0) {
+            c->outlook_pub_date = pub_date;
+        }
         if (strstr(c->title, "Graphics")) {
             char *p = strstr(c->description, "src=\"");
             if (p) {
@@ -84,7 +170,7 @@ static void end_elem(void *data, const char *el) {
                     
                     // For multiple URLs function
                     if (c->all_urls != NULL || c->url_capacity > 0) {
-                        add_url_to_array(c, p);
+                        add_url_to_array(c, p, pub_date);
                     }
                     
                     *q = '"';  // Restore the quote
@@ -107,10 +193,15 @@ static void end_elem(void *data, const char *el) {
         c->in_title = 0;
     } else if (strcmp(el, "description") == 0) {
         c->in_description = 0;
+    } else if (strcmp(el, "pubDate") == 0) {
+        c->in_pub_date = 0;
+        if (!c->in_item && c->channel_pub_date == 0) {
+            c->channel_pub_date = xml_parse_date(c->pub_date);
+        }
     }
 }
 
-static void char_data(void *data, const char *s, int len) {
+static void append_char_data(void *data, const char *s, int len) {
     ctx_t *c = data;
     if (c->in_title) {
         // Safely append to title with bounds checking
@@ -120,6 +211,13 @@ static void char_data(void *data, const char *s, int len) {
             size_t copy_len = (len < available) ? len : available;
             strncat(c->title, s, copy_len);
         }
+    } else if (c->in_pub_date) {
+        size_t current_len = strlen(c->pub_date);
+        size_t available = sizeof(c->pub_date) - current_len - 1;
+        if (available > 0) {
+            size_t copy_len = (len < available) ? len : available;
+            strncat(c->pub_date, s, copy_len);
+        }
     } else if (c->in_description && c->description) {
         // Safely append to description with dynamic reallocation if needed
         size_t needed = c->description_size + len + 1;  // +1 for null terminator
@@ -148,6 +246,12 @@ static void char_data(void *data, const char *s, int len) {
     }
 }
 
+static void char_data(void *data, const char *s, int len) {
+    PERF_PROBE_BEGIN(probe);
+    append_char_data(data, s, len);
+    PERF_PROBE_END(PERF_PROBE_XML_CHAR_DATA, probe);
+}
+
 void parse_feed_buffer(const char *buf, size_t len) {
     ctx_t ctx = {0};
     ctx.parser = XML_ParserCreate(NULL);
@@ -156,7 +260,10 @@ void parse_feed_buffer(const char *buf, size_t len) {
     XML_SetCharacterDataHandler(ctx.parser, char_data);
 
     // Feed the whole buffer at once
-    if (!XML_Parse(ctx.parser, buf, (int)len, 1)) {
+    TRACE_BEGIN("xml_parse");
+    enum XML_Status status = XML_Parse(ctx.parser, buf, (int)len, 1);
+    TRACE_END("xml_parse");
+    if (status != XML_STATUS_OK) {
         fprintf(stderr, "Parse error: %s\n",
                 XML_ErrorString(XML_GetErrorCode(ctx.parser)));
         // Optionally handle parse error here
@@ -181,7 +288,10 @@ char *xml_parse_cone_image_url(const char *buf, size_t len) {
     XML_SetCharacterDataHandler(ctx.parser, char_data);
 
     // Feed the whole buffer at once
-    if (!XML_Parse(ctx.parser, buf, (int)len, 1)) {
+    TRACE_BEGIN("xml_parse");
+    enum XML_Status status = XML_Parse(ctx.parser, buf, (int)len, 1);
+    TRACE_END("xml_parse");
+    if (status != XML_STATUS_OK) {
         fprintf(stderr, "Parse error: %s\n",
                 XML_ErrorString(XML_GetErrorCode(ctx.parser)));
         // Optionally handle parse error here
@@ -196,59 +306,152 @@ char *xml_parse_cone_image_url(const char *buf, size_t len) {
     return ctx.found_url;  // Caller must free this
 }
 
-char **xml_parse_all_cone_image_urls(const char *buf, size_t len, int *count) {
-    ctx_t ctx = {0};
+// Set up ctx to collect every cone URL, with pubDates if asked
+static bool cone_parser_init(ctx_t *ctx, bool want_pub_dates) {
+    memset(ctx, 0, sizeof(*ctx));
     
     // Initialize for collecting multiple URLs
-    ctx.url_capacity = 4;  // Start with capacity for 4 URLs
-    ctx.all_urls = malloc(ctx.url_capacity * sizeof(char *));
-    if (!ctx.all_urls) {
-        *count = 0;
-        return NULL;
+    ctx->url_capacity = 4;  // Start with capacity for 4 URLs
+    ctx->all_urls = malloc(ctx->url_capacity * sizeof(char *));
+    if (!ctx->all_urls) {
+        return false;
+    }
+    if (want_pub_dates) {
+        ctx->pub_dates = malloc(ctx->url_capacity * sizeof(time_t));
+        if (!ctx->pub_dates) {
+            free(ctx->all_urls);
+            return false;
+        }
     }
     
-    ctx.parser = XML_ParserCreate(NULL);
-    XML_SetUserData(ctx.parser, &ctx);
-    XML_SetElementHandler(ctx.parser, start_elem, end_elem);
-    XML_SetCharacterDataHandler(ctx.parser, char_data);
+    ctx->parser = XML_ParserCreate(NULL);
+    if (!ctx->parser) {
+        free(ctx->all_urls);
+        free(ctx->pub_dates);
+        return false;
+    }
+    XML_SetUserData(ctx->parser, ctx);
+    XML_SetElementHandler(ctx->parser, start_elem, end_elem);
+    XML_SetCharacterDataHandler(ctx->parser, char_data);
+    return true;
+}
 
-    // Feed the whole buffer at once
-    if (!XML_Parse(ctx.parser, buf, (int)len, 1)) {
-        fprintf(stderr, "Parse error: %s\n",
-                XML_ErrorString(XML_GetErrorCode(ctx.parser)));
+// Free the parser and hand over what was collected; everything is dropped if parsed_ok is false
+static char **cone_parser_finish(ctx_t *ctx, bool parsed_ok, int *count, time_t **pub_dates,
+                                 time_t *outlook_pub_date) {
+    XML_ParserFree(ctx->parser);
+    
+    // Clean up description buffer
+    if (ctx->description) {
+        free(ctx->description);
+    }
+    if (!parsed_ok) {
         // Clean up on parse error
-        xml_parse_free_urls(ctx.all_urls, ctx.url_count);
-        if (ctx.description) {
-            free(ctx.description);
-        }
-        XML_ParserFree(ctx.parser);
-        *count = 0;
+        xml_parse_free_urls(ctx->all_urls, ctx->url_count);
+        free(ctx->pub_dates);
         return NULL;
     }
-    XML_ParserFree(ctx.parser);
     
-    // Clean up description buffer
-    if (ctx.description) {
-        free(ctx.description);
+    // The outlook graphics are regenerated with the feed when there is no outlook item
+    if (outlook_pub_date) {
+        *outlook_pub_date = ctx->outlook_pub_date ? ctx->outlook_pub_date : ctx->channel_pub_date;
     }
     
-    *count = ctx.url_count;
+    *count = ctx->url_count;
     
     // If no URLs found, clean up and return NULL
-    if (ctx.url_count == 0) {
-        free(ctx.all_urls);
+    if (ctx->url_count == 0) {
+        free(ctx->all_urls);
+        free(ctx->pub_dates);
         return NULL;
     }
     
     // Shrink array to actual size to save memory
-    if (ctx.url_count < ctx.url_capacity) {
-        char **resized = realloc(ctx.all_urls, ctx.url_count * sizeof(char *));
+    if (ctx->url_count < ctx->url_capacity) {
+        char **resized = realloc(ctx->all_urls, ctx->url_count * sizeof(char *));
         if (resized) {
-            ctx.all_urls = resized;
+            ctx->all_urls = resized;
         }
     }
+    if (pub_dates) {
+        *pub_dates = ctx->pub_dates;  // Caller must free
+    } else {
+        free(ctx->pub_dates);
+    }
     
-    return ctx.all_urls;  // Caller must free with xml_parse_free_urls
+    return ctx->all_urls;  // Caller must free with xml_parse_free_urls
+}
+
+char **xml_parse_cone_images(const char *buf, size_t len, int *count, time_t **pub_dates, time_t *outlook_pub_date) {
+    ctx_t ctx;
+    *count = 0;
+    if (pub_dates) {
+        *pub_dates = NULL;
+    }
+    if (outlook_pub_date) {
+        *outlook_pub_date = 0;
+    }
+    if (!cone_parser_init(&ctx, pub_dates != NULL)) {
+        return NULL;
+    }
+
+    // Feed the whole buffer at once
+    TRACE_BEGIN("xml_parse");
+    PERF_PROBE_BEGIN(probe);
+    enum XML_Status status = XML_Parse(ctx.parser, buf, (int)len, 1);
+    PERF_PROBE_END(PERF_PROBE_XML_PARSE, probe);
+    TRACE_END("xml_parse");
+    if (status != XML_STATUS_OK) {
+        fprintf(stderr, "Parse error: %s\n",
+                XML_ErrorString(XML_GetErrorCode(ctx.parser)));
+    }
+    return cone_parser_finish(&ctx, status == XML_STATUS_OK, count, pub_dates, outlook_pub_date);
+}
+
+struct xml_stream {
+    ctx_t ctx;
+    bool failed;
+};
+
+xml_stream_t *xml_stream_begin(void) {
+    xml_stream_t *stream = calloc(1, sizeof(xml_stream_t));
+    if (stream && !cone_parser_init(&stream->ctx, true)) {
+        free(stream);
+        return NULL;
+    }
+    return stream;
+}
+
+bool xml_stream_feed(xml_stream_t *stream, const char *buf, size_t len, bool final) {
+    if (stream->failed) {
+        return false;
+    }
+    PERF_PROBE_BEGIN(probe);
+    enum XML_Status status = XML_Parse(stream->ctx.parser, buf, (int)len, final);
+    PERF_PROBE_END(PERF_PROBE_XML_PARSE, probe);
+    if (status != XML_STATUS_OK) {
+        fprintf(stderr, "Parse error: %s\n",
+                XML_ErrorString(XML_GetErrorCode(stream->ctx.parser)));
+        stream->failed = true;
+    }
+    return !stream->failed;
+}
+
+char **xml_stream_end(xml_stream_t *stream, int *count, time_t **pub_dates, time_t *outlook_pub_date) {
+    *count = 0;
+    if (pub_dates) {
+        *pub_dates = NULL;
+    }
+    if (outlook_pub_date) {
+        *outlook_pub_date = 0;
+    }
+    char **urls = cone_parser_finish(&stream->ctx, !stream->failed, count, pub_dates, outlook_pub_date);
+    free(stream);
+    return urls;
+}
+
+char **xml_parse_all_cone_image_urls(const char *buf, size_t len, int *count) {
+    return xml_parse_cone_images(buf, len, count, NULL, NULL);
 }
 
 void xml_parse_free_urls(char **urls, int count) {
@@ -0,0 +1,75 @@
+#!/usr/bin/env python3
+"""Format raw deferred log records (CONFIG_DEFERRED_LOG_RAW) on the host.
+
+Reads a device console from stdin or the files given, replaces every
+"BL <time> <id> <a0> <a1> <a2> <a3>" line with the message it encodes and
+passes other lines through unchanged (<time> is in ms since boot):
+
+    idf.py monitor | tools/binlog/binlog_decode.py
+"""
+
+import os
+import re
+import sys
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..")
+MSGS = os.path.join(ROOT, "main", "include", "binlog_msgs.h")
+CONFIG = os.path.join(ROOT, "main", "include", "app_config.h")
+
+ENTRY = re.compile(r'X\((\w+),\s*(\w+),\s*(\w+|"[^"]*"),\s*"((?:[^"\\]|\\.)*)"\)')
+CONV = re.compile(r"%([-+ 0#]*\d*)l?([duxc%])")
+RECORD = re.compile(r"^BL ([0-9a-f]{8}) (\d+) ([0-9a-f]+) ([0-9a-f]+) ([0-9a-f]+) ([0-9a-f]+)\s*$")
+LEVELS = {"ERROR": "E", "WARN": "W", "INFO": "I", "DEBUG": "D", "VERBOSE": "V"}
+
+
+def load_messages():
+    with open(CONFIG) as f:
+        app_name = re.search(r'#define APP_NAME "([^"]*)"', f.read()).group(1)
+    with open(MSGS) as f:
+        entries = ENTRY.findall(f.read())
+    messages = []
+    for _, level, tag, fmt in entries:
+        tag = app_name if tag == "APP_NAME" else tag.strip('"')
+        messages.append((LEVELS[level], tag, fmt))
+    return messages
+
+
+def format_message(fmt, args):
+    args = iter(args)
+
+    def conv(m):
+        flags, kind = m.groups()
+        if kind == "%":
+            return "%"
+        value = next(args)
+        if kind == "d" and value & 0x80000000:
+            value -= 1 << 32
+        if kind == "c":
+            return chr(value & 0xFF)
+        return ("%" + flags + kind) % value
+
+    return CONV.sub(conv, fmt)
+
+
+def main():
+    messages = load_messages()
+    files = [open(p) for p in sys.argv[1:]] or [sys.stdin]
+    for f in files:
+        for line in f:
+            m = RECORD.match(line.strip())
+            if not m:
+                sys.stdout.write(line)
+                continue
+            ts = int(m.group(1), 16)
+            msg = int(m.group(2))
+            args = [int(a, 16) for a in m.groups()[2:]]
+            if msg >= len(messages):
+                print("? (%d) binlog: unknown message %d" % (ts, msg))
+                continue
+            level, tag, fmt = messages[msg]
+            print("%s (%d) %s: %s" % (level, ts, tag, format_message(fmt, args)))
+            sys.stdout.flush()
+
+
+if __name__ == "__main__":
+    main()
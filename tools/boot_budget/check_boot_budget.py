@@ -0,0 +1,79 @@
+#!/usr/bin/env python3
+"""Hold boot-time budgets against the device's BOOT_METRICS lines.
+
+Collects every "BOOT_METRICS boot=N reason=R phase=ms ..." line from the
+console logs given (or stdin), takes the median of each phase over all
+boots found, and compares it with budget.json next to this script (or
+--budget FILE). Prints one row per phase and exits with status 1 if any
+phase is over budget or missing, so it can gate a hardware-in-the-loop run:
+
+    idf.py monitor | tee boot.log          # power-cycle a few times
+    tools/boot_budget/check_boot_budget.py boot.log
+"""
+
+import argparse
+import json
+import os
+import re
+import statistics
+import sys
+
+METRICS = re.compile(r"BOOT_METRICS((?: \w+=-?\d+)+)")
+# Order in which the firmware reaches them
+PHASES = ["nvs", "lcd", "touch", "lvgl", "wifi", "time_sync", "feed",
+          "first_valid", "first_pixel", "first_shown"]
+
+
+def parse(lines):
+    boots = []
+    for line in lines:
+        m = METRICS.search(line)
+        if m:
+            fields = dict(kv.split("=") for kv in m.group(1).split())
+            boots.append({k: int(v) for k, v in fields.items()})
+    return boots
+
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("logs", nargs="*", help="console logs (default: stdin)")
+    ap.add_argument("--budget", default=os.path.join(here, "budget.json"))
+    ap.add_argument("--allow-missing", action="append", default=[], metavar="PHASE",
+                    help="phase that may be absent, e.g. touch on PIR builds")
+    args = ap.parse_args()
+
+    with open(args.budget) as f:
+        budget = {k: v for k, v in json.load(f).items() if not k.startswith("_")}
+
+    lines = []
+    for path in args.logs or ["-"]:
+        with (sys.stdin if path == "-" else open(path, errors="replace")) as f:
+            lines.extend(f)
+    boots = parse(lines)
+    if not boots:
+        print("No BOOT_METRICS lines found")
+        return 1
+
+    failed = False
+    print("%d boot(s)" % len(boots))
+    print("%-12s %8s %8s %8s  %s" % ("phase", "median", "max", "budget", "result"))
+    for phase in PHASES:
+        samples = [b[phase] for b in boots if phase in b]
+        limit = budget.get(phase)
+        if not samples:
+            ok = phase in args.allow_missing or limit is None
+            print("%-12s %8s %8s %8s  %s" % (phase, "-", "-", limit if limit is not None else "-",
+                                             "skipped" if ok else "MISSING"))
+            failed |= not ok
+            continue
+        median = int(statistics.median(samples))
+        ok = limit is None or median <= limit
+        print("%-12s %8d %8d %8s  %s" % (phase, median, max(samples),
+                                         limit if limit is not None else "-", "ok" if ok else "OVER"))
+        failed |= not ok
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,369 @@
+// Host-side codec comparison for recorded NHC imagery.
+//
+// Reads a corpus laid out by fetch_corpus.sh (one directory per image, one
+// file per format as returned by the conversion API), decodes every file to
+// RGB565 and prints the same table as the on-device benchmark
+// (main/codec_bench.c): encoded size, decode time and bytes touched per
+// decode (encoded bytes read plus RGB565 bytes written).
+//
+// The repo's RLE (main/image_rle.c) is compiled in directly. LZ4 and JPEG
+// decoding need liblz4 / libjpeg and are enabled by the Makefile when found.
+
+#include "image_rle.h"
+#include <dirent.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#ifdef HAVE_LZ4
+#include <lz4.h>
+#endif
+#ifdef HAVE_JPEG
+#include <jpeglib.h>
+#endif
+
+#define HEADER_SIZE 12
+#define LVGL_MAGIC 0x19
+#define CF_RGB565 0x12
+#define CF_I4 0x09
+#define CF_I8 0x0A
+#define FLAG_COMPRESSED 0x0008
+#define COMPRESS_RLE 1
+#define COMPRESS_LZ4 2
+#define DECODE_REPEATS 20
+
+typedef enum {
+    DERIVED_NONE,
+    DERIVED_RLE,
+    DERIVED_LZ4,
+} derived_t;
+
+typedef struct {
+    const char *name;
+    const char *file;       // File in the image directory, NULL for derived formats
+    derived_t derived;      // Encoded here from rgb565_dither.bin
+} format_t;
+
+static const format_t s_formats[] = {
+    { "RGB565",        "rgb565.bin",        DERIVED_NONE },
+    { "RGB565 dither", "rgb565_dither.bin", DERIVED_NONE },
+    { "I8",            "i8.bin",            DERIVED_NONE },
+    { "I4",            "i4.bin",            DERIVED_NONE },
+    { "RLE (history)", NULL,                DERIVED_RLE },
+    { "LZ4 (raw)",     NULL,                DERIVED_LZ4 },
+    { "LVGL RLE",      "lvgl_rle.bin",      DERIVED_NONE },
+    { "LVGL LZ4",      "lvgl_lz4.bin",      DERIVED_NONE },
+    { "JPEG q50",      "jpeg_q50.jpg",      DERIVED_NONE },
+    { "JPEG q75",      "jpeg_q75.jpg",      DERIVED_NONE },
+    { "JPEG q90",      "jpeg_q90.jpg",      DERIVED_NONE },
+};
+
+#define FORMAT_COUNT ((int)(sizeof(s_formats) / sizeof(s_formats[0])))
+
+typedef struct {
+    unsigned images;
+    uint64_t encoded_bytes;
+    uint64_t decoded_bytes;
+    double total_us;
+    double max_us;
+    uint64_t touched_bytes;
+} row_t;
+
+static row_t s_rows[FORMAT_COUNT];
+
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static uint8_t *read_file(const char *path, size_t *len)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *buf = size > 0 ? malloc(size) : NULL;
+    if (buf != NULL && fread(buf, 1, size, f) != (size_t)size) {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(f);
+    *len = buf != NULL ? (size_t)size : 0;
+    return buf;
+}
+
+static uint16_t rd16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t rd32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t rgb565(uint32_t r, uint32_t g, uint32_t b)
+{
+    return (uint16_t)(((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3));
+}
+
+// Same expansion as image_codec_expand_indexed(), single-threaded
+static void expand_indexed(const uint8_t *bin, uint16_t *dst)
+{
+    uint8_t cf = bin[1];
+    uint32_t w = rd16(bin + 4);
+    uint32_t h = rd16(bin + 6);
+    uint32_t bpp = cf == CF_I8 ? 8 : 4;
+    uint32_t entries = 1u << bpp;
+    const uint8_t *palette = bin + HEADER_SIZE;
+    const uint8_t *indices = palette + entries * 4;
+    size_t stride = (w * bpp + 7) / 8;
+    uint16_t lut[256];
+
+    for (uint32_t i = 0; i < entries; i++) {
+        const uint8_t *c = palette + i * 4;  // B, G, R, A
+        lut[i] = rgb565(c[2] * c[3] / 255, c[1] * c[3] / 255, c[0] * c[3] / 255);
+    }
+    for (uint32_t y = 0; y < h; y++) {
+        const uint8_t *src = indices + y * stride;
+        uint16_t *row = dst + y * w;
+        for (uint32_t x = 0; x < w; x++) {
+            row[x] = bpp == 8 ? lut[src[x]] : lut[(src[x >> 1] >> ((x & 1) ? 0 : 4)) & 0x0F];
+        }
+    }
+}
+
+#ifdef HAVE_JPEG
+static size_t decode_jpeg(const uint8_t *data, size_t len, uint16_t *dst, size_t dst_pixels)
+{
+    struct jpeg_decompress_struct cinfo;
+    struct jpeg_error_mgr jerr;
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, data, len);
+    jpeg_read_header(&cinfo, TRUE);
+    cinfo.out_color_space = JCS_RGB;
+    jpeg_start_decompress(&cinfo);
+
+    size_t pixels = (size_t)cinfo.output_width * cinfo.output_height;
+    uint8_t *line = malloc(cinfo.output_width * 3);
+    while (pixels <= dst_pixels && cinfo.output_scanline < cinfo.output_height) {
+        uint16_t *row = dst + (size_t)cinfo.output_scanline * cinfo.output_width;
+        jpeg_read_scanlines(&cinfo, &line, 1);
+        for (uint32_t x = 0; x < cinfo.output_width; x++) {
+            row[x] = rgb565(line[x * 3], line[x * 3 + 1], line[x * 3 + 2]);
+        }
+    }
+    free(line);
+    jpeg_abort_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    return pixels <= dst_pixels ? pixels * 2 : 0;
+}
+#endif
+
+// Decode one file into dst; returns decoded bytes, 0 if unsupported.
+// *touched is set to the bytes read and written by the decode.
+static size_t decode_file(const uint8_t *data, size_t len, uint16_t *dst, size_t dst_pixels, size_t *touched)
+{
+    if (len >= 2 && data[0] == 0xFF && data[1] == 0xD8) {
+#ifdef HAVE_JPEG
+        size_t out = decode_jpeg(data, len, dst, dst_pixels);
+        *touched = len + out;
+        return out;
+#else
+        return 0;
+#endif
+    }
+    if (len < HEADER_SIZE || data[0] != LVGL_MAGIC) {
+        return 0;
+    }
+
+    size_t out = (size_t)rd16(data + 4) * rd16(data + 6) * 2;
+    if (out > dst_pixels * 2) {
+        return 0;
+    }
+    if (rd16(data + 2) & FLAG_COMPRESSED) {
+        // lv_image_compressed_t: method, compressed size, decompressed size, data
+        if (len < HEADER_SIZE + 12) {
+            return 0;
+        }
+        uint32_t method = rd32(data + HEADER_SIZE);
+        uint32_t compressed = rd32(data + HEADER_SIZE + 4);
+        const uint8_t *payload = data + HEADER_SIZE + 12;
+        if (HEADER_SIZE + 12 + (size_t)compressed > len) {
+            return 0;
+        }
+        size_t got = 0;
+        if (method == COMPRESS_RLE) {
+            got = rle_decode(payload, compressed, (uint8_t *)dst, out, 2);
+        }
+#ifdef HAVE_LZ4
+        else if (method == COMPRESS_LZ4) {
+            int n = LZ4_decompress_safe((const char *)payload, (char *)dst, (int)compressed, (int)out);
+            got = n > 0 ? (size_t)n : 0;
+        }
+#endif
+        *touched = len + got;
+        return got == out ? out : 0;
+    }
+    if (data[1] == CF_I8 || data[1] == CF_I4) {
+        expand_indexed(data, dst);
+        *touched = len + out;
+        return out;
+    }
+    // RGB565 is displayed in place
+    *touched = 0;
+    return out;
+}
+
+static void add_sample(row_t *row, size_t encoded, size_t decoded, double us, size_t touched)
+{
+    row->images++;
+    row->encoded_bytes += encoded;
+    row->decoded_bytes += decoded;
+    row->total_us += us;
+    if (us > row->max_us) {
+        row->max_us = us;
+    }
+    row->touched_bytes += touched;
+}
+
+static void bench_file(int f, const uint8_t *data, size_t len, uint16_t *dst, size_t dst_pixels)
+{
+    size_t touched = 0;
+    size_t out = 0;
+    double t0 = now_us();
+    for (int r = 0; r < DECODE_REPEATS; r++) {
+        out = decode_file(data, len, dst, dst_pixels, &touched);
+    }
+    double us = (now_us() - t0) / DECODE_REPEATS;
+    if (out > 0) {
+        add_sample(&s_rows[f], len, out, us, touched);
+    }
+}
+
+// Formats encoded here from the dithered RGB565 pixels
+static void bench_derived(int f, const uint8_t *bin, size_t len, uint16_t *dst)
+{
+    const uint8_t *pixels = bin + HEADER_SIZE;
+    size_t pixel_bytes = len - HEADER_SIZE;
+    size_t cap = RLE_MAX_ENCODED_SIZE(pixel_bytes, 2) + 64;
+    uint8_t *enc = malloc(cap);
+    size_t enc_len = 0;
+    size_t out = 0;
+    double t0 = 0;
+
+    if (s_formats[f].derived == DERIVED_RLE) {
+        enc_len = rle_encode(pixels, pixel_bytes, enc, cap, 2);
+        t0 = now_us();
+        for (int r = 0; r < DECODE_REPEATS; r++) {
+            out = rle_decode(enc, enc_len, (uint8_t *)dst, pixel_bytes, 2);
+        }
+    }
+#ifdef HAVE_LZ4
+    else if (s_formats[f].derived == DERIVED_LZ4) {
+        free(enc);
+        cap = LZ4_compressBound((int)pixel_bytes);
+        enc = malloc(cap);
+        enc_len = LZ4_compress_default((const char *)pixels, (char *)enc, (int)pixel_bytes, (int)cap);
+        t0 = now_us();
+        for (int r = 0; r < DECODE_REPEATS; r++) {
+            int n = LZ4_decompress_safe((const char *)enc, (char *)dst, (int)enc_len, (int)pixel_bytes);
+            out = n > 0 ? (size_t)n : 0;
+        }
+    }
+#endif
+    if (enc_len > 0 && out == pixel_bytes) {
+        double us = (now_us() - t0) / DECODE_REPEATS;
+        add_sample(&s_rows[f], enc_len + HEADER_SIZE, out, us, enc_len + out);
+    }
+    free(enc);
+}
+
+static void print_results(const char *label, unsigned images)
+{
+    printf("Codec benchmark (host), corpus %s, %u images\n\n", label, images);
+    printf("| %-13s | %10s | %6s | %9s | %9s | %12s |\n",
+           "format", "avg bytes", "ratio", "avg ms", "max ms", "bytes/decode");
+    printf("|---------------|------------|--------|-----------|-----------|--------------|\n");
+    for (int f = 0; f < FORMAT_COUNT; f++) {
+        const row_t *r = &s_rows[f];
+        if (r->images == 0) {
+            printf("| %-13s | %10s | %6s | %9s | %9s | %12s |\n", s_formats[f].name, "n/a", "", "", "", "");
+            continue;
+        }
+        printf("| %-13s | %10llu | %6.2f | %9.3f | %9.3f | %12llu |\n", s_formats[f].name,
+               (unsigned long long)(r->encoded_bytes / r->images),
+               (double)r->decoded_bytes / r->encoded_bytes,
+               r->total_us / 1000.0 / r->images, r->max_us / 1000.0,
+               (unsigned long long)(r->touched_bytes / r->images));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <corpus-dir>\n", argv[0]);
+        return 2;
+    }
+
+    DIR *dir = opendir(argv[1]);
+    if (dir == NULL) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    const size_t dst_pixels = 800 * 480;
+    uint16_t *dst = malloc(dst_pixels * 2);
+    unsigned images = 0;
+    struct dirent *ent;
+    char path[1024];
+
+    while ((ent = readdir(dir)) != NULL) {
+        struct stat st;
+        if (ent->d_name[0] == '.') {
+            continue;
+        }
+        snprintf(path, sizeof(path), "%s/%s", argv[1], ent->d_name);
+        if (stat(path, &st) != 0 || !S_ISDIR(st.st_mode)) {
+            continue;
+        }
+        images++;
+
+        for (int f = 0; f < FORMAT_COUNT; f++) {
+            const char *file = s_formats[f].file != NULL ? s_formats[f].file : "rgb565_dither.bin";
+            size_t len = 0;
+            snprintf(path, sizeof(path), "%s/%s/%s", argv[1], ent->d_name, file);
+            uint8_t *data = read_file(path, &len);
+            if (data == NULL) {
+                continue;
+            }
+            if (s_formats[f].derived != DERIVED_NONE) {
+                if (len > HEADER_SIZE && data[0] == LVGL_MAGIC && data[1] == CF_RGB565 &&
+                    len - HEADER_SIZE <= dst_pixels * 2) {
+                    bench_derived(f, data, len, dst);
+                }
+            } else {
+                bench_file(f, data, len, dst, dst_pixels);
+            }
+            free(data);
+        }
+    }
+    closedir(dir);
+    free(dst);
+
+    if (images == 0) {
+        fprintf(stderr, "no image directories in %s\n", argv[1]);
+        return 1;
+    }
+    print_results(argv[1], images);
+    return 0;
+}
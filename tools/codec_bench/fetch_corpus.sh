@@ -0,0 +1,52 @@
+#!/bin/sh
+# Fetch a codec benchmark corpus from the conversion API.
+#
+# Usage: fetch_corpus.sh <api-url> [out-dir]
+#
+# Requests the two Atlantic outlooks plus every storm graphic (cone, wind
+# probabilities) in the current NHC feed, in each candidate format, using the
+# same crop and size as the firmware. Output: <out-dir>/<image>/<format>.{bin,jpg}. Formats the API
+# rejects are skipped. Re-run during an active storm to record cone imagery.
+
+set -u
+
+API=${1:?usage: fetch_corpus.sh <api-url> [out-dir]}
+OUT=${2:-corpus}
+FEED=https://www.nhc.noaa.gov/index-at.xml
+MAX_SIZE=800x420
+
+OUTLOOK_CROP='"crop": {"top": 65, "bottom": 70}'
+CONE_CROP='"crop": {"top": 50, "bottom": 40, "left": 7, "right": 7}'
+
+fetch() {
+    url=$1 crop=$2 dir=$3 name=$4 encoding=$5
+    body="{\"url\": \"$url\", $encoding, \"maxSize\": \"$MAX_SIZE\", $crop}"
+    if ! curl -sf -X POST -H 'Content-Type: application/json' -d "$body" -o "$dir/$name" "$API"; then
+        echo "  $name: not available" >&2
+        rm -f "$dir/$name"
+    fi
+}
+
+fetch_all() {
+    url=$1 crop=$2
+    dir=$OUT/$(basename "$url" .png)
+    mkdir -p "$dir"
+    echo "$url -> $dir" >&2
+    fetch "$url" "$crop" "$dir" rgb565.bin        '"cf": "RGB565", "output": "bin", "bigEndian": false'
+    fetch "$url" "$crop" "$dir" rgb565_dither.bin '"cf": "RGB565", "dither": "true", "output": "bin", "bigEndian": false'
+    fetch "$url" "$crop" "$dir" i8.bin            '"cf": "I8", "dither": "true", "output": "bin"'
+    fetch "$url" "$crop" "$dir" i4.bin            '"cf": "I4", "dither": "true", "output": "bin"'
+    fetch "$url" "$crop" "$dir" lvgl_rle.bin      '"cf": "RGB565", "dither": "true", "output": "bin", "compress": "RLE"'
+    fetch "$url" "$crop" "$dir" lvgl_lz4.bin      '"cf": "RGB565", "dither": "true", "output": "bin", "compress": "LZ4"'
+    for q in 50 75 90; do
+        fetch "$url" "$crop" "$dir" "jpeg_q$q.jpg" "\"output\": \"jpg\", \"quality\": $q"
+    done
+}
+
+fetch_all https://www.nhc.noaa.gov/xgtwo/two_atl_7d0.png "$OUTLOOK_CROP"
+fetch_all https://www.nhc.noaa.gov/xgtwo/two_atl_2d0.png "$OUTLOOK_CROP"
+
+curl -sf "$FEED" | grep -o 'https://www\.nhc\.noaa\.gov/storm_graphics/[A-Za-z0-9_/]*\.png' | sort -u |
+while read -r cone; do
+    fetch_all "$cone" "$CONE_CROP"
+done
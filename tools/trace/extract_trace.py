@@ -0,0 +1,52 @@
+#!/usr/bin/env python3
+"""Save traces printed by CONFIG_TRACE_DUMP_EACH_CYCLE from a console log.
+
+Reads a device console from stdin or the files given, passes it through to
+stdout and writes each block between "=== TRACE BEGIN ===" and
+"=== TRACE END ===" to trace-<n>.json (Chrome trace event format), ready for
+chrome://tracing or ui.perfetto.dev:
+
+    idf.py monitor | tools/trace/extract_trace.py
+"""
+
+import json
+import re
+import sys
+
+BEGIN = "=== TRACE BEGIN ==="
+END = "=== TRACE END ==="
+ANSI = re.compile(r"\x1b\[[0-9;]*m")
+
+
+def main():
+    files = [open(p) for p in sys.argv[1:]] or [sys.stdin]
+    count = 0
+    block = None
+    for f in files:
+        for line in f:
+            sys.stdout.write(line)
+            text = ANSI.sub("", line).strip()
+            if text == BEGIN:
+                block = []
+            elif text == END and block is not None:
+                count += 1
+                path = "trace-%d.json" % count
+                data = "".join(block)
+                try:
+                    events = len(json.loads(data)["traceEvents"])
+                except ValueError as e:
+                    sys.stderr.write("%s: damaged trace (%s), saved as-is\n" % (path, e))
+                    events = None
+                with open(path, "w") as out:
+                    out.write(data)
+                if events is not None:
+                    sys.stderr.write("%s: %d events\n" % (path, events))
+                block = None
+            elif block is not None and text[:1] in ("{", "]"):
+                # Log lines from other tasks can land inside the block; JSON lines
+                # always start with one of these
+                block.append(text + "\n")
+
+
+if __name__ == "__main__":
+    main()